@@ -16,6 +16,8 @@
 
 #include <cstring>
 
+#include "core/DataArray.h"
+
 using namespace std;
 
 WebSocket::WebSocket() {
@@ -147,7 +149,8 @@ string WebSocket::answerHandshake()
 
 		//printf("DIGEST:"); for(int i=0; i<20; i++) printf("%02x ",digest[i]); printf("\n");
 
-		accept_key = base64_encode((const unsigned char *)digest, 20); //160bit = 20 bytes/chars
+		AsyncFw::DataArray _key = AsyncFw::DataArray::toBase64(AsyncFw::DataArrayView(static_cast<const uint8_t *>(digest), sizeof(digest))); //160bit = 20 bytes/chars
+		accept_key.assign(_key.begin(), _key.end());
 
 		answer += "Sec-WebSocket-Accept: "+(accept_key)+"\r\n";
 	}
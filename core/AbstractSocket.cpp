@@ -8,17 +8,26 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #include <fcntl.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
 
 #include "DataArray.h"
+#include "DataChain.h"
 #include "Thread.h"
 #include "LogStream.h"
 
 #ifndef _WIN32
   #include <sys/socket.h>
   #include <sys/ioctl.h>
+  #include <sys/sendfile.h>
+  #include <sys/stat.h>
+  #include <sys/uio.h>
+  #include <sys/un.h>
   #include <arpa/inet.h>
-  #include <netinet/tcp.h>
+  #include <linux/tcp.h>
+  #include <linux/errqueue.h>
+  #include <linux/net_tstamp.h>
   #include <linux/sockios.h>
   #include <unistd.h>
 
@@ -50,30 +59,300 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #endif
 #include "extend_trace.hpp"
 
-#define SOCKET_CONNECTION_QUEUED 16
 //#define SOCKET_REUSEPORT
 
+#ifndef SOCKET_MAX_RECEIVE_DESCRIPTORS
+  #define SOCKET_MAX_RECEIVE_DESCRIPTORS 4
+#endif
+
+#ifndef SOCKET_ADAPTIVE_INTERVAL
+  #define SOCKET_ADAPTIVE_INTERVAL 1000
+#endif
+
 using namespace AsyncFw;
 
+namespace {
+std::atomic<int64_t> budgetLimit = 0;
+std::atomic<int64_t> budgetUsage = 0;
+std::atomic<int> budgetSockets = 0;
+
+socklen_t socketAddress(const std::string &address, uint16_t port, sockaddr_storage *result) {
+  memset(result, 0, sizeof(sockaddr_storage));
+#ifndef _WIN32
+  if (AbstractSocket::isUnixAddress(address)) {
+    sockaddr_un *_a = reinterpret_cast<sockaddr_un *>(result);
+    if (address.size() >= sizeof(_a->sun_path)) return 0;
+    _a->sun_family = AF_UNIX;
+    memcpy(_a->sun_path, address.data(), address.size());
+    if (address[0] != '@') return offsetof(sockaddr_un, sun_path) + address.size() + 1;
+    _a->sun_path[0] = '\0';  // abstract namespace, the name is not null-terminated
+    return offsetof(sockaddr_un, sun_path) + address.size();
+  }
+#endif
+  if (address.find(':') != std::string::npos) {
+    sockaddr_in6 *_a = reinterpret_cast<sockaddr_in6 *>(result);
+    _a->sin6_family = AF_INET6;
+    _a->sin6_port = htons(port);
+    return (inet_pton(AF_INET6, address.c_str(), &_a->sin6_addr) == 1) ? sizeof(sockaddr_in6) : 0;
+  }
+  sockaddr_in *_a = reinterpret_cast<sockaddr_in *>(result);
+  _a->sin_family = AF_INET;
+  _a->sin_port = htons(port);
+  _a->sin_addr.s_addr = inet_addr(address.c_str());
+  return sizeof(sockaddr_in);
+}
+
+void setOption(int fd, int level, int name, int value, const char *text) {
+  if (setsockopt(fd, level, name, setsockopt_ptr(&value), sizeof value) < 0) lsError() << "set" << text << value << errno;
+}
+
+void applyOptions(int fd, const SocketOptions &o, bool tcp) {
+  if (o.sendBufferSize > 0) setOption(fd, SOL_SOCKET, SO_SNDBUF, o.sendBufferSize, "SO_SNDBUF");
+  if (o.receiveBufferSize > 0) setOption(fd, SOL_SOCKET, SO_RCVBUF, o.receiveBufferSize, "SO_RCVBUF");
+  if (!tcp) return;
+  if (o.noDelay >= 0) setOption(fd, IPPROTO_TCP, TCP_NODELAY, o.noDelay, "TCP_NODELAY");
+  if (o.keepAliveIdle > 0) {
+    setOption(fd, SOL_SOCKET, SO_KEEPALIVE, 1, "SO_KEEPALIVE");
+#ifdef TCP_KEEPIDLE
+    setOption(fd, IPPROTO_TCP, TCP_KEEPIDLE, o.keepAliveIdle, "TCP_KEEPIDLE");
+    if (o.keepAliveInterval > 0) setOption(fd, IPPROTO_TCP, TCP_KEEPINTVL, o.keepAliveInterval, "TCP_KEEPINTVL");
+    if (o.keepAliveCount > 0) setOption(fd, IPPROTO_TCP, TCP_KEEPCNT, o.keepAliveCount, "TCP_KEEPCNT");
+#endif
+  }
+#ifndef _WIN32
+  if (o.cork >= 0) setOption(fd, IPPROTO_TCP, TCP_CORK, o.cork, "TCP_CORK");
+  if (o.notSentLowat > 0) setOption(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, o.notSentLowat, "TCP_NOTSENT_LOWAT");
+  if (o.userTimeout > 0) setOption(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, o.userTimeout, "TCP_USER_TIMEOUT");
+#endif
+}
+}  // namespace
+
 struct AbstractSocket::Private {
+  struct Adaptive {
+    std::chrono::steady_clock::time_point time;
+    uint64_t received;
+    uint64_t acked;
+    int rcvbuf;
+    int sndbuf;
+    int limit;
+    int timer = -1;
+  };
+  struct Pacing {
+    uint64_t rate = 0;                 // rate of setPacingRate()
+    bool kernel = false;               // the rate is applied with SO_MAX_PACING_RATE
+    std::unique_ptr<RateLimit> limit;  // token bucket of the rate if the kernel does not pace the socket
+    std::shared_ptr<RateLimit> shared;
+    int timer = -1;  // waiting for tokens, PollOut is not watched
+    int acquire(int);
+    void release(int);
+    int delay(int) const;
+  };
+  ~Private() {
+    delete options;
+    delete adaptive;
+    delete tcpInfo;
+    delete pacing;
+  }
+  void startAdaptive(AbstractSocket *, int);
+  void stopAdaptive(AbstractSocket *);
+  void adaptiveTimer(AbstractSocket *, bool);
+  void adapt(AbstractSocket *);
+  void timestamping(int) const;
+  void startPacing(int);
+  void throttle(AbstractSocket *, int);
+  void stopThrottle(AbstractSocket *);
+  void invokeWriteEvent(AbstractSocket *);
+  void buffer(AbstractSocket *, const uint8_t *, std::size_t);
   sockaddr_storage la = {};
   sockaddr_storage pa = {};
   DataArray rda;
   DataArray wda;
-  Error error = None;
   std::string errorString;
   int type;
   int protocol;
   int rs = 0;
+  uint32_t idle = 0;     // low bits of rxBytes + txBytes at the last idle check of the thread
+  std::vector<int> rfd;  // descriptors received with SCM_RIGHTS and not yet taken by readDescriptor()
+  SocketOptions *options = nullptr;
+  Adaptive *adaptive = nullptr;  // adaptive buffer sizing state, exists while connected with SocketOptions::adaptive
+  TcpInfo *tcpInfo = nullptr;    // last TCP_INFO sample, allocated by the first sampleTcpInfo()
+  uint64_t rxTime = 0;           // kernel arrival time of the data of the last receive, nanoseconds of CLOCK_REALTIME
+  Pacing *pacing = nullptr;      // transmit rate limits, exists after setPacingRate() or setRateLimit()
+  uint64_t rxBytes = 0;
+  uint64_t txBytes = 0;
+  std::atomic<int64_t> accounted = 0;  // bytes accounted in the BufferBudget
+  Error error = None;
+  uint8_t pause = 0;                   // reasons of paused reading: 0x01 — setReadPaused(), 0x02 — BufferBudget
+  bool fileWait = false;               // sendFile() sent less than requested, waiting for PollOut
+  void account(Thread *, int64_t);
+  AbstractThread::PollEvents events() const { return static_cast<AbstractThread::PollEvents>(((flags & 0x08) ? AbstractThread::PollNo : AbstractThread::PollIn) | ((((flags & 0x80) || fileWait) && !(pacing && pacing->timer >= 0)) ? AbstractThread::PollOut : AbstractThread::PollNo)); }
 
   // 0x01 — OutputBufferMode::Application (application-level data, requires processing before sending)
   // 0x02 — OutputBufferMode::Network (network bytes ready to send)
+  // 0x04 — TCP Fast Open on connect()
+  // 0x08 — reading paused: PollIn is not watched, unread data stays in the kernel buffer
+  // 0x10 — kernel receive timestamps (SO_TIMESTAMPING) enabled
   // 0x20 — protection against repeated calls to AbstractSocket::read_available_fd() (cached rs_ is used)
   // 0x40 — a writeEvent() task is already scheduled
   // 0x80 — there is data in the write buffer wda_, waiting for PollOut event
   uint8_t flags;
 };
 
+void AbstractSocket::Private::buffer(AbstractSocket *socket, const uint8_t *data, std::size_t size) {  // the data waits in the write buffer for PollOut
+  if (!(flags & 0x80)) {
+    flags |= 0x80;
+    socket->thread_->modifyPollDescriptor(socket->fd_, events());
+  }
+  wda.insert(wda.end(), data, data + size);
+}
+
+void AbstractSocket::Private::invokeWriteEvent(AbstractSocket *socket) {
+  if (flags & 0x40) return;
+  flags |= 0x40;
+  AbstractThread::AbstractTask *_t = new Invocable<void()>::Function([socket, _thread = socket->thread_] {
+    if (socket->thread_ != _thread) return;  // moved to another thread, which runs its own task
+    trace() << LogStream::Color::DarkGreen << "write event task";
+    socket->private_.flags &= ~0x40;
+    if (!(socket->private_.flags & 0x80)) socket->writeEvent();
+    else lsDebug() << LogStream::Color::Red << "(private_.flags & 0x80)";
+  });
+  if (!socket->thread_->invokeTask(_t)) {
+    lsError() << "thread not running";
+    flags &= ~0x40;
+    delete _t;
+  }
+}
+
+void AbstractSocket::Private::account(Thread *thread, int64_t size) {
+  const int64_t _o = accounted.exchange(size);
+  if (size == _o) return;
+  budgetUsage += size - _o;
+  if (!_o) ++budgetSockets;
+  else if (!size) --budgetSockets;
+  if (thread) thread->bufferUsage_ += size - _o;
+}
+
+void AbstractSocket::Private::startAdaptive(AbstractSocket *socket, int fd) {
+  stopAdaptive(socket);
+#ifndef _WIN32
+  // setting a buffer size disables the kernel autotuning of the buffer, it is replaced only up to an explicit limit
+  if (!options || !options->adaptive || options->adaptiveLimit <= 0 || (la.ss_family != AF_INET && la.ss_family != AF_INET6)) return;
+  adaptive = new Adaptive {std::chrono::steady_clock::now(), 0, 0, 0, 0, options->adaptiveLimit};
+  socklen_t _l = sizeof(int);
+  getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &adaptive->rcvbuf, &_l);
+  _l = sizeof(int);
+  getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &adaptive->sndbuf, &_l);
+  // the kernel reports the doubled value it reserves for bookkeeping
+  adaptive->rcvbuf /= 2;
+  adaptive->sndbuf /= 2;
+  adaptiveTimer(socket, true);
+#else
+  (void)fd;
+#endif
+}
+
+void AbstractSocket::Private::stopAdaptive(AbstractSocket *socket) {
+  if (!adaptive) return;
+  adaptiveTimer(socket, false);
+  delete adaptive;
+  adaptive = nullptr;
+}
+
+void AbstractSocket::Private::adaptiveTimer(AbstractSocket *socket, bool start) {
+  if (!adaptive || !socket->thread_ || start == (adaptive->timer >= 0)) return;
+  if (start) adaptive->timer = socket->thread_->appendTimerTask(SOCKET_ADAPTIVE_INTERVAL, [socket]() { socket->private_.adapt(socket); });
+  else {
+    socket->thread_->removeTimer(adaptive->timer);
+    adaptive->timer = -1;
+  }
+}
+
+void AbstractSocket::Private::adapt(AbstractSocket *socket) {
+#ifndef _WIN32
+  const int fd = socket->fd_;
+  const std::chrono::steady_clock::time_point _t = std::chrono::steady_clock::now();
+  const int64_t _ms = std::chrono::duration_cast<std::chrono::milliseconds>(_t - adaptive->time).count();
+  if (_ms <= 0 || fd < 0) return;
+  tcp_info _i;
+  socklen_t _l = sizeof _i;
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &_i, &_l) < 0 || _l < offsetof(tcp_info, tcpi_bytes_received) + sizeof(_i.tcpi_bytes_received)) {
+    lsDebug() << "adaptive buffers not supported" << fd;
+    stopAdaptive(socket);
+    return;
+  }
+  const uint64_t _rtt = std::max(_i.tcpi_rtt, _i.tcpi_rcv_rtt);  // microseconds
+  const uint64_t _rx = (_i.tcpi_bytes_received - adaptive->received) * 1000 / _ms;
+  const uint64_t _tx = (_i.tcpi_bytes_acked - adaptive->acked) * 1000 / _ms;
+  adaptive->time = _t;
+  adaptive->received = _i.tcpi_bytes_received;
+  adaptive->acked = _i.tcpi_bytes_acked;
+  // twice the bandwidth-delay product keeps the window open while the application drains the buffer
+  const auto _grow = [fd, this](int name, int &size, uint64_t bdp) {
+    const uint64_t _s = std::min<uint64_t>(bdp * 2, adaptive->limit);
+    if (_s <= static_cast<uint64_t>(size)) return;
+    size = static_cast<int>(std::max<uint64_t>(_s, std::min<uint64_t>(static_cast<uint64_t>(size) * 2, adaptive->limit)));
+    setOption(fd, SOL_SOCKET, name, size, (name == SO_RCVBUF) ? "SO_RCVBUF" : "SO_SNDBUF");
+    lsDebug() << LogStream::Color::Cyan << fd << ((name == SO_RCVBUF) ? "SO_RCVBUF" : "SO_SNDBUF") << size;
+  };
+  if (adaptive->received) _grow(SO_RCVBUF, adaptive->rcvbuf, _rx * _rtt / 1000000);
+  if (adaptive->acked) _grow(SO_SNDBUF, adaptive->sndbuf, _tx * _rtt / 1000000);
+#endif
+}
+
+void AbstractSocket::Private::timestamping(int fd) const {
+#ifndef _WIN32
+  const int _f = (flags & 0x10) ? SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE : 0;
+  if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &_f, sizeof _f) < 0) lsError() << "set SO_TIMESTAMPING" << fd << errno;
+#endif
+}
+
+int AbstractSocket::Private::Pacing::acquire(int size) {
+  int _s = (limit) ? limit->acquire(size) : size;
+  if (!shared || _s <= 0) return _s;
+  const int _g = shared->acquire(_s);
+  if (limit && _g < _s) limit->release(_s - _g);
+  return _g;
+}
+
+void AbstractSocket::Private::Pacing::release(int size) {
+  if (limit) limit->release(size);
+  if (shared) shared->release(size);
+}
+
+int AbstractSocket::Private::Pacing::delay(int size) const { return std::max((limit) ? limit->delay(size) : 1, (shared) ? shared->delay(size) : 1); }
+
+void AbstractSocket::Private::startPacing(int fd) {
+  pacing->limit.reset();
+#ifdef SO_MAX_PACING_RATE
+  if (type == SOCK_STREAM && (pa.ss_family == AF_INET || pa.ss_family == AF_INET6) && (pacing->rate || pacing->kernel)) {
+    const unsigned int _r = (pacing->rate) ? static_cast<unsigned int>(std::min<uint64_t>(pacing->rate, std::numeric_limits<unsigned int>::max())) : std::numeric_limits<unsigned int>::max();
+    pacing->kernel = !setsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &_r, sizeof _r) && pacing->rate;
+    if (pacing->kernel || !pacing->rate) return;
+    lsDebug() << "SO_MAX_PACING_RATE not supported" << fd << errno;
+  }
+#else
+  (void)fd;
+#endif
+  if (pacing->rate) pacing->limit = std::make_unique<RateLimit>(pacing->rate);
+}
+
+void AbstractSocket::Private::throttle(AbstractSocket *socket, int size) {
+  if (pacing->timer >= 0) return;
+  pacing->timer = socket->thread_->appendTimerTask(pacing->delay(size), [socket]() {
+    Private &_p = socket->private_;
+    socket->thread_->removeTimer(_p.pacing->timer);
+    _p.pacing->timer = -1;
+    if (socket->fd_ >= 0) socket->thread_->modifyPollDescriptor(socket->fd_, _p.events());
+  });
+  if (flags & 0x80) socket->thread_->modifyPollDescriptor(socket->fd_, events());
+}
+
+void AbstractSocket::Private::stopThrottle(AbstractSocket *socket) {
+  if (!pacing || pacing->timer < 0) return;
+  socket->thread_->removeTimer(pacing->timer);
+  pacing->timer = -1;
+}
+
 AbstractSocket::AbstractSocket(OutputBufferMode mode) : AbstractSocket(AF_INET, SOCK_STREAM, IPPROTO_TCP, mode) {}
 
 AbstractSocket::AbstractSocket(int family, int type, int protocol, OutputBufferMode mode) : private_(*new Private) {
@@ -97,13 +376,24 @@ AbstractSocket::~AbstractSocket() {
       removeFromThread();
     }
   }
+  if (thread_) {
+    private_.stopThrottle(this);
+    private_.stopAdaptive(this);
+  }
+  private_.account(thread_, 0);
   if (fd_ >= 0) close_fd(fd_);
+  for (int _fd : private_.rfd) close_fd(_fd);
   delete &private_;
   lsTrace();
 }
 
-bool AbstractSocket::listen(const std::string &address, uint16_t port) {
-  int _fd = socket(private_.la.ss_family, private_.type, private_.protocol);
+bool AbstractSocket::listen(const std::string &address, uint16_t port, int backlog) {
+  const socklen_t _al = socketAddress(address, port, &private_.la);
+  if (!_al) {
+    lsError() << "invalid address:" << address;
+    return false;
+  }
+  int _fd = socket(private_.la.ss_family, private_.type, (private_.la.ss_family == AF_INET || private_.la.ss_family == AF_INET6) ? private_.protocol : 0);
   if (_fd < 0) {
     lsError() << "socket descriptor error" << _fd << errno;
     return false;
@@ -115,15 +405,30 @@ bool AbstractSocket::listen(const std::string &address, uint16_t port) {
   u_long _nb = 1;
   ioctlsocket(_fd, FIONBIO, &_nb);
 #endif
-  int _val = 1;
-  if (setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, setsockopt_ptr(&_val), sizeof _val) < 0) lsError("set SO_REUSEADDR");
+#ifndef _WIN32
+  if (private_.la.ss_family == AF_UNIX) {
+    struct stat _st;
+    // a stale socket file left by a previous process makes bind() fail, it is removed unless a live server still accepts on it; the probe uses the listener type so a SOCK_SEQPACKET peer answers ECONNREFUSED rather than EPROTOTYPE
+    if (address[0] == '/' && !stat(address.c_str(), &_st) && S_ISSOCK(_st.st_mode)) {
+      const int _p = socket(AF_UNIX, private_.type, 0);
+      if (_p >= 0) {
+        if (::connect(_p, reinterpret_cast<struct sockaddr *>(&private_.la), _al) && errno == ECONNREFUSED) unlink(address.c_str());
+        ::close(_p);
+      }
+    }
+  } else
+#endif
+  {
+    int _val = 1;
+    if (setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, setsockopt_ptr(&_val), sizeof _val) < 0) lsError("set SO_REUSEADDR");
 #if defined(SOCKET_REUSEPORT) && !defined(_WIN32)
-  if (setsockopt(_fd, SOL_SOCKET, SO_REUSEPORT, &_val, sizeof _val) < 0) lsError("set SO_REUSEPORT");
+    if (setsockopt(_fd, SOL_SOCKET, SO_REUSEPORT, &_val, sizeof _val) < 0) lsError("set SO_REUSEPORT");
 #endif
-  reinterpret_cast<sockaddr_in *>(&private_.la)->sin_port = htons(port);
-  reinterpret_cast<sockaddr_in *>(&private_.la)->sin_addr.s_addr = inet_addr(address.c_str());
+  }
+  if (private_.options) applyOptions(_fd, *private_.options, false);
+  bindEvent(_fd);
 
-  if (::bind(_fd, reinterpret_cast<struct sockaddr *>(&private_.la), sizeof(private_.la)) || ::listen(_fd, SOCKET_CONNECTION_QUEUED)) {
+  if (::bind(_fd, reinterpret_cast<struct sockaddr *>(&private_.la), _al) || ::listen(_fd, backlog)) {
     close_fd(_fd);
     lsError() << "listen error:" << port;
     return false;
@@ -132,7 +437,8 @@ bool AbstractSocket::listen(const std::string &address, uint16_t port) {
   private_.error = None;
   private_.errorString.clear();
   state_ = State::Listening;
-  thread_->invoke([this, _fd]() { changeDescriptor(_fd); });
+  if (std::this_thread::get_id() == thread_->id()) changeDescriptor(_fd);
+  else thread_->invoke([this, _fd]() { changeDescriptor(_fd); });
   thread_->appendPollTask(_fd, AbstractThread::PollIn, [this](AbstractThread::PollEvents _e) { pollEvent(_e); });
   stateEvent();
   return true;
@@ -180,29 +486,24 @@ void AbstractSocket::setDescriptor(int _fd) {
   checkCurrentThread();
 #ifndef _WIN32
   const int _f = fcntl(_fd, F_GETFL, 0);
-  fcntl(_fd, F_SETFL, _f | O_NONBLOCK);
+  if (!(_f & O_NONBLOCK)) fcntl(_fd, F_SETFL, _f | O_NONBLOCK);
 #else
   u_long _nb = 1;
   ioctlsocket(_fd, FIONBIO, &_nb);
 #endif
   socklen_t _l;
-  /*
-  int _val = 1;
-  if (setsockopt(_fd, SOL_TCP, TCP_NODELAY, &_val, sizeof _val) < 0) lsError("set TCP_NODELAY");
-  _val = 8192;  //!!! need test
-  if (setsockopt(_fd, SOL_SOCKET, SO_SNDBUF, &_val, sizeof _val) < 0) lsError("set SO_SNDBUF");
-  _val = 16384;
-  if (setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &_val, sizeof _val) < 0) lsError("set SO_RCVBUF");
-  _l = sizeof _val;
-  if (getsockopt(_fd, SOL_SOCKET, SO_SNDBUF, &_val, &_l) < 0) lsError("SO_SNDBUF");
-  else { lsDebug() << "SO_SNDBUF" << LogStream::Color::Red << _val; }
-  if (getsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &_val, &_l) < 0) lsError("SO_RCVBUF");
-  else { lsDebug() << "SO_RCVBUF" << LogStream::Color::Red << _val; }
-*/
+  private_.la = {};
+  private_.pa = {};
   _l = sizeof(private_.la);
   if (getsockname(_fd, reinterpret_cast<struct sockaddr *>(&private_.la), &_l) < 0) lsError() << "error socket address";
   _l = sizeof(private_.pa);
   if (getpeername(_fd, reinterpret_cast<struct sockaddr *>(&private_.pa), &_l) < 0) lsError() << "error peer address";
+  if (private_.options) {
+    applyOptions(_fd, *private_.options, private_.la.ss_family == AF_INET || private_.la.ss_family == AF_INET6);
+    private_.startAdaptive(this, _fd);
+  }
+  if (private_.flags & 0x10) private_.timestamping(_fd);
+  if (private_.pacing) private_.startPacing(_fd);
 
   lsTrace() << _fd << LogStream::Color::DarkGreen << "local:" << address() + ':' + std::to_string(port()) << "peer:" << peerAddress() + ':' + std::to_string(peerPort());
 
@@ -213,7 +514,12 @@ void AbstractSocket::setDescriptor(int _fd) {
 }
 
 bool AbstractSocket::connect(const std::string &_address, uint16_t _port) {
-  int _fd = socket(private_.pa.ss_family, private_.type, private_.protocol);
+  const socklen_t _al = socketAddress(_address, _port, &private_.pa);
+  if (!_al) {
+    lsError() << "invalid address:" << _address;
+    return false;
+  }
+  int _fd = socket(private_.pa.ss_family, private_.type, (private_.pa.ss_family == AF_INET || private_.pa.ss_family == AF_INET6) ? private_.protocol : 0);
   if (_fd < 0) {
     lsError() << "socket descriptor error";
     return false;
@@ -226,32 +532,27 @@ bool AbstractSocket::connect(const std::string &_address, uint16_t _port) {
   ioctlsocket(_fd, FIONBIO, &_nb);
 #endif
   socklen_t _l;
-  /*
-  int _val = 1;
-  if (setsockopt(_fd, SOL_TCP, TCP_NODELAY, &_val, sizeof _val) < 0) lsError("set TCP_NODELAY");
-  _val = 8192;  //!!! need test
-  if (setsockopt(_fd, SOL_SOCKET, SO_SNDBUF, &_val, sizeof _val) < 0) lsError("set SO_SNDBUF");
-  _val = 16384;
-  if (setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &_val, sizeof _val) < 0) lsError("set SO_RCVBUF");
-  _l = sizeof _val;
-  if (getsockopt(_fd, SOL_SOCKET, SO_SNDBUF, &_val, &_l) < 0) lsError("SO_SNDBUF");
-  else { lsDebug() << "SO_SNDBUF" << LogStream::Color::Red << _val; }
-  if (getsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &_val, &_l) < 0) lsError("SO_RCVBUF");
-  else { lsDebug() << "SO_RCVBUF" << LogStream::Color::Red << _val; }
-*/
-  reinterpret_cast<sockaddr_in *>(&private_.pa)->sin_port = htons(_port);
-  reinterpret_cast<sockaddr_in *>(&private_.pa)->sin_addr.s_addr = inet_addr(_address.c_str());
-
-  if (::connect(_fd, reinterpret_cast<struct sockaddr *>(&private_.pa), sizeof(private_.pa)) < 0) {
-    if (errno != EINPROGRESS) {
+  if (private_.options) applyOptions(_fd, *private_.options, private_.pa.ss_family == AF_INET || private_.pa.ss_family == AF_INET6);
+  if (private_.flags & 0x10) private_.timestamping(_fd);
+  if (private_.pacing) private_.startPacing(_fd);
+#ifdef TCP_FASTOPEN_CONNECT
+  if ((private_.flags & 0x04) && private_.pa.ss_family != AF_UNIX) {
+    int _val = 1;
+    if (setsockopt(_fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &_val, sizeof _val) < 0) lsError("set TCP_FASTOPEN_CONNECT");
+  }
+#endif
+  if (::connect(_fd, reinterpret_cast<struct sockaddr *>(&private_.pa), _al) < 0) {
+    if (errno != EINPROGRESS && errno != EAGAIN) {
       lsError() << "connect error" << _address + ':' + std::to_string(_port) << _fd << errno;
       close_fd(_fd);
       return false;
     }
   }
 
+  private_.la = {};
   _l = sizeof(private_.la);
   if (getsockname(_fd, reinterpret_cast<struct sockaddr *>(&private_.la), &_l) < 0) lsError() << "error socket address";
+  if (private_.options) private_.startAdaptive(this, _fd);
 
   lsTrace() << _fd << LogStream::Color::DarkGreen << "local:" << address() + ':' + std::to_string(port()) << "peer:" << peerAddress() + ':' + std::to_string(peerPort());
 
@@ -314,6 +615,7 @@ int AbstractSocket::read(uint8_t *data, int size) {
     memcpy(data, private_.rda.data(), (b) ? size : private_.rda.size());
     if (b) {
       private_.rda.erase(private_.rda.begin(), private_.rda.begin() + size);
+      private_.rxBytes += size;
       return size;
     }
   } else _s = 0;
@@ -327,6 +629,7 @@ int AbstractSocket::read(uint8_t *data, int size) {
     private_.flags &= ~0x20;
   } while (_s < size);
   private_.rda.clear();
+  private_.rxBytes += _s;
   return _s;
 }
 
@@ -339,6 +642,7 @@ DataArray AbstractSocket::read(int size) {
       private_.rda.clear();
     }
     if (private_.rs > 0) read_fd(_da);
+    private_.rxBytes += _da.size();
     return _da;
   }
   int _n = private_.rs + private_.rda.size();
@@ -349,11 +653,113 @@ DataArray AbstractSocket::read(int size) {
 
 int AbstractSocket::write(const uint8_t *data, int size) {
   warning_if(size <= 0) << LogStream::Color::Red << "size for write is null";
-  return write_fd(data, size);
+  const int r = write_fd(data, size);
+  if (r > 0) private_.txBytes += r;
+  if (private_.flags & 0x80) updateBudget();
+  return r;
 }
 
 int AbstractSocket::write(const DataArray &_da) { return write(_da.data(), _da.size()); }
 
+int AbstractSocket::write(const DataChain &c) {
+  warning_if(c.empty()) << LogStream::Color::Red << "size for write is null";
+  int r = 0;
+  std::size_t i = 0, _o = 0;  // the rest starts at byte _o of segment i
+#ifndef _WIN32
+  if (c.segmentCount() > 1 && private_.wda.empty() && !private_.pacing) {
+    iovec _v[SOCKET_WRITEV_SEGMENTS];
+    int _w;
+    do {  // batches of SOCKET_WRITEV_SEGMENTS while the kernel takes them whole
+      const int _n = c.toIovec(_v, SOCKET_WRITEV_SEGMENTS, i);
+      std::size_t _s = 0;
+      for (int k = 0; k != _n; ++k) _s += _v[k].iov_len;
+      if ((_w = writev_fd(_v, _n)) < 0) break;
+      r += _w;
+      i += _n;
+      if (static_cast<std::size_t>(_w) == _s) continue;
+      for (i -= _n, _o = _w; _o >= c.segment(i).size(); ++i) _o -= c.segment(i).size();
+      break;
+    } while (i != c.segmentCount());
+    if (_w >= 0) {
+      if (i == c.segmentCount()) private_.invokeWriteEvent(this);
+      else {  // the kernel buffer is full, the rest waits in the write buffer
+        for (; i != c.segmentCount(); ++i, _o = 0) {
+          const DataArrayView _s = c.segment(i);
+          private_.buffer(this, reinterpret_cast<const uint8_t *>(_s.data()) + _o, _s.size() - _o);
+          r += _s.size() - _o;
+        }
+      }
+    }
+  }
+#endif
+  // otherwise small segments are gathered into one write (one TLS record), large ones are written as they are
+  uint8_t _b[SOCKET_WRITE_GATHER_SIZE];
+  std::size_t _g = 0;
+  int _w = 1;
+  DataArrayView _f, _s;  // on failure: the data of the failed write, the rest of segment i not in it
+  auto _flush = [this, &r, &_g, &_w, &_f](const void *data, std::size_t size) {
+    _w = write_fd(data, size);
+    _g = 0;
+    if (_w <= 0) {
+      _f = DataArrayView(static_cast<const uint8_t *>(data), size);
+      return false;
+    }
+    r += _w;
+    return true;
+  };
+  for (; i != c.segmentCount(); ++i) {
+    _s = c.segment(i);
+    if (_g && _g + _s.size() > sizeof(_b)) {  // fill the buffer up, a small header goes with the head of a large segment
+      const std::size_t _n = sizeof(_b) - _g;
+      std::memcpy(_b + _g, _s.data(), _n);
+      _s.remove_prefix(_n);
+      if (!_flush(_b, sizeof(_b))) break;
+      if (_s.empty()) continue;
+    }
+    if (!_g && (_s.size() >= sizeof(_b) || i + 1 == c.segmentCount())) {
+      if (_flush(_s.data(), _s.size())) continue;
+      _s = {};
+      break;
+    }
+    std::memcpy(_b + _g, _s.data(), _s.size());
+    _g += _s.size();
+  }
+  if (_g && !_flush(_b, _g)) _s = {};
+  if (_w <= 0) {
+    // the write buffer of a network layer (TLS) is sent as it is, the rest of the chain can not wait there: the write fails instead of dropping it
+    if (_w < 0 || !(private_.flags & Application)) {
+      if (r > 0) private_.txBytes += r;
+      return -1;
+    }
+    private_.buffer(this, reinterpret_cast<const uint8_t *>(_f.data()), _f.size());
+    if (!_s.empty()) private_.buffer(this, reinterpret_cast<const uint8_t *>(_s.data()), _s.size());
+    r += _f.size() + _s.size();
+    for (++i; i < c.segmentCount(); ++i) {
+      const DataArrayView _v = c.segment(i);
+      private_.buffer(this, reinterpret_cast<const uint8_t *>(_v.data()), _v.size());
+      r += _v.size();
+    }
+  }
+  if (r > 0) private_.txBytes += r;
+  if (private_.flags & 0x80) updateBudget();
+  return (r || c.empty()) ? r : -1;
+}
+
+int AbstractSocket::sendFile(int fd, int64_t offset, int size) {
+  checkCurrentThread();
+  // the userspace rate limits apply in the write path only
+  if (state_ != State::Active || (private_.pacing && (private_.pacing->limit || private_.pacing->shared))) return -1;
+  if (!private_.wda.empty()) return 0;
+  const int r = sendfile_fd(fd, offset, size);
+  if (r < 0) return r;
+  private_.txBytes += r;
+  if (r < size && !private_.fileWait) {
+    private_.fileWait = true;
+    thread_->modifyPollDescriptor(fd_, private_.events());
+  }
+  return r;
+}
+
 void AbstractSocket::close() {
   if (fd_ == -1) return;
   thread_->removePollDescriptor(fd_);
@@ -364,7 +770,15 @@ void AbstractSocket::close() {
   private_.rs = 0;
   private_.rda.clear();
   private_.wda.clear();
-  private_.flags &= ~0x80;
+  for (int _fd : private_.rfd) close_fd(_fd);
+  private_.rfd.clear();
+  private_.flags &= ~(0x80 | 0x08);
+  private_.pause = 0;
+  private_.fileWait = false;
+  private_.rxTime = 0;
+  private_.stopThrottle(this);
+  private_.stopAdaptive(this);
+  updateBudget();
   stateEvent();
 }
 
@@ -379,6 +793,10 @@ void AbstractSocket::setErrorString(const std::string &string) const {
 
 std::string AbstractSocket::errorString() const { return private_.errorString; }
 
+void AbstractSocket::updatePoll() {
+  if (fd_ >= 0) thread_->modifyPollDescriptor(fd_, private_.events());
+}
+
 int AbstractSocket::pendingRead() const {
   checkCurrentThread();
   if (private_.rs >= 0) return private_.rs + private_.rda.size();
@@ -392,40 +810,293 @@ int AbstractSocket::pendingWrite() const {
   return private_.wda.size();
 }
 
-std::string AbstractSocket::address() const {
-  if (private_.la.ss_family == AF_INET) {
-    char _ip[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(&private_.la)->sin_addr, _ip, sizeof _ip);
-    return _ip;
-  }
-  char _ip[INET6_ADDRSTRLEN];
-  inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in6 *>(&private_.la)->sin6_addr, _ip, sizeof _ip);
-  return _ip;
-}
+std::string AbstractSocket::address() const { return addressString(&private_.la); }
 
 uint16_t AbstractSocket::port() const {
   if (private_.la.ss_family == AF_INET) return ntohs(((struct sockaddr_in *)&private_.la)->sin_port);
-  return ntohs(((struct sockaddr_in6 *)&private_.la)->sin6_port);
+  if (private_.la.ss_family == AF_INET6) return ntohs(((struct sockaddr_in6 *)&private_.la)->sin6_port);
+  return 0;
 }
 
-std::string AbstractSocket::peerAddress() const {
-  if (private_.pa.ss_family == AF_INET) {
+std::string AbstractSocket::peerAddress() const { return addressString(&private_.pa); }
+
+uint16_t AbstractSocket::peerPort() const {
+  if (private_.pa.ss_family == AF_INET) return ntohs(((struct sockaddr_in *)&private_.pa)->sin_port);
+  if (private_.pa.ss_family == AF_INET6) return ntohs(((struct sockaddr_in6 *)&private_.pa)->sin6_port);
+  return 0;
+}
+
+std::string AbstractSocket::addressString(const sockaddr_storage *address) {
+#ifndef _WIN32
+  if (address->ss_family == AF_UNIX) {
+    const char *_p = reinterpret_cast<const sockaddr_un *>(address)->sun_path;
+    if (*_p) return std::string(_p, strnlen(_p, sizeof(sockaddr_un::sun_path)));
+    const std::size_t _l = strnlen(_p + 1, sizeof(sockaddr_un::sun_path) - 1);
+    return (_l) ? '@' + std::string(_p + 1, _l) : std::string();
+  }
+#endif
+  if (address->ss_family == AF_INET) {
     char _ip[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(&private_.pa)->sin_addr, _ip, sizeof _ip);
+    inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(address)->sin_addr, _ip, sizeof _ip);
     return _ip;
   }
   char _ip[INET6_ADDRSTRLEN];
-  inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in6 *>(&private_.pa)->sin6_addr, _ip, sizeof _ip);
+  inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6 *>(address)->sin6_addr, _ip, sizeof _ip);
   return _ip;
 }
 
-uint16_t AbstractSocket::peerPort() const {
-  if (private_.pa.ss_family == AF_INET) return ntohs(((struct sockaddr_in *)&private_.pa)->sin_port);
-  return ntohs(((struct sockaddr_in6 *)&private_.pa)->sin6_port);
+void AbstractSocket::setReadPaused(bool b) {
+  checkCurrentThread();
+  pauseRead(0x01, b);
+}
+
+void AbstractSocket::pauseRead(uint8_t reason, bool p) {
+  private_.pause = (p) ? private_.pause | reason : private_.pause & ~reason;
+  const bool b = private_.pause;
+  if (b == static_cast<bool>(private_.flags & 0x08)) return;
+  if (b) private_.flags |= 0x08;
+  else private_.flags &= ~0x08;
+  if (fd_ < 0) return;
+  thread_->modifyPollDescriptor(fd_, private_.events());
+  trace() << LogStream::Color::Cyan << ((b) ? "read paused" : "read resumed") << fd_;
+  if (b || state_ != State::Active) return;
+  readPending();
+}
+
+void AbstractSocket::readPending() {
+  // data already taken from the descriptor does not raise PollIn again
+  AbstractThread::AbstractTask *_t = new Invocable<void()>::Function([this, _thread = thread_] {
+    if (thread_ != _thread || (private_.flags & 0x08) || state_ != State::Active || (private_.rda.empty() && read_pending_fd() <= 0)) return;
+    const int r = read_available_fd();
+    private_.rs = (r > 0) ? r : 0;
+    readEvent();
+  });
+  if (!thread_->invokeTask(_t)) delete _t;
+}
+
+bool AbstractSocket::readPaused() const { return private_.flags & 0x08; }
+
+void AbstractSocket::updateBudget() { private_.account(thread_, static_cast<int64_t>(private_.rda.size()) + private_.wda.size() + bufferedBytes()); }
+
+bool AbstractSocket::overBudget() const {
+  const int64_t _limit = budgetLimit;
+  if (!_limit) return false;
+  const int64_t _a = private_.accounted;
+  if (_a <= SOCKET_BUDGET_MIN_SHARE) return false;
+  const int64_t _u = budgetUsage;
+  return _u >= _limit || (_u >= _limit / 4 * 3 && _a > BufferBudget::share());
+}
+
+void AbstractSocket::pauseForBudget() {
+  if (private_.pause & 0x02) return;
+  trace() << LogStream::Color::Yellow << "buffer budget exceeded" << fd_ << private_.accounted.load() << budgetUsage.load();
+  pauseRead(0x02, true);
+  if (thread_->budgetTimer_ < 0) thread_->budgetTimer_ = thread_->appendTimerTask(SOCKET_BUDGET_INTERVAL, [_thread = thread_]() { _thread->checkBudget(); });
+}
+
+void AbstractSocket::budgetEvent() {
+  if (overBudget()) pauseForBudget();
+}
+
+bool AbstractSocket::checkBudget() {
+  if (!(private_.pause & 0x02)) return false;
+  if (overBudget()) return true;
+  pauseRead(0x02, false);
+  return false;
+}
+
+void AbstractSocket::idleEvent() {
+  if (private_.rda.empty()) private_.rda.shrink_to_fit();
+  if (private_.wda.empty()) private_.wda.shrink_to_fit();
+  if (private_.rfd.empty()) private_.rfd.shrink_to_fit();
+}
+
+void AbstractSocket::checkIdle() {
+  const uint32_t _m = static_cast<uint32_t>(private_.rxBytes + private_.txBytes);
+  if (_m != private_.idle) {
+    private_.idle = _m;
+    return;
+  }
+  if (state_ == State::Active) idleEvent();
+}
+
+int64_t AbstractSocket::bufferUsage() const { return private_.accounted; }
+
+void AbstractSocket::setOptions(const SocketOptions &options) {
+  if (!private_.options) private_.options = new SocketOptions(options);
+  else *private_.options = options;
+  if (fd_ < 0 || state_ == State::Listening) return;
+  checkCurrentThread();
+  applyOptions(fd_, options, private_.la.ss_family == AF_INET || private_.la.ss_family == AF_INET6);
+  private_.startAdaptive(this, fd_);
+}
+
+void AbstractSocket::setFastOpenConnect(bool b) {
+  if (b) private_.flags |= 0x04;
+  else private_.flags &= ~0x04;
+}
+
+bool AbstractSocket::sampleTcpInfo() {
+#ifndef _WIN32
+  if (fd_ < 0 || (state_ != State::Connected && state_ != State::Active) || private_.type != SOCK_STREAM || (private_.la.ss_family != AF_INET && private_.la.ss_family != AF_INET6)) return false;
+  checkCurrentThread();
+  tcp_info _i;
+  socklen_t _l = sizeof _i;
+  if (getsockopt(fd_, IPPROTO_TCP, TCP_INFO, &_i, &_l) < 0) {
+    trace() << LogStream::Color::Red << "TCP_INFO error" << fd_ << errno;
+    return false;
+  }
+  if (!private_.tcpInfo) private_.tcpInfo = new TcpInfo;
+  TcpInfo &_t = *private_.tcpInfo;
+  _t.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  _t.rtt = _i.tcpi_rtt;
+  _t.rttVar = _i.tcpi_rttvar;
+  _t.retransmits = _i.tcpi_total_retrans;
+  _t.cwnd = _i.tcpi_snd_cwnd;
+  _t.unacked = _i.tcpi_unacked;
+  // older kernels return a shorter structure
+  _t.notSent = (_l >= offsetof(tcp_info, tcpi_notsent_bytes) + sizeof(_i.tcpi_notsent_bytes)) ? _i.tcpi_notsent_bytes : 0;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AbstractSocket::setReceiveTimestamps(bool b) {
+  if (b == static_cast<bool>(private_.flags & 0x10)) return;
+  if (b) private_.flags |= 0x10;
+  else private_.flags &= ~0x10;
+  private_.rxTime = 0;
+  if (fd_ < 0 || state_ == State::Listening) return;
+  checkCurrentThread();
+  private_.timestamping(fd_);
+}
+
+uint64_t AbstractSocket::receiveTimestamp() const { return private_.rxTime; }
+
+void AbstractSocket::setPacingRate(uint64_t rate) {
+  if (!private_.pacing) {
+    if (!rate) return;
+    private_.pacing = new Private::Pacing;
+  }
+  private_.pacing->rate = rate;
+  if (fd_ >= 0 && state_ != State::Listening) {
+    checkCurrentThread();
+    private_.startPacing(fd_);
+  }
+  if (rate || private_.pacing->kernel || private_.pacing->shared) return;
+  private_.stopThrottle(this);
+  delete private_.pacing;
+  private_.pacing = nullptr;
+  if (fd_ >= 0 && (private_.flags & 0x80)) thread_->modifyPollDescriptor(fd_, private_.events());
+}
+
+void AbstractSocket::setRateLimit(const std::shared_ptr<RateLimit> &limit) {
+  if (!private_.pacing) {
+    if (!limit) return;
+    private_.pacing = new Private::Pacing;
+  }
+  private_.pacing->shared = limit;
+  if (limit || private_.pacing->rate || private_.pacing->kernel) return;
+  private_.stopThrottle(this);
+  delete private_.pacing;
+  private_.pacing = nullptr;
+  if (fd_ >= 0 && (private_.flags & 0x80)) thread_->modifyPollDescriptor(fd_, private_.events());
+}
+
+TcpInfo AbstractSocket::tcpInfo() const { return (private_.tcpInfo) ? *private_.tcpInfo : TcpInfo(); }
+
+bool AbstractSocket::isUnixAddress(const std::string &address) { return !address.empty() && (address[0] == '/' || address[0] == '@'); }
+
+int AbstractSocket::writeDescriptor(int fd, const uint8_t *data, int size) {
+  checkCurrentThread();
+#ifndef _WIN32
+  if (fd_ < 0 || private_.la.ss_family != AF_UNIX || size <= 0) {
+    lsError() << "not unix domain socket or empty data" << fd_ << size;
+    return -1;
+  }
+  if (!private_.wda.empty()) {
+    trace() << LogStream::Color::Red << "write buffer not empty" << private_.wda.size();
+    return -1;
+  }
+  union {
+    cmsghdr h;
+    uint8_t b[CMSG_SPACE(sizeof(int))];
+  } _c = {};
+  iovec _v = {const_cast<uint8_t *>(data), static_cast<std::size_t>(size)};
+  msghdr _m = {};
+  _m.msg_iov = &_v;
+  _m.msg_iovlen = 1;
+  _m.msg_control = _c.b;
+  _m.msg_controllen = sizeof(_c.b);
+  cmsghdr *_h = CMSG_FIRSTHDR(&_m);
+  _h->cmsg_level = SOL_SOCKET;
+  _h->cmsg_type = SCM_RIGHTS;
+  _h->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(_h), &fd, sizeof(int));
+  int r;
+  do { r = sendmsg(fd_, &_m, MSG_NOSIGNAL); } while (r < 0 && errno == EINTR);
+  if (r < 0) {
+    if (errno != EAGAIN) lsWarning() << LogStream::Color::Red << "send descriptor error" << fd_ << errno;
+    return -1;
+  }
+  // the descriptor went with the first byte, the rest is ordinary data
+  if (r < size) write_fd(data + r, size - r);
+  return size;
+#else
+  lsError() << "not supported";
+  return -1;
+#endif
+}
+
+int AbstractSocket::readDescriptor() {
+  if (private_.rfd.empty()) return -1;
+  int _fd = private_.rfd.front();
+  private_.rfd.erase(private_.rfd.begin());
+  return _fd;
 }
 
 int AbstractSocket::read_fd(void *data, int size) const {
 #ifndef _WIN32
+  const bool _u = private_.la.ss_family == AF_UNIX;
+  if (_u || (private_.flags & 0x10)) {
+    // recvmsg() keeps SCM_RIGHTS descriptors, read() would close them, and returns the receive timestamp with the data; a SOCK_SEQPACKET read returns one packet, so the loop
+    union {
+      cmsghdr h;
+      uint8_t b[CMSG_SPACE(sizeof(int) * SOCKET_MAX_RECEIVE_DESCRIPTORS) + CMSG_SPACE(sizeof(scm_timestamping))];
+    } _c;
+    int _s = 0, r;
+    do {
+      iovec _v = {static_cast<uint8_t *>(data) + _s, static_cast<std::size_t>(size - _s)};
+      msghdr _m = {};
+      _m.msg_iov = &_v;
+      _m.msg_iovlen = 1;
+      _m.msg_control = _c.b;
+      _m.msg_controllen = sizeof(_c.b);
+      r = recvmsg(fd_, &_m, MSG_CMSG_CLOEXEC);
+      if (r <= 0) break;
+      for (cmsghdr *_h = CMSG_FIRSTHDR(&_m); _h; _h = CMSG_NXTHDR(&_m, _h)) {
+        if (_h->cmsg_level != SOL_SOCKET) continue;
+        if (_h->cmsg_type == SCM_TIMESTAMPING) {
+          if (_s) continue;  // the stamp of the oldest data read
+          scm_timestamping _t;
+          memcpy(&_t, CMSG_DATA(_h), sizeof _t);
+          private_.rxTime = static_cast<uint64_t>(_t.ts[0].tv_sec) * 1000000000 + _t.ts[0].tv_nsec;
+          continue;
+        }
+        if (_h->cmsg_type != SCM_RIGHTS) continue;
+        const int _n = (_h->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (int i = 0; i != _n; ++i) {
+          int _fd;
+          memcpy(&_fd, CMSG_DATA(_h) + i * sizeof(int), sizeof(int));
+          private_.rfd.push_back(_fd);
+        }
+      }
+      warning_if(_m.msg_flags & MSG_CTRUNC) << LogStream::Color::Red << "received descriptors truncated";
+      _s += r;
+    } while (_u && _s < size);
+    return (_s) ? _s : r;
+  }
   return ::read(fd_, data, size);
 #else
   return ::recv(fd_, static_cast<char *>(data), size, 0);
@@ -437,38 +1108,51 @@ int AbstractSocket::write_fd(const void *data, int size) {
     private_.wda.insert(private_.wda.end(), static_cast<const char *>(data), static_cast<const char *>(data) + size);
     return size;
   }
+  const int _s = (private_.pacing) ? private_.pacing->acquire(size) : size;
 #ifndef _WIN32
-  int r = ::write(fd_, data, size);
+  int r = (_s > 0) ? ::write(fd_, data, _s) : 0;
 #else
-  int r = ::send(fd_, static_cast<const char *>(data), size, 0);
+  int r = (_s > 0) ? ::send(fd_, static_cast<const char *>(data), _s, 0) : 0;
 #endif
+  if (private_.pacing) {
+    if (r < _s) private_.pacing->release(_s - std::max(r, 0));
+    else if (_s < size) private_.throttle(this, size - _s);  // the kernel would take more, the rate limit holds the rest back
+  }
   if (data != private_.wda.data()) {
     if (r < size) {
       if (!(private_.flags & 0x80)) {
-        thread_->modifyPollDescriptor(fd_, AbstractThread::PollIn | AbstractThread::PollOut);
         private_.flags |= 0x80;
+        thread_->modifyPollDescriptor(fd_, private_.events());
         trace() << LogStream::Color::Cyan << "(AbstractThread::PollIn | AbstractThread::PollOut)";
       }
       private_.wda.insert(private_.wda.end(), static_cast<const char *>(data) + ((r > 0) ? r : 0), static_cast<const char *>(data) + size);
-    } else if (!(private_.flags & 0x40)) {
-      private_.flags |= 0x40;
-      AbstractThread::AbstractTask *_t = new Invocable<void()>::Function([this] {
-        trace() << LogStream::Color::DarkGreen << "write event task";
-        private_.flags &= ~0x40;
-        if (!(private_.flags & 0x80)) writeEvent();
-        else lsDebug() << LogStream::Color::Red << "(private_.flags & 0x80)";
-      });
-      if (!thread_->invokeTask(_t)) {
-        lsError() << "thread not running";
-        private_.flags &= ~0x40;
-        delete _t;
-      }
-    }
+    } else private_.invokeWriteEvent(this);
     r = size;
   }
   return r;
 }
 
+int AbstractSocket::writev_fd(const iovec *iov, int count) {
+#ifndef _WIN32
+  const int r = ::writev(fd_, iov, count);
+  if (r < 0 && errno == EAGAIN) return 0;
+  return r;
+#else
+  return -1;
+#endif
+}
+
+int AbstractSocket::sendfile_fd(int fd, int64_t offset, int size) {
+#ifndef _WIN32
+  off_t _o = offset;
+  const int r = ::sendfile(fd_, fd, &_o, size);
+  if (r < 0 && errno == EAGAIN) return 0;
+  return r;
+#else
+  return -1;
+#endif
+}
+
 void AbstractSocket::destroy() {
   if (state_ == Destroy) {
     lsDebug() << LogStream::Color::Red << "already destroy state";
@@ -491,12 +1175,55 @@ void AbstractSocket::destroy() {
   trace();
 }
 
+bool AbstractSocket::moveToThread(Thread *thread) {
+  checkCurrentThread();
+  if (!thread_ || !thread || thread == thread_ || state_ == Destroy || !thread->running()) return false;
+  Thread *_thread = thread_;
+  moveEvent(false);
+  if (fd_ >= 0) thread_->removePollDescriptor(fd_);
+  const bool _throttled = private_.pacing && private_.pacing->timer >= 0;
+  private_.stopThrottle(this);
+  private_.adaptiveTimer(this, false);
+  trace() << LogStream::Color::Cyan << fd_ << '(' + thread_->name() + ") -> (" + thread->name() + ')';
+  removeFromThread();
+  thread_ = thread;
+  const auto _attach = [this, _throttled]() {
+    thread_->sockets_.insert(std::lower_bound(thread_->sockets_.begin(), thread_->sockets_.end(), this, Thread::Compare()), this);
+    thread_->bufferUsage_ += private_.accounted;
+    if ((private_.pause & 0x02) && thread_->budgetTimer_ < 0) thread_->budgetTimer_ = thread_->appendTimerTask(SOCKET_BUDGET_INTERVAL, [_thread = thread_]() { _thread->checkBudget(); });
+    if (fd_ >= 0) thread_->appendPollTask(fd_, private_.events(), [this](AbstractThread::PollEvents _e) { pollEvent(_e); });
+    if (_throttled) private_.throttle(this, 1);
+    private_.adaptiveTimer(this, true);
+    if (private_.flags & 0x40) {
+      private_.flags &= ~0x40;
+      if (!(private_.flags & 0x80)) writeEvent();
+    }
+    moveEvent(true);
+    // data already taken from the descriptor does not raise PollIn in the new thread
+    if (state_ != State::Active || (private_.flags & 0x08) || (private_.rda.empty() && read_pending_fd() <= 0)) return;
+    const int r = read_available_fd();
+    private_.rs = (r > 0) ? r : 0;
+    readEvent();
+  };
+  if (thread->invoke(_attach)) return true;
+  // the thread has finished meanwhile, the socket stays
+  lsError() << "thread not running" << '(' + thread->name() + ')';
+  thread_ = _thread;
+  _attach();
+  return false;
+}
+
+uint64_t AbstractSocket::bytesReceived() const { return private_.rxBytes; }
+
+uint64_t AbstractSocket::bytesSent() const { return private_.txBytes; }
+
 void AbstractSocket::removeFromThread() {
   checkCurrentThread();
   std::vector<AbstractSocket *>::iterator it = std::lower_bound(thread_->sockets_.begin(), thread_->sockets_.end(), this, Thread::Compare());
   if (it != thread_->sockets_.end() && (*it) == this) {
     thread_->sockets_.erase(it);
   } else lsTrace() << LogStream::Color::DarkRed << "not found" << fd_;
+  thread_->bufferUsage_ -= private_.accounted;
   thread_ = nullptr;
 }
 
@@ -513,13 +1240,18 @@ void AbstractSocket::pollEvent(int _e) {
     close();
     return;
   }
+  if ((_e & AbstractThread::PollIn) && (private_.flags & 0x08)) {
+    // PollIn may be rearmed by a write path (e.g. TLS want write) while reading is paused
+    thread_->modifyPollDescriptor(fd_, private_.events());
+    _e &= ~AbstractThread::PollIn;
+  }
   if (state_ == State::Connecting) {
-    thread_->modifyPollDescriptor(fd_, AbstractThread::PollIn);
+    thread_->modifyPollDescriptor(fd_, private_.events());
     state_ = State::Connected;
     stateEvent();
   }
   if (state_ == State::Connected) {
-    if (_e & AbstractThread::PollOut) thread_->modifyPollDescriptor(fd_, AbstractThread::PollIn);  //!!! тут надо сделать подобно PollOut для writeEvent(), если данные попали в private_.wda (что очень маловероятно), то они должны уйти оттуда через ::write()
+    if (_e & AbstractThread::PollOut) thread_->modifyPollDescriptor(fd_, private_.events());  //!!! тут надо сделать подобно PollOut для writeEvent(), если данные попали в private_.wda (что очень маловероятно), то они должны уйти оттуда через ::write()
     if (_e & AbstractThread::PollIn) {
       if (AbstractSocket::read_available_fd() < 0) {
 #if defined EPOLL_EDGE_TRIGGERED || defined IO_URING_WAIT
@@ -542,7 +1274,7 @@ void AbstractSocket::pollEvent(int _e) {
     private_.rs = read_available_fd();
     if (private_.rs > 0) {
       readEvent();
-      if (private_.rs > 0) {
+      if (private_.rs > 0 && !(private_.flags & 0x08)) {
         lsDebug() << LogStream::Color::Magenta << "read data to rda";
         read_fd(private_.rda);
       }
@@ -562,6 +1294,10 @@ void AbstractSocket::pollEvent(int _e) {
       return;
     }
     warning_if(AbstractSocket::read_available_fd() > 0) << LogStream::Color::Yellow << "socket not empty after read";
+    if (state_ == State::Active) {
+      updateBudget();
+      budgetEvent();
+    }
   }
 #if defined EPOLL_EDGE_TRIGGERED || defined IO_URING_WAIT
   if (_e & 0x2000) {
@@ -572,11 +1308,13 @@ void AbstractSocket::pollEvent(int _e) {
   }
 #endif
   if (_e & AbstractThread::PollOut) {
+    private_.fileWait = false;
     writeEvent();
     if (private_.wda.empty()) {
     WDA_EMPTY:
-      thread_->modifyPollDescriptor(fd_, AbstractThread::PollIn);
       private_.flags &= ~0x80;
+      updateBudget();
+      thread_->modifyPollDescriptor(fd_, private_.events());
       trace() << LogStream::Color::Magenta << "(AbstractThread::PollIn)";
       if (state_ == State::Closing) {
         shutdown(fd_, SHUT_RDWR);
@@ -588,6 +1326,7 @@ void AbstractSocket::pollEvent(int _e) {
     if (r > 0) {
       if (r < static_cast<int>(private_.wda.size())) {
         private_.wda.erase(private_.wda.begin(), private_.wda.begin() + r);
+        updateBudget();
         return;
       }
       private_.wda.clear();
@@ -609,6 +1348,93 @@ void AbstractSocket::pollEvent(int _e) {
 }
 
 namespace AsyncFw {
+void TcpInfoSummary::append(const TcpInfo &info) {
+  if (!info.time) return;
+  rttMin = (sockets) ? std::min(rttMin, info.rtt) : info.rtt;
+  rttMax = std::max(rttMax, info.rtt);
+  rttTotal += info.rtt;
+  retransmits += info.retransmits;
+  unacked += info.unacked;
+  notSent += info.notSent;
+  ++sockets;
+}
+
+void TcpInfoSummary::append(const TcpInfoSummary &summary) {
+  if (!summary.sockets) return;
+  rttMin = (sockets) ? std::min(rttMin, summary.rttMin) : summary.rttMin;
+  rttMax = std::max(rttMax, summary.rttMax);
+  rttTotal += summary.rttTotal;
+  retransmits += summary.retransmits;
+  unacked += summary.unacked;
+  notSent += summary.notSent;
+  sockets += summary.sockets;
+}
+
+RateLimit::RateLimit(uint64_t rate, int burst) { setRate(rate, burst); }
+
+void RateLimit::setRate(uint64_t rate, int burst) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  rate_ = std::max<uint64_t>(rate, 1);
+  burst_ = (burst > 0) ? burst : std::max<int64_t>(rate_ * SOCKET_PACING_BURST_MS / 1000, 1500);
+  tokens_ = burst_;
+  time_ = std::chrono::steady_clock::now();
+}
+
+uint64_t RateLimit::rate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return rate_;
+}
+
+void RateLimit::refill() {
+  const std::chrono::steady_clock::time_point _t = std::chrono::steady_clock::now();
+  const int64_t _us = std::chrono::duration_cast<std::chrono::microseconds>(_t - time_).count();
+  // beyond the time to fill the bucket the product with the rate could overflow
+  if (_us > static_cast<int64_t>((burst_ - std::min(tokens_, burst_)) * 1000000 / rate_)) {
+    tokens_ = burst_;
+    time_ = _t;
+    return;
+  }
+  const int64_t _n = static_cast<int64_t>(rate_ * _us / 1000000);
+  if (_n <= 0) return;
+  tokens_ = std::min(tokens_ + _n, burst_);
+  time_ = _t;
+}
+
+int RateLimit::acquire(int size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  refill();
+  const int _s = static_cast<int>(std::min<int64_t>(size, std::max<int64_t>(tokens_, 0)));
+  tokens_ -= _s;
+  return _s;
+}
+
+void RateLimit::release(int size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tokens_ = std::min(tokens_ + size, burst_);
+}
+
+int RateLimit::delay(int size) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const int64_t _n = std::min<int64_t>(size, burst_) - tokens_;
+  return (_n > 0) ? static_cast<int>(std::max<int64_t>(_n * 1000 / rate_, 1)) : 1;
+}
+
+void BufferBudget::setLimit(int64_t limit) { budgetLimit = (limit > 0) ? limit : 0; }
+
+int64_t BufferBudget::limit() { return budgetLimit; }
+
+int64_t BufferBudget::usage() { return budgetUsage; }
+
+int BufferBudget::sockets() { return budgetSockets; }
+
+int64_t BufferBudget::share() {
+  const int64_t _limit = budgetLimit;
+  if (!_limit) return 0;
+  return std::max<int64_t>(_limit / std::max(budgetSockets.load(), 1), SOCKET_BUDGET_MIN_SHARE);
+}
+
+LogStream &operator<<(LogStream &log, const TcpInfoSummary &s) { return log << "sockets:" << s.sockets << "rtt:" << s.rttMin << '/' << s.rttAverage() << '/' << s.rttMax << "retransmits:" << s.retransmits << "unacked:" << s.unacked << "not sent:" << s.notSent; }
+
 LogStream &operator<<(LogStream &log, const AbstractSocket &s) {
   if (s.thread_) s.thread_->invoke([&log, &s]() { log << '(' + s.thread_->name() + ')' << s.fd_ << static_cast<int>(s.state_) << '-' << s.address() + ':' + std::to_string(s.port()) + '/' + s.peerAddress() + ':' + std::to_string(s.peerPort()); }, true);
   else log << "destroying:" << s.address() + ':' + std::to_string(s.port()) + '/' + s.peerAddress() + ':' + std::to_string(s.peerPort());
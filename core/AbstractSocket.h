@@ -12,13 +12,129 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #include <cstdint>
 #include <string>
 #include <limits>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include "AnyData.h"
 
+#ifndef SOCKET_CONNECTION_QUEUED
+  #define SOCKET_CONNECTION_QUEUED 16
+#endif
+
+#ifndef SOCKET_PACING_BURST_MS
+  #define SOCKET_PACING_BURST_MS 10
+#endif
+
+#ifndef SOCKET_BUDGET_MIN_SHARE
+  #define SOCKET_BUDGET_MIN_SHARE (64 * 1024)
+#endif
+
+#ifndef SOCKET_BUDGET_INTERVAL
+  #define SOCKET_BUDGET_INTERVAL 20
+#endif
+
+#ifndef SOCKET_WRITEV_SEGMENTS
+  #define SOCKET_WRITEV_SEGMENTS 64
+#endif
+
+#ifndef SOCKET_WRITE_GATHER_SIZE
+  #define SOCKET_WRITE_GATHER_SIZE 16384
+#endif
+
+struct sockaddr_storage;
+struct iovec;
+
 namespace AsyncFw {
 class Thread;
 class DataArray;
+class DataChain;
 class LogStream;
 
+/** @struct SocketOptions AbstractSocket.h <AsyncFw/AbstractSocket> @brief Socket tuning profile applied by AbstractSocket::setOptions(). @details Zero or negative values keep the system default. TCP options are ignored for unix domain sockets. */
+struct SocketOptions {
+  int8_t noDelay = -1;        ///< TCP_NODELAY: 1 enables, 0 disables.
+  int8_t cork = -1;           ///< TCP_CORK: 1 enables, 0 disables. Linux only.
+  bool adaptive = false;      ///< Grows the buffers to twice the observed bandwidth-delay product, sampled once a second, up to adaptiveLimit. Linux only.
+  int sendBufferSize = 0;     ///< SO_SNDBUF in bytes. Setting a size disables the kernel autotuning of this buffer.
+  int receiveBufferSize = 0;  ///< SO_RCVBUF in bytes. Setting a size disables the kernel autotuning of this buffer.
+  int keepAliveIdle = 0;      ///< Enables SO_KEEPALIVE: idle seconds before the first probe (TCP_KEEPIDLE).
+  int keepAliveInterval = 0;  ///< Seconds between keep-alive probes (TCP_KEEPINTVL).
+  int keepAliveCount = 0;     ///< Unanswered probes before the connection is dropped (TCP_KEEPCNT).
+  int notSentLowat = 0;       ///< TCP_NOTSENT_LOWAT: the socket is writable only while less unsent data is queued. Linux only.
+  int userTimeout = 0;        ///< TCP_USER_TIMEOUT: milliseconds transmitted data may stay unacknowledged. Linux only.
+  int adaptiveLimit = 0;      ///< Maximum buffer size in adaptive mode. A grown buffer is no longer autotuned by the kernel, so zero leaves the buffers to the kernel.
+};
+
+/** @struct TcpInfo AbstractSocket.h <AsyncFw/AbstractSocket> @brief Kernel state of a TCP connection sampled by AbstractSocket::sampleTcpInfo() (TCP_INFO). */
+struct TcpInfo {
+  uint64_t time = 0;         ///< Sample time in milliseconds of the steady clock, zero if the socket was never sampled.
+  uint32_t rtt = 0;          ///< Smoothed round-trip time in microseconds.
+  uint32_t rttVar = 0;       ///< Round-trip time variation in microseconds.
+  uint32_t retransmits = 0;  ///< Total retransmitted segments.
+  uint32_t cwnd = 0;         ///< Congestion window in segments.
+  uint32_t unacked = 0;      ///< Sent and not yet acknowledged segments.
+  uint32_t notSent = 0;      ///< Bytes in the send buffer not yet sent.
+};
+
+/** @struct TcpInfoSummary AbstractSocket.h <AsyncFw/AbstractSocket> @brief Aggregate of the last TcpInfo samples of a group of sockets. */
+struct TcpInfoSummary {
+  int sockets = 0;           ///< Number of sampled sockets.
+  uint32_t rttMin = 0;       ///< Minimum round-trip time in microseconds.
+  uint32_t rttMax = 0;       ///< Maximum round-trip time in microseconds.
+  uint64_t rttTotal = 0;     ///< Sum of the round-trip times in microseconds.
+  uint64_t retransmits = 0;  ///< Sum of the retransmitted segments.
+  uint64_t unacked = 0;      ///< Sum of the unacknowledged segments.
+  uint64_t notSent = 0;      ///< Sum of the bytes not yet sent.
+  /** @brief Adds a sample, a socket that was never sampled is skipped. @param info Sample. */
+  void append(const TcpInfo &);
+  /** @brief Merges another summary. @param summary Summary. */
+  void append(const TcpInfoSummary &);
+  /** @brief Returns the average round-trip time in microseconds. */
+  uint32_t rttAverage() const { return (sockets) ? static_cast<uint32_t>(rttTotal / sockets) : 0; }
+};
+LogStream &operator<<(LogStream &, const TcpInfoSummary &);
+
+/** @class RateLimit AbstractSocket.h <AsyncFw/AbstractSocket> @brief Token bucket limiting the transmit rate of one or several sockets, see AbstractSocket::setRateLimit(). Thread-safe. */
+class RateLimit {
+public:
+  /** @brief Constructs a limit. @param rate Bytes per second. @param burst Bucket size in bytes, zero holds SOCKET_PACING_BURST_MS of traffic. */
+  RateLimit(uint64_t, int = 0);
+  /** @brief Changes the rate. @param rate Bytes per second. @param burst Bucket size in bytes, zero holds SOCKET_PACING_BURST_MS of traffic. */
+  void setRate(uint64_t, int = 0);
+  /** @brief Returns the rate in bytes per second. */
+  uint64_t rate() const;
+  /** @brief Takes tokens for sending. @param size Bytes to send. @return Bytes allowed to send now, up to size. */
+  int acquire(int);
+  /** @brief Returns tokens that were acquired but not sent. @param size Bytes. */
+  void release(int);
+  /** @brief Returns the time until tokens for the given size are available. @param size Bytes, clamped to the bucket size. @return Milliseconds, at least one. */
+  int delay(int) const;
+
+private:
+  void refill();
+  mutable std::mutex mutex_;
+  uint64_t rate_;
+  int64_t burst_;
+  int64_t tokens_;
+  std::chrono::steady_clock::time_point time_;
+};
+
+/** @class BufferBudget AbstractSocket.h <AsyncFw/AbstractSocket> @brief Process-wide accounting of socket buffer memory with a global cap.
+@details Every socket accounts its unread and unsent buffers, including data buffered by derived classes such as received frames not yet released. With a cap set, a socket holding more than its fair share (the cap divided by the sockets holding buffers, at least SOCKET_BUDGET_MIN_SHARE) stops reading once the total usage reaches three quarters of the cap, and every socket holding more than SOCKET_BUDGET_MIN_SHARE stops reading at the cap. Reading resumes when the usage falls back, the connections are never dropped for it. Thread-safe. */
+class BufferBudget {
+public:
+  /** @brief Sets the global cap. @param limit Bytes, zero disables the enforcement (the accounting is always on). */
+  static void setLimit(int64_t);
+  /** @brief Returns the global cap in bytes, zero if disabled. */
+  static int64_t limit();
+  /** @brief Returns the buffer memory accounted by all sockets in bytes. */
+  static int64_t usage();
+  /** @brief Returns the number of sockets holding buffers. */
+  static int sockets();
+  /** @brief Returns the fair share of one socket in bytes, zero if no cap is set. */
+  static int64_t share();
+};
+
 /** @class AbstractSocket AbstractSocket.h <AsyncFw/AbstractSocket> @brief Abstract base class providing core network socket functionality and OS descriptor abstraction.
 @details AbstractSocket wraps native operating system network handles into a clean C++ interface. It handles non-blocking socket initialization, address binding, option configuration, and integrates directly into the AbstractThread I/O multiplexing event loop (epoll / poll).
 @brief Example: @snippet Socket/main.cpp snippet */
@@ -56,7 +172,7 @@ public:
 
   /** @brief Binds a raw native operating system socket file descriptor to this instance. @param fd Native socket descriptor integer. */
   virtual void setDescriptor(int);
-  /** @brief Initiates an asynchronous connection to a remote host. @param ip Remote target IPv4 or IPv6 address string. @param port Remote target port number. @return True if connection initiation succeeded. */
+  /** @brief Initiates an asynchronous connection to a remote host. @param ip Remote target IPv4 or IPv6 address string, or a unix domain socket path (an address starting with '@' is in the abstract namespace). @param port Remote target port number, ignored for unix domain sockets. @return True if connection initiation succeeded. */
   virtual bool connect(const std::string &, uint16_t);
   /** @brief Disconnects the socket from the remote host gracefully. */
   virtual void disconnect();
@@ -65,11 +181,35 @@ public:
   /** @brief Schedules the socket for deferred asynchronous destruction. */
   virtual void destroy();
 
+  /** @brief Moves the socket to another thread without losing data.
+  @details The descriptor leaves the poll loop of the current thread and is registered in the target thread; unread and unsent buffers, pacing and the state of derived classes (moveEvent()) move with it. Tasks invoked through thread() after the call run in the target thread.
+  @param thread Target thread. @return True if the socket moves, from now on it must not be used from the current thread. @note Call from the socket thread. */
+  bool moveToThread(Thread *);
   /** @brief Synchronously detaches the socket from its execution thread.
   @note Sets socket thread to nullptr. Not thread-safe. */
   void removeFromThread();
-  /** @brief Listen for incoming connections on address and port. @param address Address. @param port Port @return True if success. */
-  bool listen(const std::string &, uint16_t);
+  /** @brief Listen for incoming connections on address and port. @param address Address, or a unix domain socket path (see connect()). @param port Port, ignored for unix domain sockets. @param backlog Maximum length of the queue of pending connections. @return True if success. */
+  bool listen(const std::string &, uint16_t, int = SOCKET_CONNECTION_QUEUED);
+  /** @brief Pauses or resumes reading. @details While paused the descriptor is not watched for incoming data, so unread data stays in the kernel buffer and TCP flow control slows the peer down. Writing is not affected. @param pause Pause reading. */
+  void setReadPaused(bool);
+  /** @brief Returns true if reading is paused by setReadPaused() or by the BufferBudget. */
+  bool readPaused() const;
+  /** @brief Sets the tuning profile. It is applied at once to a connected socket (from the socket thread), and to every descriptor the socket gets later. For a listening socket only the buffer sizes are applied, before bind(), so accepted connections inherit them. @param options Socket options. */
+  void setOptions(const SocketOptions &);
+  /** @brief Samples the kernel state of the connection (TCP_INFO), see tcpInfo(). Thread::setTcpInfoInterval() samples all sockets of a thread periodically. @return True if sampled, i.e. the socket is a connected TCP socket. @note Linux only. Call from the socket thread. */
+  bool sampleTcpInfo();
+  /** @brief Returns the last sample taken by sampleTcpInfo(). @note Call from the socket thread. */
+  TcpInfo tcpInfo() const;
+  /** @brief Enables kernel software receive timestamps (SO_TIMESTAMPING), see receiveTimestamp(). @details The stamps are received with the data (recvmsg() instead of read()), without extra system calls. @param enable Enable timestamps. @note Linux only. Call from the socket thread. */
+  void setReceiveTimestamps(bool);
+  /** @brief Returns the time the data of the last receive from the descriptor arrived in the kernel, in nanoseconds of the system clock (CLOCK_REALTIME), or zero if unknown. @details The difference to the current time is the queueing delay of the data in the socket buffer. */
+  uint64_t receiveTimestamp() const;
+  /** @brief Limits the transmit rate of the socket. @details TCP sockets are paced by the kernel (SO_MAX_PACING_RATE), other sockets, or if the kernel refuses it, by a token bucket in the write path: data beyond the rate waits in the write buffer. @param rate Bytes per second, zero removes the limit. @note Call from the socket thread. */
+  void setPacingRate(uint64_t);
+  /** @brief Shares a transmit rate limit with other sockets, e.g. an aggregate limit of a server. It applies in the write path in addition to setPacingRate(). @param limit Shared limit, nullptr removes it. @note Call from the socket thread. TLS sockets writing through the OpenSSL descriptor BIO are paced by the kernel only, the write path limits do not apply to them. */
+  void setRateLimit(const std::shared_ptr<RateLimit> &);
+  /** @brief Enables TCP Fast Open for the next connect(): the first written data is sent with the SYN. @note Linux only (TCP_FASTOPEN_CONNECT). */
+  void setFastOpenConnect(bool);
   /** @brief Non-destructively inspects the internal unread data buffer without consuming it. @return Reference to a DataArray containing the currently buffered incoming data. */
   DataArray &peek();
   /** @brief Reads incoming data into a raw byte buffer up to a specified maximum size. @param buffer Destination raw byte array pointer. @param maxSize Maximum number of bytes to read into the buffer. @return Number of bytes successfully read, or a negative value on error. */
@@ -80,6 +220,19 @@ public:
   int write(const uint8_t *, int);
   /** @brief Transmits a structural DataArray package out to the network layer. @param data Reference to the DataArray containing the payload to write. @return Number of bytes successfully dispatched to the socket queue, or a negative value on error. */
   int write(const DataArray &);
+  /** @brief Writes the segments of a chain without concatenating them.
+  @details On plain sockets and TLS sockets with kernel TLS send offload the segments go out with one writev() (up to SOCKET_WRITEV_SEGMENTS of them) while the write buffer is empty and no rate limit applies. Otherwise they are gathered into writes of up to SOCKET_WRITE_GATHER_SIZE bytes, which keeps TLS records full. @param chain Segments to write, borrowed memory is not used after the call. @return Number of bytes dispatched, or a negative value on error. */
+  int write(const DataChain &);
+  /** @brief Sends file data straight from the page cache (sendfile()), without copying it through userspace.
+  @details Works on plain sockets and on TLS sockets with kernel TLS send offload. Data written before goes out first: while the write buffer is not empty nothing is sent. When less than the requested size is sent, writeEvent() is called once the socket is writable again.
+  @param fd File descriptor. @param offset File offset. @param size Bytes to send. @return Bytes sent, zero if the socket is not writable now, or -1 if sendfile() is not available for the socket (send the data with write()) or failed. @note Linux only. Call from the socket thread. */
+  int sendFile(int, int64_t, int);
+  /** @brief Returns the number of application bytes read from the socket. @note Call from the socket thread. */
+  uint64_t bytesReceived() const;
+  /** @brief Returns the number of application bytes written to the socket. @note Call from the socket thread. */
+  uint64_t bytesSent() const;
+  /** @brief Returns the buffer memory accounted by the socket in the BufferBudget, in bytes. Thread-safe. */
+  int64_t bufferUsage() const;
   /** @brief Fetches the most recent runtime error category flag assigned to this socket. @return An Error enum value. */
   Error error() const;
   /** @brief Returns a human-readable text string describing the last runtime socket error. @return Error message string. */
@@ -94,6 +247,15 @@ public:
   std::string peerAddress() const;
   /** @brief Return local network port bound to this socket interface. */
   uint16_t peerPort() const;
+  /** @brief Converts a native socket address to its numeric address string, or to the path for a unix domain socket. @param address Pointer to the native address. */
+  static std::string addressString(const sockaddr_storage *);
+  /** @brief Returns true if the address is a unix domain socket path: it starts with '/', or with '@' for the abstract namespace. @param address Address string. */
+  static bool isUnixAddress(const std::string &);
+  /** @brief Passes a descriptor to the peer of a unix domain socket (SCM_RIGHTS), attached to the first byte of the data.
+  @param fd Descriptor to pass, the caller still owns it. @param data Data to write with the descriptor, at least one byte. @param size Data size. @return Data size, or -1 if the descriptor is not sent (not a unix domain socket, the write buffer is not empty or the socket is not writable). @note Plain sockets only: the data is written unencrypted. */
+  int writeDescriptor(int, const uint8_t *, int);
+  /** @brief Takes the oldest descriptor received from the peer of a unix domain socket (SCM_RIGHTS). @details A descriptor becomes available once the data it was attached to is read, e.g. in readEvent() after read(). @return Descriptor owned by the caller, or -1 if there is none. */
+  int readDescriptor();
 
 protected:
   /** @brief Constructs an AbstractSocket with default parameters (AF_INET, SOCK_STREAM, IPPROTO_TCP) and binds it to the current thread context. @param mode The new mode for interpreting the buffer content. */
@@ -116,15 +278,42 @@ protected:
   virtual void writeEvent() {}
   /** @brief Called upon incoming connection. Executed on a server listening socket when a client connects. */
   virtual void incomingEvent() {}
+  /** @brief Called when the socket moves to another thread, see moveToThread(). Derived classes move their timers here. @param arrived False in the old thread before the socket leaves it, true in the new thread after it arrived. */
+  virtual void moveEvent(bool) {}
+  /** @brief Called after a read event to apply the BufferBudget. The default implementation pauses reading while overBudget(), derived classes that must not stop in the middle of a message override it and call pauseForBudget() themselves. */
+  virtual void budgetEvent();
+  /** @brief Called when the socket had no traffic for the idle time of its thread (Thread::setIdleTimeout()), repeated every idle time while it stays idle. The default implementation releases the memory of the empty read and write buffers, derived classes release their own buffers and call it. */
+  virtual void idleEvent();
+  /** @brief Called with a new listening descriptor before it is bound. Derived classes apply their own socket options here. @param fd Native socket descriptor. */
+  virtual void bindEvent(int) {}
 
   /** @brief Low-level system call that checks whether a file descriptor contains data.
   @return Number of raw bytes pending in the OS network buffer queue. */
   virtual int read_available_fd() const;
   /** @brief Low-level native operating system read operation proxying requests directly down to the fd handle. @param data Destination memory allocation chunk pointer. @param size Bounds metric tracking maximum allowed byte read capacity. @return Number of raw bytes read from the descriptor, or error status codes. */
   virtual int read_fd(void *, int) const;
+  /** @brief Returns the number of bytes already taken from the descriptor and buffered by a derived layer (e.g. TLS records), which do not raise a poll event. */
+  virtual int read_pending_fd() const { return 0; }
   /** @brief Low-level native operating system write operation proxying requests directly up to the fd handle. @param data Source memory block holding raw serialization binary data. @param size Size in bytes to write identifying exactly how many bytes to transfer. @return Number of raw bytes written out to the descriptor, or error status codes. */
   virtual int write_fd(const void *, int);
+  /** @brief Low-level sendfile() from a file descriptor to the socket descriptor. @param fd File descriptor. @param offset File offset. @param size Bytes to send. @return Bytes sent, zero if the descriptor would block, or -1 if not supported or failed. */
+  virtual int sendfile_fd(int, int64_t, int);
+  /** @brief Low-level writev() of the descriptors to the socket descriptor. @param iov Descriptors. @param count The number of descriptors. @return Bytes written, zero if the descriptor would block, or -1 if not supported or failed. */
+  virtual int writev_fd(const iovec *, int);
+
+  /** @brief Returns the number of bytes buffered by a derived class, e.g. received frames not yet released. They are accounted in the BufferBudget. */
+  virtual int64_t bufferedBytes() const { return 0; }
 
+  /** @brief Updates the accounting of the socket in the BufferBudget. Derived classes call it when bufferedBytes() changes outside of the read event. */
+  void updateBudget();
+  /** @brief Returns true if the socket holds more buffer memory than the BufferBudget allows. Thread-safe. */
+  bool overBudget() const;
+  /** @brief Pauses reading until overBudget() is false, checked every SOCKET_BUDGET_INTERVAL milliseconds. */
+  void pauseForBudget();
+  /** @brief Schedules readEvent() for data taken from the descriptor before the socket could read it (e.g. read-ahead of a TLS layer, or data received while reading was paused), no PollIn announces it. */
+  void readPending();
+  /** @brief Restores the poll events of the descriptor from the socket state (paused reading, pending output), e.g. after a derived layer changed them. */
+  void updatePoll();
   /** @brief Returns the number of bytes of data pending to be read. */
   int pendingRead() const;
   /** @brief Returns the number of bytes of data pending to be write. */
@@ -145,6 +334,9 @@ private:
   void pollEvent(int);
   void changeDescriptor(int);
   void read_fd(AsyncFw::DataArray &);
+  void pauseRead(uint8_t, bool);
+  bool checkBudget();
+  void checkIdle();
   struct Private;
   Private &private_;
 };
@@ -410,7 +410,7 @@ AbstractThread::~AbstractThread() {
     lsWarning() << LogStream::Color::DarkRed << "poll task list not empty" << private_.poll_tasks.size();
     while (!private_.poll_tasks.empty()) {
       Private::PollTask *_pt = private_.poll_tasks.back();
-      private_.poll_tasks.erase(private_.poll_tasks.end());
+      private_.poll_tasks.pop_back();
       delete _pt;
     }
   }
@@ -606,7 +606,7 @@ void AbstractThread::exec() {
             goto CONTINUE;
           }
         } else {
-          uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(private_.wakeup - now).count();
+          uint64_t ms = std::chrono::ceil<std::chrono::milliseconds>(private_.wakeup - now).count();  // rounded up, a truncated wait would spin through the last millisecond before a timer
 #ifdef POLL_WAIT
           if (!private_.update_pollfd.empty()) {
             for (const struct Private::update_pollfd &pfd : private_.update_pollfd) {
@@ -9,13 +9,15 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #include <openssl/err.h>
 #include <openssl/x509v3.h>
 
+#include <cerrno>
+
 #include "TlsContext.h"
 #include "Thread.h"
 #include "LogStream.h"
 
 #include "AbstractTlsSocket.h"
 
-//#define USE_SSL_BIO_PAIR
+//#define USE_SSL_BIO_PAIR  // SSL works over a BIO calling the AbstractSocket I/O (buffered network output, pacing) instead of the descriptor
 
 using namespace AsyncFw;
 
@@ -25,23 +27,83 @@ using namespace AsyncFw;
 #include "extend_trace.hpp"
 
 struct AbstractTlsSocket::Private {
-  ~Private() {
-    if (ssl) {
-      SSL_free(ssl);
-#ifdef USE_SSL_BIO_PAIR
-      BIO_free(bio);
-#endif
+  struct Handshake {  // shared with the worker thread running a handshake step
+    std::mutex mutex;
+    SSL *ssl;
+    AbstractTlsSocket *socket;
+  };
+  ~Private() { free(); }
+  void free() {
+    if (handshake) {
+      // waits for a step running in the worker thread, the descriptor is closed next
+      std::lock_guard<std::mutex> lock(handshake->mutex);
+      handshake->ssl = nullptr;
+      handshake->socket = nullptr;
     }
+    handshake.reset();
+    offload = false;
+    if (!ssl) return;
+    // without a sent close_notify OpenSSL drops the session from the cache, a completed connection closed by the peer stays resumable
+    if (SSL_is_init_finished(ssl)) SSL_set_shutdown(ssl, SSL_get_shutdown(ssl) | SSL_SENT_SHUTDOWN);
+    SSL_free(ssl);
+    ssl = nullptr;
   }
   TlsContext ctx;
   SSL *ssl = nullptr;
   uint8_t encrypt = 0;  // 0 - noencrypt, 1 - server, 2 - client
+  uint8_t ktls = 0;     // kernel TLS offload installed by OpenSSL: 0x01 - send, 0x02 - receive
+  std::string peer;     // address:port of connect(), the key of the stored client session
+  std::shared_ptr<Handshake> handshake;
+  bool offload = false;  // a handshake step runs in a worker thread
+
+  static void complete(const std::shared_ptr<Handshake> &_h, AbstractThread *_t, int r, int _e) {
+    _t->invoke([_h, _t, r, _e]() {
+      AbstractTlsSocket *_s = _h->socket;
+      if (!_s || !_s->private_.offload) return;
+      if (_s->thread_ != _t) {  // moved to another thread during the step
+        complete(_h, _s->thread_, r, _e);
+        return;
+      }
+      _s->private_.offload = false;
+      _s->updatePoll();
+      _s->handshakeEvent(r, _e);
+      // read ahead may have taken application data sent right after the handshake
+      if (_s->state_ == State::Active && _s->read_pending_fd() > 0) _s->readPending();
+    });
+  }
 #ifdef USE_SSL_BIO_PAIR
-  BIO *bio = nullptr;
-  std::vector<uint8_t> input_buffer;
+  static BIO_METHOD *method();
+  static int bioRead(BIO *, char *, int);
+  static int bioWrite(BIO *, const char *, int);
 #endif
 };
 
+#ifdef USE_SSL_BIO_PAIR
+// no intermediate buffers: OpenSSL reads ahead into its own record buffer, output the descriptor does not take is kept in the network output buffer
+BIO_METHOD *AbstractTlsSocket::Private::method() {
+  static BIO_METHOD *_m = []() {
+    BIO_METHOD *_m = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "AsyncFw socket");
+    BIO_meth_set_read(_m, bioRead);
+    BIO_meth_set_write(_m, bioWrite);
+    BIO_meth_set_ctrl(_m, [](BIO *, int cmd, long, void *) -> long { return cmd == BIO_CTRL_FLUSH; });
+    return _m;
+  }();
+  return _m;
+}
+
+int AbstractTlsSocket::Private::bioRead(BIO *b, char *data, int size) {
+  BIO_clear_retry_flags(b);
+  const int r = static_cast<AbstractTlsSocket *>(BIO_get_data(b))->AbstractSocket::read_fd(data, size);
+  if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) BIO_set_retry_read(b);
+  return r;
+}
+
+int AbstractTlsSocket::Private::bioWrite(BIO *b, const char *data, int size) {
+  BIO_clear_retry_flags(b);
+  return static_cast<AbstractTlsSocket *>(BIO_get_data(b))->AbstractSocket::write_fd(data, size);
+}
+#endif
+
 #ifndef USE_SSL_BIO_PAIR
 AbstractTlsSocket::AbstractTlsSocket() : AbstractSocket(Application), private_(*new Private) { trace() << fd_; }
 #else
@@ -62,6 +124,7 @@ void AbstractTlsSocket::setDescriptor(int fd) {
 bool AbstractTlsSocket::connect(const std::string &address, uint16_t port) {
   if (private_.ctx.opensslCtx()) private_.encrypt = 2;  //client
   else private_.encrypt = 0;
+  private_.peer = address + ':' + std::to_string(port);
   return AbstractSocket::connect(address, port);
 }
 
@@ -71,13 +134,8 @@ void AbstractTlsSocket::disconnect() {
 }
 
 void AbstractTlsSocket::close() {
-  if (private_.ssl) {
-    SSL_free(private_.ssl);
-#ifdef USE_SSL_BIO_PAIR
-    BIO_free(private_.bio);
-#endif
-    private_.ssl = nullptr;
-  }
+  private_.free();
+  private_.ktls = 0;
   AbstractSocket::close();
 }
 
@@ -85,6 +143,18 @@ void AbstractTlsSocket::setContext(const TlsContext &ctx) const { private_.ctx =
 
 bool AbstractTlsSocket::contextEmpty() const { return !private_.ctx.opensslCtx(); }
 
+bool AbstractTlsSocket::sessionReused() const { return private_.ssl && SSL_session_reused(private_.ssl); }
+
+bool AbstractTlsSocket::kernelTlsSend() const { return private_.ktls & 0x01; }
+
+bool AbstractTlsSocket::kernelTlsReceive() const { return private_.ktls & 0x02; }
+
+void AbstractTlsSocket::idleEvent() {
+  // OpenSSL allocates the buffers again on the next read or write, it keeps them while they hold data
+  if (private_.ssl && !private_.offload) SSL_free_buffers(private_.ssl);
+  AbstractSocket::idleEvent();
+}
+
 void AbstractTlsSocket::activateReady() { AbstractSocket::activateEvent(); }
 
 void AbstractTlsSocket::activateEvent() {
@@ -107,48 +177,63 @@ void AbstractTlsSocket::activateEvent() {
     else { SSL_set_verify(private_.ssl, SSL_VERIFY_NONE, nullptr); }
 #ifndef USE_SSL_BIO_PAIR
     SSL_set_fd(private_.ssl, fd_);
+  #if defined SSL_OP_ENABLE_KTLS && !defined OPENSSL_NO_KTLS
+    if (private_.ctx.kernelTls()) SSL_set_options(private_.ssl, SSL_OP_ENABLE_KTLS);
+  #endif
 #else
-    BIO *_bio;
-    BIO_new_bio_pair(&private_.bio, 0, &_bio, 0);
+    BIO *_bio = BIO_new(Private::method());
+    BIO_set_data(_bio, this);
+    BIO_set_init(_bio, 1);
     SSL_set_bio(private_.ssl, _bio, _bio);
 #endif
     SSL_set_read_ahead(private_.ssl, 1);
+    if (private_.ctx.releaseBuffers()) SSL_set_mode(private_.ssl, SSL_MODE_RELEASE_BUFFERS);
+    if (private_.encrypt == 2) {
+      SSL_set_app_data(private_.ssl, &private_.peer);
+      if (SSL_SESSION *_s = private_.ctx.session(private_.peer)) {
+        SSL_set_session(private_.ssl, _s);
+        SSL_SESSION_free(_s);
+      }
+    }
     if (!private_.ctx.verifyName().empty()) {
       lsTrace() << fd_ << "verify name" << LogStream::Color::Green << private_.ctx.verifyName();
       SSL_set_hostflags(private_.ssl, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS);
       if (!SSL_set1_host(private_.ssl, private_.ctx.verifyName().c_str())) lsError();
     }
   }
-#ifdef USE_SSL_BIO_PAIR
-  int _size = AbstractSocket::read_available_fd();
-  if (_size > 0) {
-    int _v = private_.input_buffer.size();
-    private_.input_buffer.resize(_v + _size);
-    if (AbstractSocket::read_fd(private_.input_buffer.data() + _v, _size) != _size) {
-      lsError() << fd_ << "error read";
-      setError(AbstractSocket::Activate);
-      setErrorString("Accept/Connect TLS error");
-      close();
-      return;
+#ifndef USE_SSL_BIO_PAIR
+  if (private_.offload) return;
+  if (AbstractThread *_w = private_.ctx.handshakeThread()) {
+    if (!private_.handshake) {
+      private_.handshake = std::make_shared<Private::Handshake>();
+      private_.handshake->ssl = private_.ssl;
+      private_.handshake->socket = this;
     }
-  }
-  if (!private_.input_buffer.empty()) {
-    _size = BIO_write(private_.bio, private_.input_buffer.data(), private_.input_buffer.size());
-    if (_size > 0) private_.input_buffer.erase(private_.input_buffer.begin(), private_.input_buffer.begin() + _size);
+    private_.offload = true;
+    thread_->modifyPollDescriptor(fd_, AbstractThread::PollNo);
+    if (_w->invoke([_h = private_.handshake, _t = thread_, _server = private_.encrypt == 1]() {
+          int r, _e;
+          {  //lock scope
+            std::lock_guard<std::mutex> lock(_h->mutex);
+            if (!_h->ssl) return;
+            ERR_clear_error();  // the worker serves many sockets, SSL_get_error() must not see errors of another one
+            r = (_server) ? SSL_accept(_h->ssl) : SSL_connect(_h->ssl);
+            _e = (r <= 0) ? SSL_get_error(_h->ssl, r) : SSL_ERROR_NONE;
+          }
+          Private::complete(_h, _t, r, _e);
+        }))
+      return;
+    private_.offload = false;
+    updatePoll();
   }
 #endif
   int r = (private_.encrypt == 1) ? SSL_accept(private_.ssl) : SSL_connect(private_.ssl);
   //SIGPIPE if (private_.encrypt == 1) ::close(fd_); void Thread::startedEvent() disabled it
-#ifdef USE_SSL_BIO_PAIR
-  _size = BIO_ctrl_pending(private_.bio);
-  if (_size > 0) {
-    std::vector<uint8_t> _buf(_size);
-    _size = BIO_read(private_.bio, _buf.data(), _size);
-    if (_size > 0) AbstractSocket::write_fd(_buf.data(), _size);
-  }
-#endif
+  handshakeEvent(r, (r <= 0) ? SSL_get_error(private_.ssl, r) : SSL_ERROR_NONE);
+}
+
+void AbstractTlsSocket::handshakeEvent(int r, int _e) {
   if (r <= 0) {
-    int _e = SSL_get_error(private_.ssl, r);
     if (_e == SSL_ERROR_WANT_READ) {
       lsTrace() << LogStream::Color::Red << "want read";
       return;
@@ -174,17 +259,27 @@ void AbstractTlsSocket::activateEvent() {
   } else std::sprintf(name, "no peer cerificate");
 
   trace() << ((private_.encrypt == 1) ? "server" : "client") << "connected" << LogStream::Color::Green << name;
+#if !defined USE_SSL_BIO_PAIR && defined SSL_OP_ENABLE_KTLS && !defined OPENSSL_NO_KTLS
+  if (private_.ctx.kernelTls()) {
+    // OpenSSL falls back to userspace encryption if the kernel module or the cipher is not supported
+    if (BIO_get_ktls_send(SSL_get_wbio(private_.ssl))) private_.ktls |= 0x01;
+    if (BIO_get_ktls_recv(SSL_get_rbio(private_.ssl))) private_.ktls |= 0x02;
+    lsDebug() << fd_ << "kernel tls send:" << static_cast<bool>(private_.ktls & 0x01) << "receive:" << static_cast<bool>(private_.ktls & 0x02) << SSL_get_cipher_name(private_.ssl);
+  }
+#endif
   activateReady();
 }
 
-#ifndef USE_SSL_BIO_PAIR
 int AbstractTlsSocket::read_available_fd() const {
   if (!private_.encrypt) return AbstractSocket::read_available_fd();
   if (!private_.ssl) {
     lsError() << "(!private_.ssl)";
     return -2;
   }
-  int r = SSL_peek(private_.ssl, nullptr, 0);
+  // the rest of a processed record is sized without SSL_peek()
+  int r = SSL_pending(private_.ssl);
+  if (r > 0) return r;
+  r = SSL_peek(private_.ssl, nullptr, 0);
   if (r < 0) {
     int e = SSL_get_error(private_.ssl, r);
     if (e == SSL_ERROR_WANT_READ) return 0;
@@ -197,45 +292,20 @@ int AbstractTlsSocket::read_available_fd() const {
   r = SSL_pending(private_.ssl);
   return r > 0 ? r : -1;
 }
-#else
-int AbstractTlsSocket::read_available_fd() const {
-  if (!private_.encrypt) { return AbstractSocket::read_available_fd(); }
-  if (!private_.ssl) {
-    lsError() << "(!private_.ssl)";
-    return -2;
-  }
-
-  int r = SSL_peek(private_.ssl, nullptr, 0);
-  if (r < 0) goto READ_FD;
-  r = SSL_pending(private_.ssl);
-  if (r > 0) return r;
-
-READ_FD:
-  int _size = AbstractSocket::read_available_fd();
-  if (_size < 0) return _size;
-  int _v = private_.input_buffer.size();
-  private_.input_buffer.resize(_v + _size);
-  r = AbstractSocket::read_fd(private_.input_buffer.data() + _v, _size);
-  if (r != _size) return -2;
-
-  r = BIO_write(private_.bio, private_.input_buffer.data(), private_.input_buffer.size());
-  if (r > 0) private_.input_buffer.erase(private_.input_buffer.begin(), private_.input_buffer.begin() + r);
-  else return 0;
 
-  SSL_peek(private_.ssl, nullptr, 0);
-  r = SSL_pending(private_.ssl);
-  return r > 0 ? r : -1;
+int AbstractTlsSocket::read_pending_fd() const {
+  if (!private_.encrypt || !private_.ssl) return 0;
+  return SSL_has_pending(private_.ssl);
 }
-#endif
 
 int AbstractTlsSocket::read_fd(void *data, int size) const {
   if (!private_.encrypt) return AbstractSocket::read_fd(data, size);
   return SSL_read(private_.ssl, data, size);
 }
 
-#ifndef USE_SSL_BIO_PAIR
 int AbstractTlsSocket::write_fd(const void *data, int size) {
-  if (!private_.encrypt) return AbstractSocket::write_fd(data, size);
+  // with kernel send offload the records are built by the kernel, plain data goes to the descriptor
+  if (!private_.encrypt || (private_.ktls & 0x01)) return AbstractSocket::write_fd(data, size);
   int r = SSL_write(private_.ssl, data, size);
   if (r <= 0) {
     int e = SSL_get_error(private_.ssl, r);
@@ -248,24 +318,16 @@ int AbstractTlsSocket::write_fd(const void *data, int size) {
   }
   return r;
 }
-#else
-int AbstractTlsSocket::write_fd(const void *data, int size) {
-  if (!private_.encrypt) { return AbstractSocket::write_fd(data, size); }
-  int r = SSL_write(private_.ssl, data, size);
-  if (r <= 0) {
-    int _e = SSL_get_error(private_.ssl, r);
-    if (_e == SSL_ERROR_WANT_READ || _e == SSL_ERROR_WANT_WRITE) return 0;
-    return -1;
-  }
-  int _size = BIO_ctrl_pending(private_.bio);
-  if (_size > 0) {
-    std::vector<uint8_t> _buf(_size);
-    _size = BIO_read(private_.bio, _buf.data(), _size);
-    if (_size > 0) AbstractSocket::write_fd(_buf.data(), _size);
-  }
-  return r;
+
+int AbstractTlsSocket::sendfile_fd(int fd, int64_t offset, int size) {
+  if (!private_.encrypt || (private_.ktls & 0x01)) return AbstractSocket::sendfile_fd(fd, offset, size);
+  return -1;
+}
+
+int AbstractTlsSocket::writev_fd(const iovec *iov, int count) {
+  if (!private_.encrypt || (private_.ktls & 0x01)) return AbstractSocket::writev_fd(iov, count);
+  return -1;
 }
-#endif
 
 namespace AsyncFw {
 LogStream &operator<<(LogStream &log, const AbstractTlsSocket &s) { return (log << *static_cast<const AbstractSocket *>(&s)) << (!s.private_.ctx.empty() ? s.private_.ctx.commonName() + '/' + (!s.private_.ctx.verifyName().empty() ? s.private_.ctx.verifyName() : "\"\"") : "empty"); }
@@ -37,6 +37,12 @@ public:
   void setContext(const TlsContext &) const;
   /** @brief Checks whether the underlying OpenSSL context structure has not been initialized or assigned. @return True if the internal TlsContext is considered empty or invalid. */
   bool contextEmpty() const;
+  /** @brief Checks whether the handshake resumed a previous session (see TlsContext::setSessionCache(), TlsContext::setSessionTickets()) instead of a full handshake. */
+  bool sessionReused() const;
+  /** @brief Checks whether OpenSSL installed kernel TLS send offload for the connection (see TlsContext::setKernelTls()). Application data is then written to the descriptor unencrypted and the kernel builds the records. */
+  bool kernelTlsSend() const;
+  /** @brief Checks whether OpenSSL installed kernel TLS receive offload for the connection: the kernel decrypts the records, SSL_read() takes the plain data. */
+  bool kernelTlsReceive() const;
 
 protected:
   /** @brief Protected default constructor. Allocates the internal private structure and setups context pointers. */
@@ -49,14 +55,23 @@ protected:
   /** @brief Core internal event handler reacting to raw descriptor readiness signals.
   @details Orchestrates the non-blocking state machine for SSL_accept() and SSL_connect() loops. Automatically intercepts peer certificates and flags errors if handshakes timeout or crash. */
   void activateEvent() override;
+  /** @brief Frees the OpenSSL record buffers of the idle connection, then releases the socket buffers. */
+  void idleEvent() override;
   /** @brief Calculates how many unread bytes are currently waiting within the active OpenSSL decrypted layer buffer. @return Byte amount available for reading */
   int read_available_fd() const override final;
+  /** @brief Reports data held by OpenSSL (processed or read-ahead records) that no poll event will announce. @return Non-zero if data is buffered. */
+  int read_pending_fd() const override final;
   /** @brief Low-level decryption routing path proxying requests down to SSL_read(). @param data Void pointer targeting the destination extraction memory chunk. @param size Maximum byte capacity boundaries allowed to extract. @return Number of successfully decrypted bytes ingested, or standard OpenSSL system error codes. */
   int read_fd(void *, int) const override final;
   /** @brief Low-level encryption routing path proxying outgoing payload directly up to SSL_write(). @param data Void pointer targeting the source serialization raw bytes memory buffer. @param size Exact number of bytes to push into the socket layer. @return Number of successfully encrypted and dispatched bytes, or standard OpenSSL system error codes. */
   int write_fd(const void *, int) override final;
+  /** @brief Sends file data with sendfile() when kernel TLS send offload is installed. @return Bytes sent, zero if the descriptor would block, or -1 if the connection encrypts in userspace. */
+  int sendfile_fd(int, int64_t, int) override final;
+  /** @brief Writes the descriptors with writev() when kernel TLS send offload is installed. @return Bytes written, zero if the descriptor would block, or -1 if the connection encrypts in userspace. */
+  int writev_fd(const iovec *, int) override final;
 
 private:
+  void handshakeEvent(int, int);
   struct Private;
   Private &private_;
 };
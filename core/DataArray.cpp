@@ -5,16 +5,497 @@ This file is part of the AsyncFw project. Licensed under the MIT License.
 See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
 */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
 #include <zlib.h>
+#ifdef USE_LZ4
+  #include <lz4.h>
+  #include <lz4hc.h>
+#endif
+#ifdef USE_ZSTD
+  #include <zstd.h>
+  #include <zdict.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+  #include <immintrin.h>
+  #define DATA_ARRAY_SIMD
+#endif
 #include "DataArray.h"
+#include "AbstractThread.h"
 #include "LogStream.h"
 #include "console_msg.hpp"
 
 #define LOG_DATA_ARAY_SIZE_LIMIT 4096
+#define LOG_DATA_ARRAY_HEX_LIMIT 32  // leading bytes of binary data shown in hex
+#define DATA_ARRAY_CODEC_MAGIC 0xF8  // with a second byte other than 0x78 it can not start an array compressed by zlib in the original format
+#define DATA_ARRAY_BLOCKS 0x0F       // second byte of a block container, from the reserved codec ids
+
+#ifndef DATA_ARRAY_MAX_BLOCK_SIZE
+  #define DATA_ARRAY_MAX_BLOCK_SIZE (256 * 1024 * 1024)
+#endif
 
 using namespace AsyncFw;
-DataArray DataArray::compress(const DataArrayView &v) {
+
+namespace {
+inline uint8_t lower(uint8_t c) { return (c >= 'A' && c <= 'Z') ? c | 0x20 : c; }
+
+inline bool equal(const uint8_t *a, const uint8_t *b, std::size_t n, bool icase) {
+  if (!icase) return !std::memcmp(a, b, n);
+  for (std::size_t i = 0; i != n; ++i)
+    if (lower(a[i]) != lower(b[i])) return false;
+  return true;
+}
+
+std::size_t searchScalar(const uint8_t *h, std::size_t n, std::size_t i, const uint8_t *s, std::size_t m, bool icase) {
+  for (; i + m <= n; ++i)
+    if (equal(h + i, s, m, icase)) return i;
+  return std::string_view::npos;
+}
+
+#ifdef DATA_ARRAY_SIMD
+// Candidates are the positions where the first and the last byte of the needle match, compared a vector at a time, then verified.
+// Ignoring case ORs 0x20 into the bytes, which only adds candidates.
+std::size_t searchSse2(const uint8_t *h, std::size_t n, const uint8_t *s, std::size_t m, bool icase) {
+  const uint8_t _fold = (icase) ? 0x20 : 0;
+  const __m128i _f = _mm_set1_epi8(s[0] | _fold), _l = _mm_set1_epi8(s[m - 1] | _fold), _o = _mm_set1_epi8(_fold);
+  std::size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16) {
+    __m128i _a = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i)), _o);
+    __m128i _b = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i + m - 1)), _o);
+    for (unsigned _mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(_a, _f), _mm_cmpeq_epi8(_b, _l))); _mask; _mask &= _mask - 1) {
+      std::size_t k = i + __builtin_ctz(_mask);
+      if (equal(h + k, s, m, icase)) return k;
+    }
+  }
+  return searchScalar(h, n, i, s, m, icase);
+}
+
+__attribute__((target("avx2"))) std::size_t searchAvx2(const uint8_t *h, std::size_t n, const uint8_t *s, std::size_t m, bool icase) {
+  const uint8_t _fold = (icase) ? 0x20 : 0;
+  const __m256i _f = _mm256_set1_epi8(s[0] | _fold), _l = _mm256_set1_epi8(s[m - 1] | _fold), _o = _mm256_set1_epi8(_fold);
+  std::size_t i = 0;
+  for (; i + m - 1 + 32 <= n; i += 32) {
+    __m256i _a = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i)), _o);
+    __m256i _b = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i + m - 1)), _o);
+    for (unsigned _mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(_a, _f), _mm256_cmpeq_epi8(_b, _l))); _mask; _mask &= _mask - 1) {
+      std::size_t k = i + __builtin_ctz(_mask);
+      if (equal(h + k, s, m, icase)) return k;
+    }
+  }
+  std::size_t j = searchSse2(h + i, n - i, s, m, icase);
+  return (j == std::string_view::npos) ? j : i + j;
+}
+
+std::size_t anySse2(const uint8_t *h, std::size_t n, const uint8_t *d, std::size_t m) {
+  __m128i _d[8];
+  for (std::size_t j = 0; j != m; ++j) _d[j] = _mm_set1_epi8(d[j]);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i _a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i)), _r = _mm_cmpeq_epi8(_a, _d[0]);
+    for (std::size_t j = 1; j != m; ++j) _r = _mm_or_si128(_r, _mm_cmpeq_epi8(_a, _d[j]));
+    if (unsigned _mask = _mm_movemask_epi8(_r)) return i + __builtin_ctz(_mask);
+  }
+  for (; i != n; ++i)
+    if (std::memchr(d, h[i], m)) return i;
+  return std::string_view::npos;
+}
+
+__attribute__((target("avx2"))) std::size_t anyAvx2(const uint8_t *h, std::size_t n, const uint8_t *d, std::size_t m) {
+  __m256i _d[8];
+  for (std::size_t j = 0; j != m; ++j) _d[j] = _mm256_set1_epi8(d[j]);
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i _a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i)), _r = _mm256_cmpeq_epi8(_a, _d[0]);
+    for (std::size_t j = 1; j != m; ++j) _r = _mm256_or_si256(_r, _mm256_cmpeq_epi8(_a, _d[j]));
+    if (unsigned _mask = _mm256_movemask_epi8(_r)) return i + __builtin_ctz(_mask);
+  }
+  std::size_t j = anySse2(h + i, n - i, d, m);
+  return (j == std::string_view::npos) ? j : i + j;
+}
+
+bool avx2() {
+  static const bool _avx2 = __builtin_cpu_supports("avx2");
+  return _avx2;
+}
+#endif
+
+const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+const char hexDigits[] = "0123456789abcdef";
+
+constexpr std::array<uint8_t, 256> base64Values = []() {  // 0xFF for bytes outside the alphabet
+  std::array<uint8_t, 256> _a {};
+  _a.fill(0xFF);
+  for (uint8_t i = 0; i != 64; ++i) _a[static_cast<uint8_t>(base64Alphabet[i])] = i;
+  return _a;
+}();
+
+constexpr std::array<uint8_t, 256> hexValues = []() {
+  std::array<uint8_t, 256> _a {};
+  _a.fill(0xFF);
+  for (uint8_t i = 0; i != 10; ++i) _a['0' + i] = i;
+  for (uint8_t i = 0; i != 6; ++i) _a['a' + i] = _a['A' + i] = 10 + i;
+  return _a;
+}();
+
+void base64EncodeScalar(const uint8_t *p, std::size_t n, uint8_t *o) {
+  for (; n >= 3; n -= 3, p += 3, o += 4) {
+    uint32_t _v = (p[0] << 16) | (p[1] << 8) | p[2];
+    o[0] = base64Alphabet[_v >> 18];
+    o[1] = base64Alphabet[(_v >> 12) & 0x3F];
+    o[2] = base64Alphabet[(_v >> 6) & 0x3F];
+    o[3] = base64Alphabet[_v & 0x3F];
+  }
+  if (n) {
+    uint32_t _v = (p[0] << 16) | ((n == 2) ? p[1] << 8 : 0);
+    o[0] = base64Alphabet[_v >> 18];
+    o[1] = base64Alphabet[(_v >> 12) & 0x3F];
+    o[2] = (n == 2) ? base64Alphabet[(_v >> 6) & 0x3F] : '=';
+    o[3] = '=';
+  }
+}
+
+std::size_t base64DecodeScalar(const uint8_t *p, std::size_t n, uint8_t *o) {  // n without padding, returns the decoded size or npos
+  uint8_t *_o = o;
+  for (; n >= 4; n -= 4, p += 4, o += 3) {
+    uint32_t _v = (base64Values[p[0]] << 18) | (base64Values[p[1]] << 12) | (base64Values[p[2]] << 6) | base64Values[p[3]];
+    if ((base64Values[p[0]] | base64Values[p[1]] | base64Values[p[2]] | base64Values[p[3]]) & 0x80) return std::string_view::npos;
+    o[0] = _v >> 16;
+    o[1] = _v >> 8;
+    o[2] = _v;
+  }
+  if (n == 1) return std::string_view::npos;
+  if (n) {
+    uint8_t _a = base64Values[p[0]], _b = base64Values[p[1]], _c = (n == 3) ? base64Values[p[2]] : 0;
+    if ((_a | _b | _c) & 0x80) return std::string_view::npos;
+    *o++ = (_a << 2) | (_b >> 4);
+    if (n == 3) *o++ = (_b << 4) | (_c >> 2);
+  }
+  return o - _o;
+}
+
+void hexEncodeScalar(const uint8_t *p, std::size_t n, uint8_t *o) {
+  for (std::size_t i = 0; i != n; ++i) {
+    o[i * 2] = hexDigits[p[i] >> 4];
+    o[i * 2 + 1] = hexDigits[p[i] & 0x0F];
+  }
+}
+
+bool hexDecodeScalar(const uint8_t *p, std::size_t n, uint8_t *o) {  // n bytes of output
+  for (std::size_t i = 0; i != n; ++i) {
+    uint8_t _h = hexValues[p[i * 2]], _l = hexValues[p[i * 2 + 1]];
+    if ((_h | _l) & 0x80) return false;
+    o[i] = (_h << 4) | _l;
+  }
+  return true;
+}
+
+#ifdef DATA_ARRAY_SIMD
+// Hex: nibbles map to '0' + n, plus 39 above 9; decoding validates digits and letters with unsigned range checks and merges nibble pairs in 16 bit lanes.
+inline __m128i hexDigitsSse2(__m128i n) { return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8(39))); }
+
+std::size_t hexEncodeSse2(const uint8_t *p, std::size_t n, uint8_t *o) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i _a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    __m128i _h = _mm_and_si128(_mm_srli_epi16(_a, 4), _mm_set1_epi8(0x0F)), _l = _mm_and_si128(_a, _mm_set1_epi8(0x0F));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(o + i * 2), hexDigitsSse2(_mm_unpacklo_epi8(_h, _l)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(o + i * 2 + 16), hexDigitsSse2(_mm_unpackhi_epi8(_h, _l)));
+  }
+  return i;
+}
+
+inline __m128i hexNibblesSse2(__m128i c, __m128i *valid) {
+  __m128i _d = _mm_sub_epi8(c, _mm_set1_epi8('0')), _l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  __m128i _vd = _mm_cmpeq_epi8(_mm_min_epu8(_d, _mm_set1_epi8(9)), _d), _vl = _mm_cmpeq_epi8(_mm_min_epu8(_l, _mm_set1_epi8(5)), _l);
+  *valid = _mm_and_si128(*valid, _mm_or_si128(_vd, _vl));
+  __m128i _n = _mm_or_si128(_mm_and_si128(_d, _vd), _mm_and_si128(_mm_add_epi8(_l, _mm_set1_epi8(10)), _vl));
+  return _mm_and_si128(_mm_or_si128(_mm_slli_epi16(_n, 4), _mm_srli_epi16(_n, 8)), _mm_set1_epi16(0xFF));
+}
+
+std::size_t hexDecodeSse2(const uint8_t *p, std::size_t n, uint8_t *o) {  // returns the bytes decoded, stops before invalid input
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i _valid = _mm_set1_epi8(-1);
+    __m128i _a = hexNibblesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i * 2)), &_valid);
+    __m128i _b = hexNibblesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i * 2 + 16)), &_valid);
+    if (_mm_movemask_epi8(_valid) != 0xFFFF) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(o + i), _mm_packus_epi16(_a, _b));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) std::size_t hexEncodeAvx2(const uint8_t *p, std::size_t n, uint8_t *o) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i _w = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)));
+    __m256i _n = _mm256_or_si256(_mm256_srli_epi16(_w, 4), _mm256_slli_epi16(_mm256_and_si256(_w, _mm256_set1_epi16(0x0F)), 8));
+    __m256i _c = _mm256_add_epi8(_mm256_add_epi8(_n, _mm256_set1_epi8('0')), _mm256_and_si256(_mm256_cmpgt_epi8(_n, _mm256_set1_epi8(9)), _mm256_set1_epi8(39)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(o + i * 2), _c);
+  }
+  return i + hexEncodeSse2(p + i, n - i, o + i * 2);
+}
+
+__attribute__((target("avx2"))) inline __m256i hexNibblesAvx2(__m256i c, __m256i *valid) {
+  __m256i _d = _mm256_sub_epi8(c, _mm256_set1_epi8('0')), _l = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  __m256i _vd = _mm256_cmpeq_epi8(_mm256_min_epu8(_d, _mm256_set1_epi8(9)), _d), _vl = _mm256_cmpeq_epi8(_mm256_min_epu8(_l, _mm256_set1_epi8(5)), _l);
+  *valid = _mm256_and_si256(*valid, _mm256_or_si256(_vd, _vl));
+  __m256i _n = _mm256_or_si256(_mm256_and_si256(_d, _vd), _mm256_and_si256(_mm256_add_epi8(_l, _mm256_set1_epi8(10)), _vl));
+  return _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(_n, 4), _mm256_srli_epi16(_n, 8)), _mm256_set1_epi16(0xFF));
+}
+
+__attribute__((target("avx2"))) std::size_t hexDecodeAvx2(const uint8_t *p, std::size_t n, uint8_t *o) {
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i _valid = _mm256_set1_epi8(-1);
+    __m256i _a = hexNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i * 2)), &_valid);
+    __m256i _b = hexNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i * 2 + 32)), &_valid);
+    if (~_mm256_movemask_epi8(_valid)) break;
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(o + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(_a, _b), 0xD8));
+  }
+  return i + hexDecodeSse2(p + i * 2, n - i, o + i);
+}
+
+// Base64 after W. Mula and D. Lemire: bytes are spread into 6 bit fields with multiplies and translated by a nibble lookup, decoding validates with two nibble lookups.
+__attribute__((target("avx2"))) std::size_t base64EncodeAvx2(const uint8_t *p, std::size_t n, uint8_t *o) {  // returns the bytes encoded, a multiple of 3
+  const __m256i _shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m256i _lut = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0, 65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+  std::size_t i = 0;
+  for (; i + 28 <= n; i += 24, o += 32) {  // 12 bytes in each lane, loads read 4 bytes more
+    __m256i _a = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i))), _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 12)), 1);
+    _a = _mm256_shuffle_epi8(_a, _shuffle);
+    __m256i _t = _mm256_mulhi_epu16(_mm256_and_si256(_a, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+    _a = _mm256_or_si256(_t, _mm256_mullo_epi16(_mm256_and_si256(_a, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010)));
+    __m256i _i = _mm256_sub_epi8(_mm256_subs_epu8(_a, _mm256_set1_epi8(51)), _mm256_cmpgt_epi8(_a, _mm256_set1_epi8(25)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(o), _mm256_add_epi8(_a, _mm256_shuffle_epi8(_lut, _i)));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) std::size_t base64DecodeAvx2(const uint8_t *p, std::size_t n, uint8_t *o) {  // returns the characters decoded, a multiple of 4, writes 8 bytes beyond the output
+  const __m256i _lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m256i _lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i _lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i _mask = _mm256_set1_epi8(0x2F);
+  const __m256i _shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32, o += 24) {
+    __m256i _a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i _hi = _mm256_and_si256(_mm256_srli_epi32(_a, 4), _mask);
+    if (!_mm256_testz_si256(_mm256_shuffle_epi8(_lutLo, _mm256_and_si256(_a, _mask)), _mm256_shuffle_epi8(_lutHi, _hi))) break;
+    _a = _mm256_add_epi8(_a, _mm256_shuffle_epi8(_lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(_a, _mask), _hi)));
+    _a = _mm256_madd_epi16(_mm256_maddubs_epi16(_a, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+    _a = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_a, _shuffle), _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(o), _a);
+  }
+  return i;
+}
+#endif
+
+std::size_t search(const uint8_t *h, std::size_t n, const uint8_t *s, std::size_t m, bool icase) {
+  if (m > n) return std::string_view::npos;
+#ifdef DATA_ARRAY_SIMD
+  if (avx2()) return searchAvx2(h, n, s, m, icase);
+  return searchSse2(h, n, s, m, icase);
+#else
+  return searchScalar(h, n, 0, s, m, icase);
+#endif
+}
+
+std::size_t any(const uint8_t *h, std::size_t n, const uint8_t *d, std::size_t m) {
+#ifdef DATA_ARRAY_SIMD
+  if (m <= 8) return (avx2()) ? anyAvx2(h, n, d, m) : anySse2(h, n, d, m);
+#endif
+  bool _t[256] {};
+  for (std::size_t j = 0; j != m; ++j) _t[d[j]] = true;
+  for (std::size_t i = 0; i != n; ++i)
+    if (_t[h[i]]) return i;
+  return std::string_view::npos;
+}
+
+#ifdef USE_LZ4
+struct Lz4 final : DataArray::AbstractCodec {
+  bool compress(const DataArrayView &v, int level, const DataArrayView &dictionary, DataArray *out) override {
+    if (v.size() > LZ4_MAX_INPUT_SIZE) return false;
+    std::size_t _o = out->size();
+    int _n, _cap = LZ4_compressBound(v.size());
+    out->resize(_o + _cap);
+    char *_dst = reinterpret_cast<char *>(out->data() + _o);
+    if (level > 0) {
+      if (dictionary.empty()) _n = LZ4_compress_HC(v.data(), _dst, v.size(), _cap, level);
+      else {
+        LZ4_streamHC_t *_s = LZ4_createStreamHC();
+        LZ4_resetStreamHC_fast(_s, level);
+        LZ4_loadDictHC(_s, dictionary.data(), dictionary.size());
+        _n = LZ4_compress_HC_continue(_s, v.data(), _dst, v.size(), _cap);
+        LZ4_freeStreamHC(_s);
+      }
+    } else {
+      int _acceleration = (level < -1) ? -level : 1;
+      if (dictionary.empty()) _n = LZ4_compress_fast(v.data(), _dst, v.size(), _cap, _acceleration);
+      else {
+        LZ4_stream_t *_s = LZ4_createStream();
+        LZ4_loadDict(_s, dictionary.data(), dictionary.size());
+        _n = LZ4_compress_fast_continue(_s, v.data(), _dst, v.size(), _cap, _acceleration);
+        LZ4_freeStream(_s);
+      }
+    }
+    if (_n <= 0) return false;
+    out->resize(_o + _n);
+    return true;
+  }
+  bool uncompress(const DataArrayView &v, const DataArrayView &dictionary, uint8_t *p, std::size_t size) override {
+    if (size > LZ4_MAX_INPUT_SIZE) return false;
+    int _n = (dictionary.empty()) ? LZ4_decompress_safe(v.data(), reinterpret_cast<char *>(p), v.size(), size) : LZ4_decompress_safe_usingDict(v.data(), reinterpret_cast<char *>(p), v.size(), size, dictionary.data(), dictionary.size());
+    return _n >= 0 && static_cast<std::size_t>(_n) == size;
+  }
+};
+#endif
+
+#ifdef USE_ZSTD
+struct Zstd final : DataArray::AbstractCodec {
+  struct Context {  // per thread, reused by every call
+    ~Context() {
+      ZSTD_freeCCtx(c);
+      ZSTD_freeDCtx(d);
+    }
+    ZSTD_CCtx *c = ZSTD_createCCtx();
+    ZSTD_DCtx *d = ZSTD_createDCtx();
+  };
+  static Context &context() {
+    thread_local Context _context;
+    return _context;
+  }
+  bool compress(const DataArrayView &v, int level, const DataArrayView &dictionary, DataArray *out) override {
+    std::size_t _o = out->size();
+    std::size_t _n, _cap = ZSTD_compressBound(v.size());
+    out->resize(_o + _cap);
+    if (level == -1) level = ZSTD_CLEVEL_DEFAULT;
+    if (dictionary.empty()) _n = ZSTD_compressCCtx(context().c, out->data() + _o, _cap, v.data(), v.size(), level);
+    else _n = ZSTD_compress_usingDict(context().c, out->data() + _o, _cap, v.data(), v.size(), dictionary.data(), dictionary.size(), level);
+    if (ZSTD_isError(_n)) return false;
+    out->resize(_o + _n);
+    return true;
+  }
+  bool uncompress(const DataArrayView &v, const DataArrayView &dictionary, uint8_t *p, std::size_t size) override {
+    std::size_t _n;
+    if (dictionary.empty()) _n = ZSTD_decompressDCtx(context().d, p, size, v.data(), v.size());
+    else _n = ZSTD_decompress_usingDict(context().d, p, size, v.data(), v.size(), dictionary.data(), dictionary.size());
+    return !ZSTD_isError(_n) && _n == size;
+  }
+};
+#endif
+
+struct Zlib final : DataArray::AbstractCodec {  // the payload of blocks, DataArray::compress() keeps the original format
+  bool compress(const DataArrayView &v, int level, const DataArrayView &dictionary, DataArray *out) override {
+    if (!dictionary.empty()) return false;
+    std::size_t _o = out->size();
+    uLongf _n = compressBound(v.size());
+    out->resize(_o + _n);
+    if (::compress2(out->data() + _o, &_n, reinterpret_cast<const uint8_t *>(v.data()), v.size(), (level < 0) ? Z_DEFAULT_COMPRESSION : level)) return false;
+    out->resize(_o + _n);
+    return true;
+  }
+  bool uncompress(const DataArrayView &v, const DataArrayView &dictionary, uint8_t *p, std::size_t size) override {
+    if (!dictionary.empty()) return false;
+    uLongf _n = size;
+    return !::uncompress(p, &_n, reinterpret_cast<const uint8_t *>(v.data()), v.size()) && _n == size;
+  }
+};
+
+DataArray::AbstractCodec **codecs() {
+  static DataArray::AbstractCodec *_codecs[256] = {};  // indexed by id
+  static Zlib _zlib;
+  _codecs[DataArray::Zlib] = &_zlib;
+#ifdef USE_LZ4
+  static Lz4 _lz4;
+  _codecs[DataArray::Lz4] = &_lz4;
+#endif
+#ifdef USE_ZSTD
+  static Zstd _zstd;
+  _codecs[DataArray::Zstd] = &_zstd;
+#endif
+  return _codecs;
+}
+
+void appendSize(DataArray *da, std::size_t size) {  // LEB128
+  for (;;) {
+    da->push_back((size & 0x7f) | ((size >> 7) ? 0x80 : 0));
+    if (!(size >>= 7)) break;
+  }
+}
+
+bool readSize(const DataArrayView &v, std::size_t *i, std::size_t *size) {  // false if incomplete
+  *size = 0;
+  for (int _shift = 0;; _shift += 7) {
+    if (*i == v.size()) return false;
+    uint8_t _b = v[(*i)++];
+    if (_shift > 63) {
+      *size = SIZE_MAX;
+      return true;
+    }
+    *size |= static_cast<std::size_t>(_b & 0x7f) << _shift;
+    if (!(_b & 0x80)) return true;
+  }
+}
+
+template <typename F>
+void parallel(const std::vector<AbstractThread *> &threads, std::size_t n, const F &f) {  // runs f(0) .. f(n - 1) on idle threads and the calling one, returns when all are done
+  struct State {
+    std::atomic<std::size_t> next {0};
+    std::atomic<std::size_t> done {0};
+    std::size_t n;
+    const F *f;
+    void run() {
+      for (std::size_t i; (i = next.fetch_add(1)) < n;) {
+        (*f)(i);
+        if (done.fetch_add(1) + 1 == n) done.notify_all();
+      }
+    }
+  };
+  if (threads.empty() || n < 2) {
+    for (std::size_t i = 0; i != n; ++i) f(i);
+    return;
+  }
+  std::shared_ptr<State> _s = std::make_shared<State>();  // outlives the call in threads that find no work left
+  _s->n = n;
+  _s->f = &f;
+  AbstractThread *_current = AbstractThread::current();
+  std::size_t _k = 1;
+  for (AbstractThread *_t : threads) {
+    if (_k >= n) break;
+    if (_t != _current && !_t->workLoad() && _t->invoke([_s]() { _s->run(); })) ++_k;  // a busy thread would only take the work late
+  }
+  _s->run();
+  for (std::size_t _d; (_d = _s->done.load()) != n;) _s->done.wait(_d);
+}
+}  // namespace
+
+DataArray DataArray::compress(const DataArrayView &v, uint8_t codec, int level) { return compress(v, codec, level, DataArrayView()); }
+
+DataArray DataArray::compress(const DataArrayView &v, uint8_t codec, int level, const DataArrayView &dictionary) {
+  if (codec != Zlib) {
+    AbstractCodec *_codec = codecs()[codec];
+    if (!_codec) {
+      console_msg("DataArray", "codec not available: " + std::to_string(codec));
+      return {};
+    }
+    DataArray _c;
+    _c.reserve(v.size() / 2 + 16);
+    _c.push_back(DATA_ARRAY_CODEC_MAGIC);
+    _c.push_back(codec);
+    appendSize(&_c, v.size());
+    if (!_codec->compress(v, level, dictionary, &_c)) {
+      console_msg("DataArray", "compress failed");
+      return {};
+    }
+    return _c;
+  }
+  if (!dictionary.empty()) {
+    console_msg("DataArray", "zlib compress with dictionary not supported");
+    return {};
+  }
   std::size_t _size = v.size();
   uLongf _uLongf = compressBound(_size);
   uint8_t j = 0;
@@ -23,7 +504,7 @@ DataArray DataArray::compress(const DataArrayView &v) {
   }
   DataArray _c;
   _c.resize(_uLongf + sizeof(uint8_t) + j);
-  if (::compress(_c.data() + sizeof(uint8_t) + j, &_uLongf, reinterpret_cast<const uint8_t *>(v.data()), v.size())) {
+  if (::compress2(_c.data() + sizeof(uint8_t) + j, &_uLongf, reinterpret_cast<const uint8_t *>(v.data()), v.size(), (level < 0) ? Z_DEFAULT_COMPRESSION : level)) {
     console_msg("DataArray", "compress failed");
     return {};
   }
@@ -34,9 +515,33 @@ DataArray DataArray::compress(const DataArrayView &v) {
   return _c;
 }
 
-DataArray DataArray::uncompress(const DataArrayView &v) {
+DataArray DataArray::uncompress(const DataArrayView &v) { return uncompress(v, DataArrayView()); }
+
+DataArray DataArray::uncompress(const DataArrayView &v, const DataArrayView &dictionary) {
   if (v.empty()) return {};
   std::size_t _size = 0;
+  if (v.size() > 2 && static_cast<uint8_t>(v[0]) == DATA_ARRAY_CODEC_MAGIC && static_cast<uint8_t>(v[1]) != 0x78) {
+    if (v[1] == DATA_ARRAY_BLOCKS) return uncompress(v, std::vector<AbstractThread *>());
+    AbstractCodec *_codec = codecs()[static_cast<uint8_t>(v[1])];
+    if (!_codec) {
+      console_msg("DataArray", "codec not available: " + std::to_string(static_cast<uint8_t>(v[1])));
+      return {};
+    }
+    std::size_t i = 2;
+    if (!readSize(v, &i, &_size)) return {};
+    DataArray _u;
+    try {
+      _u.resize(_size);
+    } catch (std::exception &e) {
+      console_msg("DataArray", "uncompress failed: " + e.what());
+      return {};
+    }
+    if (!_codec->uncompress(v.substr(i), dictionary, _u.data(), _size)) {
+      console_msg("DataArray", "uncompress failed");
+      return {};
+    }
+    return _u;
+  }
   uint8_t j = (v[0] & 0x07);
   if (j) {
     if (v.size() < sizeof(uint8_t) + j) return {};
@@ -60,17 +565,271 @@ DataArray DataArray::uncompress(const DataArrayView &v) {
   return _u;
 }
 
-DataArray::DataArray(const std::string &string) : std::vector<uint8_t>(string.begin(), string.end()) {}
+DataArray DataArray::compress(const DataArrayView &v, uint8_t codec, int level, const std::vector<AbstractThread *> &threads, std::size_t blockSize) {
+  Compressor _c(codec, level, threads, blockSize);
+  if (_c.fail()) return {};
+  DataArray _out = _c.compress(v, true);
+  if (_c.fail()) return {};
+  return _out;
+}
+
+DataArray DataArray::uncompress(const DataArrayView &v, const std::vector<AbstractThread *> &threads) {
+  if (v.size() < 3 || static_cast<uint8_t>(v[0]) != DATA_ARRAY_CODEC_MAGIC || v[1] != DATA_ARRAY_BLOCKS) return uncompress(v);
+  Uncompressor _u(threads);
+  DataArray _out = _u.write(v);
+  if (!_u.finished()) {
+    if (!_u.fail()) console_msg("DataArray", "uncompress failed: incomplete data");
+    return {};
+  }
+  return _out;
+}
+
+DataArray DataArray::toBase64(const DataArrayView &v) {
+  DataArray _o;
+  _o.resize((v.size() + 2) / 3 * 4);
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(v.data());
+  std::size_t i = 0, j = 0;
+#ifdef DATA_ARRAY_SIMD
+  if (avx2()) {
+    i = base64EncodeAvx2(p, v.size(), _o.data());
+    j = i / 3 * 4;
+  }
+#endif
+  base64EncodeScalar(p + i, v.size() - i, _o.data() + j);
+  return _o;
+}
+
+DataArray DataArray::fromBase64(const DataArrayView &v) {
+  std::size_t _n = v.size();
+  if (_n % 4 == 0 && _n && v[_n - 1] == '=') _n -= (v[_n - 2] == '=') ? 2 : 1;
+  DataArray _o;
+  _o.resize(_n / 4 * 3 + 3 + 8);
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(v.data());
+  std::size_t i = 0, j = 0;
+#ifdef DATA_ARRAY_SIMD
+  if (avx2()) {
+    i = base64DecodeAvx2(p, _n, _o.data());
+    j = i / 4 * 3;
+  }
+#endif
+  std::size_t _size = base64DecodeScalar(p + i, _n - i, _o.data() + j);
+  if (_size == std::string_view::npos) return {};
+  _o.resize(j + _size);
+  return _o;
+}
+
+DataArray DataArray::toHex(const DataArrayView &v) {
+  DataArray _o;
+  _o.resize(v.size() * 2);
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(v.data());
+  std::size_t i = 0;
+#ifdef DATA_ARRAY_SIMD
+  i = (avx2()) ? hexEncodeAvx2(p, v.size(), _o.data()) : hexEncodeSse2(p, v.size(), _o.data());
+#endif
+  hexEncodeScalar(p + i, v.size() - i, _o.data() + i * 2);
+  return _o;
+}
+
+DataArray DataArray::fromHex(const DataArrayView &v) {
+  if (v.size() % 2) return {};
+  DataArray _o;
+  _o.resize(v.size() / 2);
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(v.data());
+  std::size_t i = 0;
+#ifdef DATA_ARRAY_SIMD
+  i = (avx2()) ? hexDecodeAvx2(p, _o.size(), _o.data()) : hexDecodeSse2(p, _o.size(), _o.data());
+#endif
+  if (!hexDecodeScalar(p + i * 2, _o.size() - i, _o.data() + i)) return {};
+  return _o;
+}
+
+DataArray DataArray::trainDictionary(const DataArrayList &samples, std::size_t size) {
+#ifdef USE_ZSTD
+  DataArray _samples;
+  std::vector<std::size_t> _sizes;
+  _sizes.reserve(samples.size());
+  for (const DataArray &_da : samples) {
+    _samples += _da;
+    _sizes.push_back(_da.size());
+  }
+  DataArray _d;
+  _d.resize(size);
+  std::size_t _n = ZDICT_trainFromBuffer(_d.data(), _d.size(), _samples.data(), _sizes.data(), _sizes.size());
+  if (ZDICT_isError(_n)) {
+    console_msg("DataArray", std::string("train dictionary failed: ") + ZDICT_getErrorName(_n));
+    return {};
+  }
+  _d.resize(_n);
+  return _d;
+#else
+  (void)samples;
+  (void)size;
+  console_msg("DataArray", "train dictionary not available");
+  return {};
+#endif
+}
+
+void DataArray::registerCodec(uint8_t id, AbstractCodec *codec) {
+  if (id < 16) {
+    console_msg("DataArray", "codec id reserved: " + std::to_string(id));
+    return;
+  }
+  codecs()[id] = codec;
+}
+
+bool DataArray::codecAvailable(uint8_t id) { return id == Zlib || codecs()[id]; }
+
+DataArray::Compressor::Compressor(uint8_t codec, int level, const std::vector<AbstractThread *> &threads, std::size_t blockSize) : threads_(threads), blockSize_(std::clamp<std::size_t>(blockSize, 1, DATA_ARRAY_MAX_BLOCK_SIZE)), level_(level), codec_(codec) {
+  if (!codecs()[codec]) {
+    console_msg("DataArray", "codec not available: " + std::to_string(codec));
+    fail_ = true;
+  }
+}
+
+DataArray DataArray::Compressor::write(const DataArrayView &v) {
+  if (fail_) return {};
+  if (buffer_.size() + v.size() < blockSize_ * (threads_.size() + 1)) {  // wait for a block for each thread
+    buffer_ += v;
+    return {};
+  }
+  DataArray _out;
+  if (buffer_.empty()) {
+    _out = compress(v, false);
+    buffer_ += v.substr(v.size() - v.size() % blockSize_);
+  } else {
+    buffer_ += v;
+    _out = compress(buffer_, false);
+    buffer_.erase(buffer_.begin(), buffer_.end() - buffer_.size() % blockSize_);
+  }
+  return _out;
+}
+
+DataArray DataArray::Compressor::finish() {
+  if (fail_) return {};
+  DataArray _out = compress(buffer_, true);
+  buffer_.clear();
+  return _out;
+}
+
+DataArray DataArray::Compressor::compress(const DataArrayView &v, bool last) {
+  std::size_t _n = v.size() / blockSize_;
+  if (last && v.size() % blockSize_) ++_n;
+  std::vector<DataArray> _blocks(_n);
+  AbstractCodec *_codec = codecs()[codec_];
+  std::atomic<bool> _fail = false;
+  parallel(threads_, _n, [&](std::size_t i) {
+    if (!_codec->compress(v.substr(i * blockSize_, blockSize_), level_, DataArrayView(), &_blocks[i])) _fail = true;
+  });
+  if (_fail) {
+    console_msg("DataArray", "compress failed");
+    fail_ = true;
+    return {};
+  }
+  DataArray _out;
+  std::size_t _size = 3 + 1;
+  for (const DataArray &_b : _blocks) _size += _b.size() + 20;
+  _out.reserve(_size);
+  if (!started_) {
+    _out.push_back(DATA_ARRAY_CODEC_MAGIC);
+    _out.push_back(DATA_ARRAY_BLOCKS);
+    _out.push_back(codec_);
+    started_ = true;
+  }
+  for (std::size_t i = 0; i != _n; ++i) {
+    appendSize(&_out, std::min(blockSize_, v.size() - i * blockSize_));
+    appendSize(&_out, _blocks[i].size());
+    _out += _blocks[i];
+  }
+  if (last) appendSize(&_out, 0);
+  return _out;
+}
+
+DataArray::Uncompressor::Uncompressor(const std::vector<AbstractThread *> &threads) : threads_(threads) {}
+
+DataArray DataArray::Uncompressor::write(const DataArrayView &v) {
+  if (fail_ || finished_) return {};
+  bool _buffered = !buffer_.empty();
+  if (_buffered) buffer_ += v;
+  DataArrayView _v = (_buffered) ? DataArrayView(buffer_) : v;
+  std::size_t i = 0;
+  if (!codec_) {
+    if (_v.size() < 3) {
+      if (!_buffered) buffer_ += v;
+      return {};
+    }
+    if (static_cast<uint8_t>(_v[0]) != DATA_ARRAY_CODEC_MAGIC || _v[1] != DATA_ARRAY_BLOCKS) {
+      console_msg("DataArray", "uncompress failed: not a block container");
+      fail_ = true;
+      return {};
+    }
+    if (!(codec_ = codecs()[static_cast<uint8_t>(_v[2])])) {
+      console_msg("DataArray", "codec not available: " + std::to_string(static_cast<uint8_t>(_v[2])));
+      fail_ = true;
+      return {};
+    }
+    i = 3;
+  }
+  struct Block {
+    std::size_t offset;
+    std::size_t size;
+    std::size_t rawOffset;
+    std::size_t rawSize;
+  };
+  std::vector<Block> _blocks;
+  std::size_t _total = 0;
+  for (;;) {  // the block sizes index the container
+    std::size_t j = i, _raw, _size;
+    if (!readSize(_v, &j, &_raw)) break;
+    if (!_raw) {
+      finished_ = true;
+      i = j;
+      break;
+    }
+    if (!readSize(_v, &j, &_size)) break;
+    if (_raw > DATA_ARRAY_MAX_BLOCK_SIZE || !_size || _size > DATA_ARRAY_MAX_BLOCK_SIZE * 2) {  // no codec encodes a non-empty block in zero bytes
+      console_msg("DataArray", "uncompress failed: invalid block size");
+      fail_ = true;
+      return {};
+    }
+    if (_v.size() - j < _size) break;
+    _blocks.push_back({j, _size, _total, _raw});
+    _total += _raw;
+    i = j + _size;
+  }
+  DataArray _out;
+  try {
+    _out.resize(_total);
+  } catch (std::exception &e) {
+    console_msg("DataArray", "uncompress failed: " + e.what());
+    fail_ = true;
+    return {};
+  }
+  std::atomic<bool> _fail = false;
+  parallel(threads_, _blocks.size(), [&](std::size_t k) {
+    const Block &_b = _blocks[k];
+    if (!codec_->uncompress(_v.substr(_b.offset, _b.size), DataArrayView(), _out.data() + _b.rawOffset, _b.rawSize)) _fail = true;
+  });
+  if (_fail) {
+    console_msg("DataArray", "uncompress failed");
+    fail_ = true;
+    return {};
+  }
+  if (_buffered) buffer_.erase(buffer_.begin(), buffer_.begin() + i);
+  else if (!finished_) buffer_ += v.substr(i);
+  return _out;
+}
+
+DataArray::DataArray(const std::string &string) : std::vector<uint8_t, DataArrayAllocator>(string.begin(), string.end()) {}
 
 DataArray::DataArray(const char *string) : DataArray(std::string(string)) {}
 
-DataArray::DataArray(const char c) : std::vector<uint8_t>(1, c) {}
+DataArray::DataArray(const char c) : std::vector<uint8_t, DataArrayAllocator>(1, c) {}
 
-DataArray::DataArray(const std::vector<char> &v) : std::vector<uint8_t>(v.begin(), v.end()) {}
+DataArray::DataArray(const std::vector<char> &v) : std::vector<uint8_t, DataArrayAllocator>(v.begin(), v.end()) {}
 
 const DataArrayView DataArray::view(std::size_t i, std::size_t j) const {
-  if (i >= std::vector<uint8_t>::size()) return {};
-  if (!j || i + j >= std::vector<uint8_t>::size()) return {data() + i, std::vector<uint8_t>::size() - i};
+  if (i >= std::vector<uint8_t, DataArrayAllocator>::size()) return {};
+  if (!j || i + j >= std::vector<uint8_t, DataArrayAllocator>::size()) return {data() + i, std::vector<uint8_t, DataArrayAllocator>::size() - i};
   return {data() + i, static_cast<std::size_t>(j)};
 }
 
@@ -102,12 +861,37 @@ DataArrayView::DataArrayView(const DataArray::iterator begin, const DataArray::i
 
 DataArrayView::DataArrayView(const DataArray &da) : DataArrayView(da.data(), da.size()) {}
 
+DataArrayView::DataArrayView(const SharedDataArray &da) : DataArrayView(da.data(), da.size()) {}
+
+SharedDataArray::SharedDataArray(DataArray &&da) : array_(std::make_shared<const DataArray>(std::move(da))), size_(array_->size()) {}
+
+SharedDataArray::SharedDataArray(const DataArrayView &v) : SharedDataArray(DataArray(reinterpret_cast<const uint8_t *>(v.data()), reinterpret_cast<const uint8_t *>(v.data()) + v.size())) {}
+
+SharedDataArray::SharedDataArray(const std::shared_ptr<const DataArray> &array) : array_(array), size_((array) ? array->size() : 0) {}
+
+SharedDataArray SharedDataArray::slice(std::size_t i, std::size_t j) const {
+  SharedDataArray _s;
+  if (i >= size_) return _s;
+  _s.array_ = array_;
+  _s.offset_ = offset_ + i;
+  _s.size_ = (!j || i + j >= size_) ? size_ - i : j;
+  return _s;
+}
+
+const DataArrayView SharedDataArray::view(std::size_t i, std::size_t j) const {
+  if (i >= size_) return {};
+  if (!j || i + j >= size_) return {data() + i, size_ - i};
+  return {data() + i, j};
+}
+
+DataArray SharedDataArray::array() const { return DataArray(begin(), end()); }
+
 DataArrayList DataArrayView::split(const char c) const {
   if (empty()) return {};
   DataArrayList l;
-  int i = 0;
+  std::size_t i = 0;
   for (;;) {
-    size_t j = find(c, i);
+    std::size_t j = indexOf(c, i);
     l.push_back({data() + i, (j == std::string::npos) ? data() + size() : data() + j});
     if (j == std::string::npos) break;
     i = j + 1;
@@ -115,6 +899,45 @@ DataArrayList DataArrayView::split(const char c) const {
   return l;
 }
 
+std::vector<DataArrayView> DataArrayView::splitViews(const char c) const {
+  if (empty()) return {};
+  std::vector<DataArrayView> l;
+  std::size_t i = 0;
+  for (;;) {
+    std::size_t j = indexOf(c, i);
+    l.emplace_back(data() + i, ((j == std::string::npos) ? size() : j) - i);
+    if (j == std::string::npos) break;
+    i = j + 1;
+  }
+  return l;
+}
+
+std::size_t DataArrayView::indexOf(const char c, std::size_t i) const {
+  if (i >= size()) return npos;
+  const void *_p = std::memchr(data() + i, c, size() - i);
+  return (_p) ? static_cast<const char *>(_p) - data() : npos;
+}
+
+std::size_t DataArrayView::indexOf(const std::string_view &v, std::size_t i) const {
+  if (v.empty()) return (i <= size()) ? i : npos;
+  if (i >= size()) return npos;
+  std::size_t j = search(reinterpret_cast<const uint8_t *>(data()) + i, size() - i, reinterpret_cast<const uint8_t *>(v.data()), v.size(), false);
+  return (j == npos) ? j : i + j;
+}
+
+std::size_t DataArrayView::indexOfIgnoreCase(const std::string_view &v, std::size_t i) const {
+  if (v.empty()) return (i <= size()) ? i : npos;
+  if (i >= size()) return npos;
+  std::size_t j = search(reinterpret_cast<const uint8_t *>(data()) + i, size() - i, reinterpret_cast<const uint8_t *>(v.data()), v.size(), true);
+  return (j == npos) ? j : i + j;
+}
+
+std::size_t DataArrayView::indexOfAny(const std::string_view &v, std::size_t i) const {
+  if (i >= size() || v.empty()) return npos;
+  std::size_t j = any(reinterpret_cast<const uint8_t *>(data()) + i, size() - i, reinterpret_cast<const uint8_t *>(v.data()), v.size());
+  return (j == npos) ? j : i + j;
+}
+
 DataArray DataArrayList::join(const char c) const {
   if (empty()) return {};
   DataArray da = (*this)[0];
@@ -131,7 +954,7 @@ struct DataStream::Private {
       read = true;
       data = const_cast<DataArray *>(da);
     } else {
-      data = new DataArray;
+      data = &array;
     }
   }
   template <typename T>
@@ -144,10 +967,12 @@ struct DataStream::Private {
       _v.resize(_s);
     } catch (std::exception &e) { fail = true; };
   }
-  void w(int, const uint8_t *);
-  void r(int, uint8_t *);
+  void w(std::size_t, const uint8_t *);
+  void r(std::size_t, uint8_t *);
   void sw(std::size_t);
   void sr(std::size_t *);
+  const char *v(std::size_t *);
+  DataArray array;  // of a write stream
   DataArray *data;
   bool fail = false;
   bool read = false;
@@ -158,10 +983,7 @@ DataStream::DataStream() : private_(*new Private) {}
 
 DataStream::DataStream(const DataArray &data) : private_(*new Private(&data)) {}
 
-DataStream::~DataStream() {
-  if (!private_.read) delete private_.data;
-  delete &private_;
-}
+DataStream::~DataStream() { delete &private_; }
 
 DataStream &DataStream::operator<<(int8_t v) {
   private_.w(sizeof(int8_t), reinterpret_cast<uint8_t *>(&v));
@@ -325,6 +1147,11 @@ DataStream &DataStream::operator>>(DataArrayList &v) {
 
 DataStream &DataStream::operator<<(const DataArrayList &v) {
   std::size_t _s = v.size();
+  if (!private_.read) {
+    std::size_t _r = sizeof(std::size_t) + 1;
+    for (const DataArray &_da : v) _r += _da.size() + sizeof(std::size_t) + 1;
+    reserve(_r);
+  }
   private_.sw(_s);
   if (private_.fail) return *this;
   for (std::size_t i = 0; i != _s; ++i) {
@@ -334,7 +1161,82 @@ DataStream &DataStream::operator<<(const DataArrayList &v) {
   return *this;
 }
 
-void DataStream::Private::w(int size, const uint8_t *p) {
+DataStream &DataStream::operator>>(std::string_view &v) {
+  std::size_t _s;
+  const char *_p = private_.v(&_s);
+  v = (_p) ? std::string_view(_p, _s) : std::string_view();
+  return *this;
+}
+
+DataStream &DataStream::operator>>(DataArrayView &v) {
+  std::size_t _s;
+  const char *_p = private_.v(&_s);
+  v = (_p) ? DataArrayView(_p, _s) : DataArrayView();
+  return *this;
+}
+
+DataStream &DataStream::operator>>(std::vector<DataArrayView> &v) {
+  std::size_t _s;
+  private_.sr(&_s);
+  if (private_.fail) return *this;
+  if (_s > private_.data->size() - private_.pos) {  // each item takes one byte at least
+    private_.fail = true;
+    return *this;
+  }
+  std::vector<DataArrayView> _l;
+  _l.reserve(_s);
+  for (std::size_t i = 0; i != _s; ++i) {
+    std::size_t _n;
+    const char *_p = private_.v(&_n);
+    if (!_p) return *this;
+    _l.emplace_back(_p, _n);
+  }
+  v = std::move(_l);
+  return *this;
+}
+
+void DataStream::reserve(std::size_t size) {
+  if (private_.read) return;
+  std::size_t _s = private_.data->size() + size;
+  if (_s > private_.data->capacity()) private_.data->reserve(std::max(_s, private_.data->capacity() * 2));  // keeps the growth geometric
+}
+
+void DataStream::writeArray(const void *p, std::size_t n, std::size_t size) {
+  reserve(n * size + sizeof(std::size_t) + 1);
+  private_.sw(n);
+  private_.w(n * size, static_cast<const uint8_t *>(p));
+}
+
+std::size_t DataStream::readArray(std::size_t size) {
+  std::size_t _n;
+  private_.sr(&_n);
+  if (private_.fail) return 0;
+  if (_n > (private_.data->size() - private_.pos) / size) {
+    private_.fail = true;
+    return 0;
+  }
+  return _n;
+}
+
+void DataStream::setFailed() { private_.fail = true; }
+
+void DataStream::writeBytes(const void *p, std::size_t size) { private_.w(size, static_cast<const uint8_t *>(p)); }
+
+void DataStream::readBytes(void *p, std::size_t size) { private_.r(size, static_cast<uint8_t *>(p)); }
+
+const char *DataStream::Private::v(std::size_t *s) {
+  sr(s);
+  if (fail) return nullptr;
+  if (*s > data->size() - pos) {
+    fail = true;
+    return nullptr;
+  }
+  const char *_p = reinterpret_cast<const char *>(data->data()) + pos;
+  pos += *s;
+  return _p;
+}
+
+void DataStream::Private::w(std::size_t size, const uint8_t *p) {
   if (fail) return;
   if (read) {
     fail = true;
@@ -344,7 +1246,7 @@ void DataStream::Private::w(int size, const uint8_t *p) {
   data->insert(data->end(), p, p + size);
 }
 
-void DataStream::Private::r(int size, uint8_t *p) {
+void DataStream::Private::r(std::size_t size, uint8_t *p) {
   if (fail || !size) return;
   if (!read) {
     fail = true;
@@ -388,6 +1290,7 @@ void DataStream::Private::sr(std::size_t *s) {
 
 namespace AsyncFw {
 LogStream &operator<<(LogStream &log, const DataArray &v) { return log << v.view(); }
+LogStream &operator<<(LogStream &log, const SharedDataArray &v) { return log << v.view(); }
 LogStream &operator<<(LogStream &log, const DataArrayView &v) {
   if (v.empty()) {
     log << "[]";
@@ -399,7 +1302,8 @@ LogStream &operator<<(LogStream &log, const DataArrayView &v) {
   }
   for (const std::basic_string_view<char>::value_type &c : v)
     if (!std::isprint(c) && c != '\n' && c != '\r' && c != '\t') {
-      log << "[Binary data, size: " + std::to_string(v.size()) + "]";
+      DataArray _hex = DataArray::toHex(v.substr(0, LOG_DATA_ARRAY_HEX_LIMIT));
+      log << "[Binary data, size: " + std::to_string(v.size()) + ", hex: " + std::string(_hex.begin(), _hex.end()) + ((v.size() > LOG_DATA_ARRAY_HEX_LIMIT) ? "...]" : "]");
       return log;
     }
   log << static_cast<std::string_view>(v);
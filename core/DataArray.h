@@ -7,28 +7,82 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 #pragma once
 
-/** @file DataArray.h @brief The DataArray, DataArrayView, DataArrayList and DataStream classes. */
+/** @file DataArray.h @brief The DataArray, DataArrayView, SharedDataArray, DataArrayList and DataStream classes. */
 
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <memory>
+#include <span>
+#include <type_traits>
+#ifdef USE_DATA_ARRAY_POOL
+  #include "MemoryPool.h"
+#endif
 
 namespace AsyncFw {
 class DataArrayList;
 class DataArrayView;
+class SharedDataArray;
 class LogStream;
+class AbstractThread;
+#ifdef USE_DATA_ARRAY_POOL
+using DataArrayAllocator = MemoryPool::Allocator<uint8_t>;
+#else
+using DataArrayAllocator = std::allocator<uint8_t>;
+#endif
 /** @class DataArray DataArray.h <AsyncFw/DataArray> @brief The DataArray class, provides an array of bytes.
-@details Implements a rich set of constructors and conversion tools to seamlessly bridge standard C++ primitives, strings, and raw memory buffers into an encapsulated binary package.
+@details Implements a rich set of constructors and conversion tools to seamlessly bridge standard C++ primitives, strings, and raw memory buffers into an encapsulated binary package. The storage is allocated by DataArrayAllocator, std::allocator or, with USE_DATA_ARRAY_POOL, the MemoryPool.
 @brief Example: @snippet DataArray/main.cpp snippet */
-class DataArray : public std::vector<uint8_t> {
+class DataArray : public std::vector<uint8_t, DataArrayAllocator> {
 public:
-  /** @brief Compresses the provided data view using the framework's default compression algorithm.
-  @param v The source binary data view to compress. @return A new compressed DataArray container. */
-  static DataArray compress(const DataArrayView &);
-  /** @brief Uncompresses the provided compressed data view back to its original raw form.
-  @param v The compressed binary data view. @return A new decompressed DataArray container. */
+  /** @brief Compression codec identifiers, written into the header of a compressed array. Values from 16 are free for registerCodec(). */
+  enum Codec : uint8_t {
+    Zlib = 0, /**< zlib, in the original format, readable by earlier versions. Always available. */
+    Lz4 = 1,  /**< LZ4, levels above 0 select LZ4 HC. Available with USE_LZ4. */
+    Zstd = 2  /**< Zstandard. Available with USE_ZSTD. */
+  };
+  class Compressor;
+  class Uncompressor;
+  /** @class AbstractCodec @brief The interface of a compression codec for registerCodec(). */
+  class AbstractCodec {
+  public:
+    virtual ~AbstractCodec() = default;
+    /** @brief Appends the compressed bytes to the output array. @return False on failure. */
+    virtual bool compress(const DataArrayView &, int level, const DataArrayView &dictionary, DataArray *) = 0;
+    /** @brief Uncompresses exactly size bytes into the output buffer. @return False on failure. */
+    virtual bool uncompress(const DataArrayView &, const DataArrayView &dictionary, uint8_t *, std::size_t size) = 0;
+  };
+  /** @brief Compresses the provided data view, by default with zlib at its default level.
+  @param v The source binary data view to compress. @param codec The codec. @param level The codec level, -1 selects its default.
+  @return A new compressed DataArray container, empty if the codec is not available or failed. */
+  static DataArray compress(const DataArrayView &, uint8_t = Zlib, int = -1);
+  /** @brief Compresses the provided data view with a dictionary shared with the reader, such as one from trainDictionary(). Not supported by Zlib. */
+  static DataArray compress(const DataArrayView &, uint8_t, int, const DataArrayView &);
+  /** @brief Uncompresses the provided compressed data view back to its original raw form, the codec is detected from the header.
+  @param v The compressed binary data view. @return A new decompressed DataArray container, empty on failure. */
   static DataArray uncompress(const DataArrayView &);
-  using std::vector<uint8_t>::vector;
+  /** @brief Uncompresses the provided compressed data view with the dictionary used for compression. */
+  static DataArray uncompress(const DataArrayView &, const DataArrayView &);
+  /** @brief Compresses the provided data view into a block container, see Compressor. The blocks are compressed by the threads and the calling thread in parallel. */
+  static DataArray compress(const DataArrayView &, uint8_t, int, const std::vector<AbstractThread *> &, std::size_t = 1024 * 1024);
+  /** @brief Uncompresses the provided compressed data view, the blocks of a block container are uncompressed by the threads and the calling thread in parallel. */
+  static DataArray uncompress(const DataArrayView &, const std::vector<AbstractThread *> &);
+  /** @brief Encodes the data view in base64 (RFC 4648) with padding, vectorized where the processor supports it. */
+  static DataArray toBase64(const DataArrayView &);
+  /** @brief Decodes base64, with or without padding, vectorized where the processor supports it. @return The decoded bytes, empty if the input is not valid base64. */
+  static DataArray fromBase64(const DataArrayView &);
+  /** @brief Encodes the data view as lowercase hexadecimal digits, vectorized where the processor supports it. */
+  static DataArray toHex(const DataArrayView &);
+  /** @brief Decodes hexadecimal digits of either case, vectorized where the processor supports it. @return The decoded bytes, empty if the input is not valid. */
+  static DataArray fromHex(const DataArrayView &);
+  /** @brief Trains a Zstandard dictionary for small similar arrays, usable with Zstd and Lz4. @return The dictionary, empty without USE_ZSTD or on failure. */
+  static DataArray trainDictionary(const DataArrayList &, std::size_t = 16 * 1024);
+  /** @brief Registers a codec under an identifier from 16 to 255, the codec must live while it is used.
+  @warning Must only be called during initialization, before any thread compresses. */
+  static void registerCodec(uint8_t, AbstractCodec *);
+  /** @brief Checks whether a codec is available in this build or registered. */
+  static bool codecAvailable(uint8_t);
+  using std::vector<uint8_t, DataArrayAllocator>::vector;
   /** @brief Constructs a byte array from a standard string instance. */
   DataArray(const std::string &);
   /** @brief Constructs a byte array from a null-terminated C-style string. */
@@ -63,9 +117,53 @@ public:
   DataArrayView(const DataArray::iterator, const DataArray::iterator);
   /** @brief Constructs a data view mapping the entire memory buffer of an existing DataArray. */
   DataArrayView(const DataArray &);
+  /** @brief Constructs a data view mapping the bytes of a SharedDataArray, valid while a copy of it holds the buffer. */
+  DataArrayView(const SharedDataArray &);
   /** @brief Splices the viewed binary stream into a tokenized list using a specific delimiter character.
   @param c The dividing boundary byte/character. @return A newly constructed list container holding independent slices. */
   DataArrayList split(const char) const;
+  /** @brief Splits the view like split(), without copying. @return Views into the same memory, valid while it is. */
+  std::vector<DataArrayView> splitViews(const char) const;
+  /** @brief Finds the first occurrence of a byte at or after the position. @return The index or npos. */
+  std::size_t indexOf(const char, std::size_t = 0) const;
+  /** @brief Finds the first occurrence of a byte sequence at or after the position, vectorized where the processor supports it. @return The index or npos. */
+  std::size_t indexOf(const std::string_view &, std::size_t = 0) const;
+  /** @brief Finds a byte sequence like indexOf(), ignoring the case of ASCII letters. @return The index or npos. */
+  std::size_t indexOfIgnoreCase(const std::string_view &, std::size_t = 0) const;
+  /** @brief Finds the first byte that equals any of the given bytes, at or after the position. @return The index or npos. */
+  std::size_t indexOfAny(const std::string_view &, std::size_t = 0) const;
+};
+/** @class SharedDataArray DataArray.h <AsyncFw/DataArray> @brief An immutable reference-counted byte array.
+@details Copies, slices and views share one buffer, only the reference count changes, so a payload passes through signals, invoke() captures and transmit queues without copying its bytes. The buffer is released with the last copy. The reference count is thread-safe, the bytes are never modified. */
+class SharedDataArray {
+public:
+  /** @brief Constructs an empty array. */
+  SharedDataArray() = default;
+  /** @brief Takes over the bytes of a DataArray without copying them. */
+  explicit SharedDataArray(DataArray &&);
+  /** @brief Copies the bytes of a data view. */
+  explicit SharedDataArray(const DataArrayView &);
+  /** @brief Shares an existing buffer. @param array Buffer, nullptr constructs an empty array. */
+  explicit SharedDataArray(const std::shared_ptr<const DataArray> &);
+  /** @brief Returns a slice sharing the buffer, without copying. @param i The starting index of the slice. @param j The length of the slice. If 0, captures everything up to the end of the array. */
+  SharedDataArray slice(std::size_t = 0, std::size_t = 0) const;
+  /** @brief Returns a view of the bytes, valid while a copy of the array holds the buffer. @param i The starting index. @param j The length. If 0, captures everything up to the end of the array. */
+  const DataArrayView view(std::size_t = 0, std::size_t = 0) const;
+  /** @brief Copies the bytes into a new DataArray. */
+  DataArray array() const;
+  /** @brief Returns the number of arrays sharing the buffer. */
+  long useCount() const { return array_.use_count(); }
+  const uint8_t *data() const { return (array_) ? array_->data() + offset_ : nullptr; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return !size_; }
+  const uint8_t *begin() const { return data(); }
+  const uint8_t *end() const { return data() + size_; }
+  uint8_t operator[](std::size_t i) const { return data()[i]; }
+
+private:
+  std::shared_ptr<const DataArray> array_;
+  std::size_t offset_ = 0;
+  std::size_t size_ = 0;
 };
 /** @class DataArrayList DataArray.h <AsyncFw/DataArray> @brief A specialized container aggregating multiple DataArray instances.
 @brief Example: @snippet DataArray/main.cpp snippet */
@@ -76,11 +174,60 @@ public:
   @param c The spacer byte inserted between adjacent items. @return A newly allocated, merged DataArray container. */
   DataArray join(const char) const;
 };
+/** @class DataArray::Compressor DataArray.h <AsyncFw/DataArray> @brief Compresses a stream of data in independently compressed blocks.
+@details Data is fed in chunks of any size and comes out as a block container: a header with the codec, then each block prefixed with its original and compressed sizes, so a reader can find every block without uncompressing and uncompress them in parallel. With threads, the blocks are compressed by the threads and the calling thread together, the output order does not depend on them. The container is read by DataArray::uncompress() and Uncompressor. */
+class DataArray::Compressor {
+public:
+  /** @brief Constructs a compressor. @param codec The codec. @param level The codec level, -1 selects its default. @param threads Threads to compress blocks on, besides the calling one. @param blockSize The size of the uncompressed blocks. */
+  Compressor(uint8_t = Zlib, int = -1, const std::vector<AbstractThread *> & = {}, std::size_t = 1024 * 1024);
+  /** @brief Feeds data. @return The compressed output of the blocks completed so far, may be empty. */
+  DataArray write(const DataArrayView &);
+  /** @brief Compresses the remaining data and closes the container. @return The last part of the output. */
+  DataArray finish();
+  /** @brief Returns true if the codec is not available or failed. */
+  bool fail() const { return fail_; }
+
+private:
+  friend DataArray;
+  DataArray compress(const DataArrayView &, bool);
+  std::vector<AbstractThread *> threads_;
+  DataArray buffer_;
+  std::size_t blockSize_;
+  int level_;
+  uint8_t codec_;
+  bool started_ = false;
+  bool fail_ = false;
+};
+
+/** @class DataArray::Uncompressor DataArray.h <AsyncFw/DataArray> @brief Uncompresses a block container produced by DataArray::Compressor, fed in chunks of any size. */
+class DataArray::Uncompressor {
+public:
+  /** @brief Constructs an uncompressor. @param threads Threads to uncompress blocks on, besides the calling one. */
+  Uncompressor(const std::vector<AbstractThread *> & = {});
+  /** @brief Feeds compressed data. @return The uncompressed data of the blocks completed so far, may be empty. */
+  DataArray write(const DataArrayView &);
+  /** @brief Returns true when the end of the container has been read. */
+  bool finished() const { return finished_; }
+  /** @brief Returns true if the data is not a valid container or the codec is not available. */
+  bool fail() const { return fail_; }
+
+private:
+  std::vector<AbstractThread *> threads_;
+  DataArray buffer_;
+  AbstractCodec *codec_ = nullptr;
+  bool finished_ = false;
+  bool fail_ = false;
+};
+
 /** @class DataStream DataArray.h <AsyncFw/DataArray> @brief A fast, compact binary serialization stream.
 @details Supports stream operators (<< and >>) to easily encode and decode primitives, strings, and byte arrays into packed, tightly structured binary payloads using optimized variable-length length prefixes.
+Vectors and spans of trivially copyable types are written as one length prefix and a single copy of their bytes in host byte order, the same bytes as writing the elements one by one. A read stream can return views into its source instead of copies, the views are valid while the source is.
 @note This class explicitly blocks copying and moving.
 @brief Example: @snippet DataArray/main.cpp snippet */
 class DataStream {
+  template <typename T>
+  static constexpr bool bulk_ = std::is_trivially_copyable_v<T> && !std::is_same_v<T, bool>;
+
 public:
   /** @brief Constructs a write-only serialization stream building an internal data container from scratch. */
   DataStream();
@@ -119,19 +266,62 @@ public:
   DataStream &operator>>(DataArrayList &);
   /** @} */
 
+  /** @brief Reads a string or a byte array as a view into the source array, without copying. */
+  DataStream &operator>>(std::string_view &);
+  /** @brief Reads a string or a byte array as a view into the source array, without copying. */
+  DataStream &operator>>(DataArrayView &);
+  /** @brief Reads a DataArrayList as views into the source array, without copying. */
+  DataStream &operator>>(std::vector<DataArrayView> &);
+  /** @brief Writes a span of trivially copyable values with one length prefix and one copy. */
+  template <typename T>
+    requires bulk_<T>
+  DataStream &operator<<(std::span<const T> v) {
+    writeArray(v.data(), v.size(), sizeof(T));
+    return *this;
+  }
+  /** @brief Writes a vector of trivially copyable values with one length prefix and one copy. */
+  template <typename T>
+    requires bulk_<T>
+  DataStream &operator<<(const std::vector<T> &v) {
+    writeArray(v.data(), v.size(), sizeof(T));
+    return *this;
+  }
+  /** @brief Reads a vector of trivially copyable values written by the operators above. */
+  template <typename T>
+    requires bulk_<T>
+  DataStream &operator>>(std::vector<T> &v) {
+    std::size_t _n = readArray(sizeof(T));
+    if (fail()) return *this;
+    v.resize(_n);
+    readBytes(v.data(), _n * sizeof(T));
+    return *this;
+  }
+
+  /** @brief Reserves space in the array of a write stream for the given number of further bytes. */
+  void reserve(std::size_t);
+
   /** @brief Retrieves a reference to the active cumulative raw byte array built by the stream.
   @return Immutable reference to the binary buffer. */
   const DataArray &array() const;
   /** @brief Checks if the stream pipeline encountered a boundary check failure, bad memory, or malformed data packets.
   @return True if an operation failed or the stream is corrupted. */
   bool fail() const;
+  /** @brief Marks the stream as failed, for operators that detect malformed data themselves. */
+  void setFailed();
+  /** @brief Writes raw bytes without a length prefix. */
+  void writeBytes(const void *, std::size_t);
+  /** @brief Reads raw bytes written by writeBytes(), with one bounds check for the whole block. */
+  void readBytes(void *, std::size_t);
 
 private:
+  void writeArray(const void *, std::size_t, std::size_t);
+  std::size_t readArray(std::size_t);
   struct Private;
   Private &private_;
 };
 LogStream &operator<<(LogStream &, const DataArray &);
 LogStream &operator<<(LogStream &, const DataArrayView &);
+LogStream &operator<<(LogStream &, const SharedDataArray &);
 LogStream &operator<<(LogStream &, const DataArrayList &);
 LogStream &operator<<(LogStream &, const DataStream &);
 }  // namespace AsyncFw
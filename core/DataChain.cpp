@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+#include <algorithm>
+#include <cstring>
+#ifndef _WIN32
+  #include <sys/uio.h>
+#endif
+#include "DataChain.h"
+
+#ifndef DATA_CHAIN_SEGMENTS
+  #define DATA_CHAIN_SEGMENTS 16
+#endif
+
+using namespace AsyncFw;
+
+DataChain::DataChain(const SharedDataArray &a) { append(a); }
+
+DataChain &DataChain::append(const SharedDataArray &a) { return insert(segments_.size(), {a, nullptr, 0, a.size()}); }
+
+DataChain &DataChain::append(DataArray &&da) { return append(SharedDataArray(std::move(da))); }
+
+DataChain &DataChain::append(const DataArrayView &v) {
+  if (v.empty()) return *this;
+  const std::size_t _o = buffer_.size();
+  buffer_.insert(buffer_.end(), v.begin(), v.end());
+  if (!segments_.empty()) {
+    Segment &_s = segments_.back();
+    if (_s.array.empty() && !_s.data && _s.offset + _s.size == _o) {  // the previous segment is copied, extend it
+      _s.size += v.size();
+      size_ += v.size();
+      return *this;
+    }
+  }
+  return insert(segments_.size(), {{}, nullptr, _o, v.size()});
+}
+
+DataChain &DataChain::append(const DataChain &c) {
+  if (&c == this) return append(DataChain(c));
+  segments_.reserve(segments_.size() + c.segments_.size());
+  for (const Segment &_s : c.segments_) {
+    if (_s.array.empty() && !_s.data) append(DataArrayView(c.data(_s), _s.size));
+    else insert(segments_.size(), Segment(_s));
+  }
+  return *this;
+}
+
+DataChain &DataChain::appendView(const DataArrayView &v) { return insert(segments_.size(), {{}, reinterpret_cast<const uint8_t *>(v.data()), 0, v.size()}); }
+
+DataChain &DataChain::prepend(const SharedDataArray &a) { return insert(0, {a, nullptr, 0, a.size()}); }
+
+DataChain &DataChain::prepend(DataArray &&da) { return prepend(SharedDataArray(std::move(da))); }
+
+DataChain &DataChain::prepend(const DataArrayView &v) {
+  if (v.empty()) return *this;
+  const std::size_t _o = buffer_.size();
+  buffer_.insert(buffer_.end(), v.begin(), v.end());
+  return insert(0, {{}, nullptr, _o, v.size()});
+}
+
+DataChain &DataChain::prependView(const DataArrayView &v) { return insert(0, {{}, reinterpret_cast<const uint8_t *>(v.data()), 0, v.size()}); }
+
+DataChain DataChain::slice(std::size_t i, std::size_t j) const {
+  DataChain _c;
+  if (i >= size_) return _c;
+  if (!j || i + j > size_) j = size_ - i;
+  _c.size_ = j;
+  for (const Segment &_s : segments_) {
+    if (i >= _s.size) {
+      i -= _s.size;
+      continue;
+    }
+    const std::size_t _n = std::min(_s.size - i, j);
+    if (!_s.array.empty()) _c.segments_.push_back({_s.array.slice(i, _n), nullptr, 0, _n});
+    else if (_s.data) _c.segments_.push_back({{}, _s.data + i, 0, _n});
+    else {
+      _c.segments_.push_back({{}, nullptr, _c.buffer_.size(), _n});
+      _c.buffer_.insert(_c.buffer_.end(), buffer_.begin() + _s.offset + i, buffer_.begin() + _s.offset + i + _n);
+    }
+    if (!(j -= _n)) break;
+    i = 0;
+  }
+  return _c;
+}
+
+DataChain DataChain::detached() const {
+  DataChain _c = *this;
+  for (Segment &_s : _c.segments_) {
+    if (!_s.data) continue;
+    _s.offset = _c.buffer_.size();
+    _c.buffer_.insert(_c.buffer_.end(), _s.data, _s.data + _s.size);
+    _s.data = nullptr;
+  }
+  return _c;
+}
+
+void DataChain::clear() {
+  segments_.clear();
+  buffer_.clear();
+  size_ = 0;
+}
+
+DataArrayView DataChain::segment(std::size_t i) const { return DataArrayView(data(segments_[i]), segments_[i].size); }
+
+void DataChain::copy(uint8_t *p) const {
+  for (const Segment &_s : segments_) {
+    std::memcpy(p, data(_s), _s.size);
+    p += _s.size;
+  }
+}
+
+DataArray DataChain::flatten() const {
+  DataArray _da;
+  _da.reserve(size_);
+  for (const Segment &_s : segments_) _da.insert(_da.end(), data(_s), data(_s) + _s.size);
+  return _da;
+}
+
+SharedDataArray DataChain::share() const {
+  if (segments_.size() == 1 && !segments_.front().array.empty()) return segments_.front().array;
+  return SharedDataArray(flatten());
+}
+
+#ifndef _WIN32
+int DataChain::toIovec(iovec *iov, int max, std::size_t first) const {
+  if (first >= segments_.size()) return 0;
+  const int _n = std::min(segments_.size() - first, static_cast<std::size_t>(max));
+  for (int i = 0; i != _n; ++i) iov[i] = {const_cast<uint8_t *>(data(segments_[first + i])), segments_[first + i].size};
+  return _n;
+}
+#endif
+
+DataChain &DataChain::insert(std::size_t i, Segment &&s) {
+  if (!s.size) return *this;
+  if (!segments_.capacity()) segments_.reserve(DATA_CHAIN_SEGMENTS);
+  size_ += s.size;
+  segments_.insert(segments_.begin() + i, std::move(s));
+  return *this;
+}
@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+#pragma once
+
+/** @file DataChain.h @brief The DataChain class. */
+
+#include <vector>
+#include "DataArray.h"
+
+struct iovec;
+
+namespace AsyncFw {
+/** @class DataChain DataChain.h <AsyncFw/DataChain> @brief A message made of byte segments that are not concatenated.
+@details A segment is shared (a SharedDataArray, appending it only changes the reference count), borrowed (a view of memory the caller keeps valid while the chain is used) or copied into the buffer of the chain, which suits small pieces such as headers. Sockets write the segments with one writev(), the bytes are concatenated only by consumers that need contiguous memory, see flatten() and share(). Copies and slices of a chain share its shared and borrowed segments.
+@brief Example:
+@code
+AsyncFw::DataChain chain;
+chain.append(header);         // copied
+chain.append(payload);        // shared
+chain.appendView(trailer);    // borrowed
+socket->write(chain);
+@endcode */
+class DataChain {
+public:
+  /** @brief Constructs an empty chain. */
+  DataChain() = default;
+  /** @brief Constructs a chain of one shared segment. */
+  DataChain(const SharedDataArray &);
+  /** @brief Appends a shared segment. */
+  DataChain &append(const SharedDataArray &);
+  /** @brief Takes over the bytes of a DataArray as a shared segment, without copying them. */
+  DataChain &append(DataArray &&);
+  /** @brief Copies the bytes into the buffer of the chain. Consecutive copied segments are merged into one. */
+  DataChain &append(const DataArrayView &);
+  /** @brief Appends the segments of another chain. */
+  DataChain &append(const DataChain &);
+  /** @brief Appends borrowed bytes. @warning The memory must stay valid while the chain or a copy of it is used, see detached(). */
+  DataChain &appendView(const DataArrayView &);
+  /** @brief Prepends a shared segment. */
+  DataChain &prepend(const SharedDataArray &);
+  /** @brief Prepends the bytes of a DataArray as a shared segment, without copying them. */
+  DataChain &prepend(DataArray &&);
+  /** @brief Prepends a copy of the bytes. */
+  DataChain &prepend(const DataArrayView &);
+  /** @brief Prepends borrowed bytes, see appendView(). */
+  DataChain &prependView(const DataArrayView &);
+  /** @brief Returns a part of the chain, sharing its segments. @param i The starting index. @param j The length. If 0, captures everything up to the end of the chain. */
+  DataChain slice(std::size_t = 0, std::size_t = 0) const;
+  /** @brief Returns a copy without borrowed segments: their bytes are copied into the buffer of the chain. Use it before the chain outlives the borrowed memory, e.g. in a queue. */
+  DataChain detached() const;
+  /** @brief Removes all segments. */
+  void clear();
+  /** @brief Returns the number of bytes. */
+  std::size_t size() const { return size_; }
+  bool empty() const { return !size_; }
+  /** @brief Returns the number of segments, empty segments are not added. */
+  std::size_t segmentCount() const { return segments_.size(); }
+  /** @brief Returns a view of a segment, valid while the chain is not modified. */
+  DataArrayView segment(std::size_t) const;
+  /** @brief Copies the bytes to the memory, which must hold size() bytes. */
+  void copy(uint8_t *) const;
+  /** @brief Concatenates the segments into a new DataArray. */
+  DataArray flatten() const;
+  /** @brief Returns the bytes as one shared array: a chain of one shared segment without copying, otherwise flattened. */
+  SharedDataArray share() const;
+#ifndef _WIN32
+  /** @brief Describes the segments for writev() or sendmsg(), without copying. @param iov Descriptors. @param max The number of descriptors. @param first The first segment to describe. @return The number of descriptors filled, less than the remaining segments if max is reached. */
+  int toIovec(iovec *, int, std::size_t = 0) const;
+#endif
+
+private:
+  struct Segment {
+    SharedDataArray array;  // shared bytes
+    const uint8_t *data;    // borrowed bytes, nullptr for shared and copied segments
+    std::size_t offset;     // copied bytes in buffer_
+    std::size_t size;
+  };
+  const uint8_t *data(const Segment &s) const { return (!s.array.empty()) ? s.array.data() : (s.data) ? s.data : buffer_.data() + s.offset; }
+  DataChain &insert(std::size_t, Segment &&);
+  std::vector<Segment> segments_;
+  DataArray buffer_;
+  std::size_t size_ = 0;
+};
+}  // namespace AsyncFw
@@ -0,0 +1,343 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+#pragma once
+
+/** @file DataStruct.h @brief The DataStruct class, reflected struct serialization for DataStream. */
+
+#include <cstring>
+#include <string>
+#include <tuple>
+#include "DataArray.h"
+
+/** @brief Lists the serialized members of a class that is not an aggregate, in wire order. Place it in a public section of the class. */
+#define dataStreamFields(...)                                  \
+  auto dataStreamTie() { return std::tie(__VA_ARGS__); }       \
+  auto dataStreamTie() const { return std::tie(__VA_ARGS__); }
+
+namespace AsyncFw {
+/** @class DataStruct DataStruct.h <AsyncFw/DataStruct> @brief Serializes structs with DataStream without hand-written operators.
+@details The fields of an aggregate are enumerated with structured bindings (up to 16 fields), other classes list them with dataStreamFields(). A field can be an arithmetic or enum value, std::string, DataArray, DataArrayList, a std::vector of trivially copyable values or another such struct.
+The fields are written in declaration order with the bytes the matching DataStream operators write (bool and char as the promoted int, like operator<<), so a reflected message reads back with hand-written operators and vice versa. A struct made only of arithmetic, enum and such nested fields has a fixed size known at compile time, it is packed into one block and read with a single bounds check.
+Versioned<T> prefixes a message with schema<T>(), a hash of the wire layout and of an optional static member dataStreamVersion, and a reader with another schema fails.
+@brief Example:
+@code
+struct Sample {
+  uint64_t time;
+  double value;
+  std::string name;
+};
+Sample _sample {1, 2.5, "t1"};
+DataStream _ds;
+_ds << _sample << DataStruct::versioned(_sample);
+@endcode */
+struct DataStruct {
+  /** @brief A message prefixed with its schema hash. */
+  template <typename T>
+  struct Versioned {
+    T &value;
+  };
+  /** @brief Wraps a message to be written or read with its schema hash. */
+  template <typename T>
+  static Versioned<T> versioned(T &v) {
+    return {v};
+  }
+
+  /** @brief True for a type with reflected fields, all of them serializable. */
+  template <typename T>
+  static constexpr bool reflected() {
+    if constexpr (!std::is_class_v<T> || std::is_same_v<T, DataArray> || std::is_same_v<T, DataArrayList> || std::is_same_v<T, std::string>) return false;
+    else if constexpr (requires(T &t) { t.dataStreamTie(); }) return fieldsSerializable<decltype(std::declval<T &>().dataStreamTie())>();
+    else if constexpr (std::is_aggregate_v<T> && !std::is_array_v<T> && fieldCount<T>() != 0 && fieldCount<T>() <= 16) return fieldsSerializable<decltype(tie(std::declval<T &>()))>();
+    else return false;
+  }
+
+  /** @brief Returns the encoded size of a type with a fixed layout, 0 for a type with a variable one. */
+  template <typename T>
+  static constexpr std::size_t fixedSize() {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) return sizeof(Wire<T>);
+    else if constexpr (reflected<T>()) return fieldsFixedSize<decltype(tie(std::declval<T &>()))>();
+    else return 0;
+  }
+
+  /** @brief Returns a hash of the wire layout of a reflected type and of its dataStreamVersion. */
+  template <typename T>
+  static constexpr uint32_t schema() {
+    static_assert(reflected<T>(), "DataStruct::schema() requires a type with reflected serializable fields");
+    uint32_t _h = fieldsSchema<decltype(tie(std::declval<T &>()))>(2166136261u);
+    if constexpr (requires { T::dataStreamVersion; }) _h = mix(_h, static_cast<uint32_t>(T::dataStreamVersion));
+    return _h;
+  }
+
+  /** @brief Returns the fields of a reflected object as a tuple of references. */
+  template <typename T>
+  static auto tie(T &t) {
+    if constexpr (requires { t.dataStreamTie(); }) return t.dataStreamTie();
+    else return aggregateTie(t);
+  }
+
+  /** @brief Writes the fields of a reflected object. */
+  template <typename T>
+  static void write(DataStream &ds, const T &t) {
+    constexpr std::size_t _s = fixedSize<T>();
+    if constexpr (_s != 0) {
+      uint8_t _b[_s];
+      pack(_b, t);
+      ds.writeBytes(_b, _s);
+    } else {
+      std::apply([&ds](const auto &...f) { (writeField(ds, f), ...); }, tie(t));
+    }
+  }
+
+  /** @brief Reads the fields of a reflected object, on failure the stream fails and the object is partially read. */
+  template <typename T>
+  static void read(DataStream &ds, T &t) {
+    constexpr std::size_t _s = fixedSize<T>();
+    if constexpr (_s != 0) {
+      uint8_t _b[_s];
+      ds.readBytes(_b, _s);
+      if (!ds.fail()) unpack(_b, t);
+    } else {
+      std::apply([&ds](auto &...f) { (readField(ds, f), ...); }, tie(t));
+    }
+  }
+
+private:
+  struct Any {
+    template <typename U>
+    operator U() const;
+  };
+
+  // DataStream has operators for the fixed width integers, other integral types (bool, char, wchar_t...) are written as promoted
+  template <typename T, bool = std::is_integral_v<T> && !std::is_same_v<T, int8_t> && !std::is_same_v<T, uint8_t> && !std::is_same_v<T, int16_t> && !std::is_same_v<T, uint16_t>>
+  struct Promoted {
+    using type = T;
+  };
+  template <typename T>
+  struct Promoted<T, true> {
+    using type = decltype(+T());
+  };
+  template <typename T>
+  using Wire = typename Promoted<T>::type;
+
+  template <typename T>
+  struct Vector : std::false_type {};
+  template <typename T>
+  struct Vector<std::vector<T>> : std::true_type {};
+
+  template <typename T, typename... A>
+  static constexpr std::size_t fieldCount() {
+    if constexpr (sizeof...(A) > 16) return 0;
+    else if constexpr (requires { T {A {}..., Any {}}; }) return fieldCount<T, A..., Any>();
+    else return sizeof...(A);
+  }
+
+  template <typename T>
+  static auto aggregateTie(T &t) {
+    constexpr std::size_t _n = fieldCount<std::remove_const_t<T>>();
+    if constexpr (_n == 1) {
+      auto &[_0] = t;
+      return std::tie(_0);
+    }
+    else if constexpr (_n == 2) {
+      auto &[_0, _1] = t;
+      return std::tie(_0, _1);
+    }
+    else if constexpr (_n == 3) {
+      auto &[_0, _1, _2] = t;
+      return std::tie(_0, _1, _2);
+    }
+    else if constexpr (_n == 4) {
+      auto &[_0, _1, _2, _3] = t;
+      return std::tie(_0, _1, _2, _3);
+    }
+    else if constexpr (_n == 5) {
+      auto &[_0, _1, _2, _3, _4] = t;
+      return std::tie(_0, _1, _2, _3, _4);
+    }
+    else if constexpr (_n == 6) {
+      auto &[_0, _1, _2, _3, _4, _5] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5);
+    }
+    else if constexpr (_n == 7) {
+      auto &[_0, _1, _2, _3, _4, _5, _6] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6);
+    }
+    else if constexpr (_n == 8) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7);
+    }
+    else if constexpr (_n == 9) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8);
+    }
+    else if constexpr (_n == 10) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8, _9] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9);
+    }
+    else if constexpr (_n == 11) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10);
+    }
+    else if constexpr (_n == 12) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11);
+    }
+    else if constexpr (_n == 13) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12);
+    }
+    else if constexpr (_n == 14) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13);
+    }
+    else if constexpr (_n == 15) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14);
+    }
+    else if constexpr (_n == 16) {
+      auto &[_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15] = t;
+      return std::tie(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15);
+    }
+  }
+
+  template <typename F>
+  static constexpr bool serializable() {
+    using T = std::remove_cvref_t<F>;
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_same_v<T, std::string> || std::is_same_v<T, DataArray> || std::is_same_v<T, DataArrayList>) return true;
+    else if constexpr (Vector<T>::value) return std::is_trivially_copyable_v<typename T::value_type> && !std::is_same_v<typename T::value_type, bool>;
+    else return reflected<T>();
+  }
+
+  template <typename Tuple, std::size_t... I>
+  static constexpr bool fieldsSerializable(std::index_sequence<I...>) {
+    return (serializable<std::tuple_element_t<I, Tuple>>() && ...);
+  }
+  template <typename Tuple>
+  static constexpr bool fieldsSerializable() {
+    return fieldsSerializable<Tuple>(std::make_index_sequence<std::tuple_size_v<Tuple>>());
+  }
+
+  template <typename Tuple, std::size_t... I>
+  static constexpr std::size_t fieldsFixedSize(std::index_sequence<I...>) {
+    if constexpr (((fixedSize<std::remove_cvref_t<std::tuple_element_t<I, Tuple>>>() != 0) && ...)) return (fixedSize<std::remove_cvref_t<std::tuple_element_t<I, Tuple>>>() + ...);
+    else return 0;
+  }
+  template <typename Tuple>
+  static constexpr std::size_t fieldsFixedSize() {
+    return fieldsFixedSize<Tuple>(std::make_index_sequence<std::tuple_size_v<Tuple>>());
+  }
+
+  static constexpr uint32_t mix(uint32_t h, uint32_t v) {
+    for (int i = 0; i != 4; ++i, v >>= 8) h = (h ^ (v & 0xff)) * 16777619u;
+    return h;
+  }
+
+  template <typename F>
+  static constexpr uint32_t fieldSchema(uint32_t h) {
+    using T = std::remove_cvref_t<F>;
+    if constexpr (std::is_enum_v<T>) return fieldSchema<std::underlying_type_t<T>>(h);
+    else if constexpr (std::is_floating_point_v<T>) return mix(h, 0x300 | sizeof(T));
+    else if constexpr (std::is_arithmetic_v<T>) return mix(h, ((std::is_signed_v<Wire<T>>) ? 0x200 : 0x100) | sizeof(Wire<T>));
+    else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, DataArray>) return mix(h, 0x400);  // same bytes on the wire
+    else if constexpr (std::is_same_v<T, DataArrayList>) return mix(h, 0x500);
+    else if constexpr (reflected<T>()) return mix(h, 0x700 | schema<T>());
+    else if constexpr (Vector<T>::value) return fieldSchema<typename T::value_type>(mix(h, 0x600));
+    else if constexpr (std::is_trivially_copyable_v<T>) return mix(h, 0x800 | sizeof(T));  // a vector element copied as raw bytes
+    else static_assert(sizeof(T) == 0, "DataStruct: the field type is not serializable");
+  }
+  template <typename Tuple, std::size_t... I>
+  static constexpr uint32_t fieldsSchema(uint32_t h, std::index_sequence<I...>) {
+    ((h = fieldSchema<std::tuple_element_t<I, Tuple>>(h)), ...);
+    return mix(h, sizeof...(I));
+  }
+  template <typename Tuple>
+  static constexpr uint32_t fieldsSchema(uint32_t h) {
+    return fieldsSchema<Tuple>(h, std::make_index_sequence<std::tuple_size_v<Tuple>>());
+  }
+
+  template <typename T>
+  static uint8_t *pack(uint8_t *p, const T &t) {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+      const Wire<T> _v = t;
+      std::memcpy(p, &_v, sizeof(_v));
+      return p + sizeof(_v);
+    } else {
+      std::apply([&p](const auto &...f) { ((p = pack(p, f)), ...); }, tie(t));
+      return p;
+    }
+  }
+
+  template <typename T>
+  static const uint8_t *unpack(const uint8_t *p, T &t) {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+      Wire<T> _v;
+      std::memcpy(&_v, p, sizeof(_v));
+      t = static_cast<T>(_v);  // a bool is true for any non-zero value
+      return p + sizeof(_v);
+    } else {
+      std::apply([&p](auto &...f) { ((p = unpack(p, f)), ...); }, tie(t));
+      return p;
+    }
+  }
+
+  template <typename F>
+  static void writeField(DataStream &ds, const F &f) {
+    if constexpr (std::is_arithmetic_v<F> || std::is_enum_v<F>) {
+      const Wire<F> _v = f;
+      ds.writeBytes(&_v, sizeof(_v));
+    } else if constexpr (reflected<F>()) write(ds, f);
+    else ds << f;
+  }
+
+  template <typename F>
+  static void readField(DataStream &ds, F &f) {
+    if constexpr (std::is_arithmetic_v<F> || std::is_enum_v<F>) {
+      uint8_t _b[sizeof(Wire<F>)];
+      ds.readBytes(_b, sizeof(_b));
+      if (!ds.fail()) unpack(_b, f);
+    } else if constexpr (reflected<F>()) read(ds, f);
+    else ds >> f;
+  }
+};
+
+/** @brief Writes a reflected struct. */
+template <typename T>
+  requires(DataStruct::reflected<T>())
+DataStream &operator<<(DataStream &ds, const T &t) {
+  DataStruct::write(ds, t);
+  return ds;
+}
+/** @brief Reads a reflected struct. */
+template <typename T>
+  requires(DataStruct::reflected<T>())
+DataStream &operator>>(DataStream &ds, T &t) {
+  DataStruct::read(ds, t);
+  return ds;
+}
+/** @brief Writes a reflected struct prefixed with its schema hash. */
+template <typename T>
+DataStream &operator<<(DataStream &ds, const DataStruct::Versioned<T> &v) {
+  uint32_t _h = DataStruct::schema<std::remove_const_t<T>>();
+  ds << _h;
+  DataStruct::write(ds, v.value);
+  return ds;
+}
+/** @brief Reads a reflected struct prefixed with its schema hash, a different hash fails the stream. */
+template <typename T>
+DataStream &operator>>(DataStream &ds, const DataStruct::Versioned<T> &v) {
+  uint32_t _h = 0;
+  ds >> _h;
+  if (ds.fail()) return ds;
+  if (_h != DataStruct::schema<T>()) {
+    ds.setFailed();
+    return ds;
+  }
+  DataStruct::read(ds, v.value);
+  return ds;
+}
+}  // namespace AsyncFw
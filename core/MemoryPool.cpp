@@ -0,0 +1,214 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+#include <atomic>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#ifdef __linux__
+  #include <sys/mman.h>
+#endif
+#include "MemoryPool.h"
+
+#ifndef MEMORY_POOL_MAX_SIZE
+  #define MEMORY_POOL_MAX_SIZE (256 * 1024)
+#endif
+
+#ifndef MEMORY_POOL_SPAN_SIZE
+  #define MEMORY_POOL_SPAN_SIZE (2 * 1024 * 1024)
+#endif
+
+#ifndef MEMORY_POOL_CACHE_SIZE
+  #define MEMORY_POOL_CACHE_SIZE (512 * 1024)
+#endif
+
+using namespace AsyncFw;
+
+namespace {
+constexpr unsigned MinShift = 5;
+constexpr std::size_t MinSize = std::size_t(1) << MinShift;
+constexpr std::size_t MaxSize = std::bit_ceil(std::size_t(MEMORY_POOL_MAX_SIZE));
+constexpr std::size_t Classes = (std::bit_width(MaxSize - 1) - MinShift) * 2 + 1;
+static_assert(MaxSize * 2 <= MEMORY_POOL_SPAN_SIZE, "MEMORY_POOL_SPAN_SIZE too small");
+
+struct Block {
+  Block *next;
+};
+
+struct Class {
+  std::size_t size;  // block size
+  uint32_t limit;    // blocks kept in a thread cache
+};
+
+constexpr std::array<Class, Classes> classes = []() {
+  std::array<Class, Classes> _a {};
+  for (std::size_t i = 0; i != Classes; ++i) {
+    _a[i].size = (i & 1) ? std::size_t(3) << (MinShift - 1 + i / 2) : std::size_t(1) << (MinShift + i / 2);
+    _a[i].limit = static_cast<uint32_t>(std::clamp<std::size_t>(MEMORY_POOL_CACHE_SIZE / _a[i].size, 4, 512));
+  }
+  return _a;
+}();
+
+inline std::size_t sizeClass(std::size_t n) {
+  if (n <= MinSize) return 0;
+  unsigned b = std::bit_width(n - 1);
+  std::size_t c = (b - MinShift) * 2;
+  return (n <= std::size_t(3) << (b - 2)) ? c - 1 : c;
+}
+
+struct Central {
+  std::mutex mutex;
+  Block *list = nullptr;
+};
+
+struct Pool {
+  Central central[Classes];
+  std::mutex mutex;  // span
+  uint8_t *span = nullptr;
+  uint8_t *spanEnd = nullptr;
+  std::atomic<std::size_t> reserved {0};
+  std::atomic<bool> hugePages {false};
+
+  void push(std::size_t i, Block *first, Block *last) {
+    std::lock_guard<std::mutex> lock(central[i].mutex);
+    last->next = central[i].list;
+    central[i].list = first;
+  }
+
+  Block *pop(std::size_t i, uint32_t n) {
+    std::lock_guard<std::mutex> lock(central[i].mutex);
+    Block *_first = central[i].list;
+    if (!_first) return nullptr;
+    Block *_last = _first;
+    while (--n && _last->next) _last = _last->next;
+    central[i].list = _last->next;
+    _last->next = nullptr;
+    return _first;
+  }
+
+  void newSpan() {
+    std::size_t _size = MEMORY_POOL_SPAN_SIZE;
+#ifdef __linux__
+    if (hugePages.load(std::memory_order_relaxed)) {
+      void *_p = mmap(nullptr, _size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (_p == MAP_FAILED) throw std::bad_alloc();
+      uint8_t *_begin = static_cast<uint8_t *>(_p);
+      uint8_t *_aligned = reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(_begin) + _size - 1) & ~(_size - 1));
+      if (_aligned != _begin) munmap(_begin, _aligned - _begin);
+      munmap(_aligned + _size, _begin + _size - _aligned);
+  #ifdef MADV_HUGEPAGE
+      madvise(_aligned, _size, MADV_HUGEPAGE);
+  #endif
+      span = _aligned;
+    } else
+#endif
+      span = static_cast<uint8_t *>(::operator new(_size));
+    spanEnd = span + _size;
+    reserved.fetch_add(_size, std::memory_order_relaxed);
+  }
+
+  Block *carve(std::size_t i, uint32_t n) {
+    std::size_t _size = classes[i].size;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (static_cast<std::size_t>(spanEnd - span) < _size) {
+      for (std::size_t j = i; span && j--;) {  // hand the tail of the span to smaller classes
+        while (static_cast<std::size_t>(spanEnd - span) >= classes[j].size) {
+          Block *_b = reinterpret_cast<Block *>(span);
+          span += classes[j].size;
+          push(j, _b, _b);
+        }
+      }
+      newSpan();
+    }
+    n = static_cast<uint32_t>(std::min<std::size_t>(n, (spanEnd - span) / _size));
+    Block *_first = reinterpret_cast<Block *>(span);
+    Block *_b = _first;
+    for (uint32_t k = 1; k != n; ++k) _b = _b->next = reinterpret_cast<Block *>(span + k * _size);
+    _b->next = nullptr;
+    span += n * _size;
+    return _first;
+  }
+};
+
+Pool &pool() {
+  static Pool *_pool = new Pool;  // never destroyed, blocks may be freed during static destruction
+  return *_pool;
+}
+
+struct Cache {
+  Block *list[Classes] {};
+  uint32_t count[Classes] {};
+  bool closed = false;
+
+  ~Cache() {
+    for (std::size_t i = 0; i != Classes; ++i)
+      if (list[i]) release(i, count[i]);
+    closed = true;
+  }
+
+  void refill(std::size_t i) {
+    uint32_t _n = (classes[i].limit + 1) / 2;
+    Block *_b = pool().pop(i, _n);
+    if (!_b) _b = pool().carve(i, _n);
+    list[i] = _b;
+    for (count[i] = 0; _b; _b = _b->next) ++count[i];
+  }
+
+  void release(std::size_t i, uint32_t n) {
+    Block *_first = list[i];
+    Block *_last = _first;
+    for (uint32_t k = 1; k != n; ++k) _last = _last->next;
+    list[i] = _last->next;
+    count[i] -= n;
+    pool().push(i, _first, _last);
+  }
+};
+
+thread_local Cache cache_;
+}  // namespace
+
+void *MemoryPool::allocate(std::size_t n) {
+  if (n > MaxSize) return ::operator new(n);
+  std::size_t i = sizeClass(n);
+  Cache &_cache = cache_;
+  if (_cache.closed) {
+    Block *_b = pool().pop(i, 1);
+    return _b ? _b : pool().carve(i, 1);
+  }
+  if (!_cache.list[i]) _cache.refill(i);
+  Block *_b = _cache.list[i];
+  _cache.list[i] = _b->next;
+  --_cache.count[i];
+  return _b;
+}
+
+void MemoryPool::deallocate(void *p, std::size_t n) noexcept {
+  if (!p) return;
+  if (n > MaxSize) {
+    ::operator delete(p);
+    return;
+  }
+  std::size_t i = sizeClass(n);
+  Block *_b = static_cast<Block *>(p);
+  Cache &_cache = cache_;
+  if (_cache.closed) {
+    pool().push(i, _b, _b);
+    return;
+  }
+  _b->next = _cache.list[i];
+  _cache.list[i] = _b;
+  if (++_cache.count[i] > classes[i].limit) _cache.release(i, _cache.count[i] / 2);
+}
+
+std::size_t MemoryPool::maxSize() { return MaxSize; }
+
+std::size_t MemoryPool::reserved() { return pool().reserved.load(std::memory_order_relaxed); }
+
+void MemoryPool::setHugePages(bool b) { pool().hugePages.store(b, std::memory_order_relaxed); }
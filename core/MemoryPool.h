@@ -0,0 +1,46 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+#pragma once
+
+/** @file MemoryPool.h @brief The MemoryPool class. */
+
+#include <cstddef>
+
+namespace AsyncFw {
+/** @class MemoryPool MemoryPool.h <AsyncFw/MemoryPool> @brief A size-class pooled allocator with per-thread caches.
+@details Blocks up to maxSize() bytes are rounded up to one of the size classes (two per power of two) and served from a cache of the calling thread without locking. A block can be freed by any thread, it goes to the cache of the freeing thread; a cache that grows over its limit returns half of it to a central list of the class, where other threads refill from. Memory is taken from the system in spans and kept for reuse, larger blocks go directly to operator new.
+The pool becomes the allocator of DataArray, and so of socket buffers, received frames, DataStream output and Rrd items, when the library is built with USE_DATA_ARRAY_POOL. */
+class MemoryPool {
+public:
+  /** @brief Allocates a block of at least the given size, aligned to 16 bytes. */
+  static void *allocate(std::size_t);
+  /** @brief Frees a block, the size must be the one passed to allocate(). */
+  static void deallocate(void *, std::size_t) noexcept;
+  /** @brief Returns the largest block size served from the pool. */
+  static std::size_t maxSize();
+  /** @brief Returns the number of bytes taken from the system for the pool. */
+  static std::size_t reserved();
+  /** @brief Backs new spans by transparent huge pages, where the system supports them. Call it before the first allocation. */
+  static void setHugePages(bool);
+
+  /** @brief The standard allocator interface over the pool. */
+  template <typename T>
+  struct Allocator {
+    using value_type = T;
+    Allocator() noexcept = default;
+    template <typename U>
+    Allocator(const Allocator<U> &) noexcept {}
+    T *allocate(std::size_t n) { return static_cast<T *>(MemoryPool::allocate(n * sizeof(T))); }
+    void deallocate(T *p, std::size_t n) noexcept { MemoryPool::deallocate(p, n * sizeof(T)); }
+    template <typename U>
+    bool operator==(const Allocator<U> &) const noexcept {
+      return true;
+    }
+  };
+};
+}  // namespace AsyncFw
@@ -6,6 +6,8 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 */
 
 #include <signal.h>
+#include <algorithm>
+#include <bit>
 #include "core/AbstractSocket.h"
 #include "core/LogStream.h"
 #include "Thread.h"
@@ -15,6 +17,10 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #endif
 #include "core/extend_trace.hpp"
 
+#ifndef THREAD_TCP_INFO_TICK
+  #define THREAD_TCP_INFO_TICK 100
+#endif
+
 using namespace AsyncFw;
 
 bool Thread::Compare::operator()(const AbstractSocket *_s1, const AbstractSocket *_s2) const {
@@ -28,6 +34,9 @@ Thread::Thread(const std::string &name) : AbstractThread(name) { trace(); }
 
 Thread::~Thread() {
   destroying();
+  if (tcpInfoTimer_ >= 0) removeTimer(tcpInfoTimer_);
+  if (budgetTimer_ >= 0) removeTimer(budgetTimer_);
+  if (idleTimer_ >= 0) removeTimer(idleTimer_);
   warning_if(!sockets_.empty()) << "socket list not empty" << sockets_.size();
   if (AbstractThread::running()) {
     lsWarning() << "destroy running thread" << '(' + name() + ')';
@@ -42,6 +51,72 @@ Thread::~Thread() {
   }
 }
 
+void Thread::setTcpInfoInterval(int ms) {
+  auto _f = [this, ms]() {
+    if (tcpInfoTimer_ >= 0) removeTimer(tcpInfoTimer_);
+    tcpInfoTimer_ = -1;
+    tcpInfoInterval_ = (ms > 0) ? ms : 0;
+    if (tcpInfoInterval_) tcpInfoTimer_ = appendTimerTask(std::min(tcpInfoInterval_, THREAD_TCP_INFO_TICK), [this]() { sampleTcpInfo(); });
+  };
+  if (std::this_thread::get_id() == id()) _f();
+  else invoke(_f);
+}
+
+void Thread::setIdleTimeout(int ms) {
+  auto _f = [this, ms]() {
+    if (idleTimer_ >= 0) removeTimer(idleTimer_);
+    idleTimer_ = -1;
+    idleTimeout_ = (ms > 0) ? ms : 0;
+    if (idleTimeout_) idleTimer_ = appendTimerTask(idleTimeout_, [this]() { checkIdle(); });
+  };
+  if (std::this_thread::get_id() == id()) _f();
+  else invoke(_f);
+}
+
+TcpInfoSummary Thread::tcpInfoSummary() const {
+  TcpInfoSummary _s;
+  invoke([this, &_s]() {
+    for (const AbstractSocket *_socket : sockets_) _s.append(_socket->tcpInfo());
+  }, true);
+  return _s;
+}
+
+LatencyHistogram Thread::receiveLatency(bool reset) {
+  LatencyHistogram _h;
+  invoke([this, &_h, reset]() {
+    _h = receiveLatency_;
+    if (reset) receiveLatency_ = {};
+  }, true);
+  return _h;
+}
+
+void Thread::sampleTcpInfo() {
+  if (sockets_.empty()) return;
+  const std::size_t _size = sockets_.size();
+  const int _tick = std::min(tcpInfoInterval_, THREAD_TCP_INFO_TICK);
+  std::size_t _n = (_size * _tick + tcpInfoInterval_ - 1) / tcpInfoInterval_;
+  if (tcpInfoIndex_ >= _size) tcpInfoIndex_ = 0;
+  for (; _n; --_n) {
+    sockets_[tcpInfoIndex_]->sampleTcpInfo();
+    if (++tcpInfoIndex_ == _size) tcpInfoIndex_ = 0;
+  }
+}
+
+void Thread::checkBudget() {
+  bool _paused = false;
+  // resuming only schedules the read, the list is not modified here
+  for (AbstractSocket *_socket : sockets_)
+    if (_socket->checkBudget()) _paused = true;
+  if (_paused) return;
+  removeTimer(budgetTimer_);
+  budgetTimer_ = -1;
+}
+
+void Thread::checkIdle() {
+  // releasing the buffers does not modify the list
+  for (AbstractSocket *_socket : sockets_) _socket->checkIdle();
+}
+
 void Thread::startedEvent() {
 #ifndef _WIN32
   sigset_t _s;
@@ -58,7 +133,33 @@ void Thread::finishedEvent() {
   finished();
 }
 
+void LatencyHistogram::append(uint64_t us) {
+  ++counts[std::min<int>(std::bit_width(us), 31)];
+  ++count;
+  total += us;
+  max = std::max(max, us);
+}
+
+void LatencyHistogram::append(const LatencyHistogram &histogram) {
+  for (int i = 0; i != 32; ++i) counts[i] += histogram.counts[i];
+  count += histogram.count;
+  total += histogram.total;
+  max = std::max(max, histogram.max);
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+  const uint64_t _n = static_cast<uint64_t>(count * percent / 100 + 0.5);
+  uint64_t _c = 0;
+  for (int i = 0; i != 32; ++i) {
+    _c += counts[i];
+    if (_c >= _n && _c) return std::min<uint64_t>(uint64_t(1) << i, max);
+  }
+  return max;
+}
+
 namespace AsyncFw {
+LogStream &operator<<(LogStream &log, const LatencyHistogram &h) { return log << "count:" << h.count << "us avg:" << h.average() << "p50:" << h.percentile(50) << "p99:" << h.percentile(99) << "max:" << h.max; }
+
 LogStream &operator<<(LogStream &log, const Thread &t) {
   int _size;
   t.invoke([&t, &_size]() { _size = t.sockets_.size(); }, true);
@@ -9,10 +9,30 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 /** @file Thread.h @brief The Thread class. */
 
+#include <cstdint>
+#include <atomic>
 #include "FunctionConnector.h"
 
 namespace AsyncFw {
 class AbstractSocket;
+struct TcpInfoSummary;
+
+/** @struct LatencyHistogram Thread.h <AsyncFw/Thread> @brief Log2 histogram of latencies in microseconds. */
+struct LatencyHistogram {
+  uint64_t counts[32] = {};  ///< counts[i] holds the latencies from 2^(i-1) up to 2^i microseconds, counts[0] the ones below a microsecond and the last bucket all longer ones.
+  uint64_t count = 0;        ///< Number of latencies.
+  uint64_t total = 0;        ///< Sum of the latencies in microseconds.
+  uint64_t max = 0;          ///< Maximum latency in microseconds.
+  /** @brief Adds a latency. @param us Latency in microseconds. */
+  void append(uint64_t);
+  /** @brief Merges another histogram. @param histogram Histogram. */
+  void append(const LatencyHistogram &);
+  /** @brief Returns the upper bound of the bucket holding the percentile, in microseconds. @param percent Percentile, 0 to 100. */
+  uint64_t percentile(double) const;
+  /** @brief Returns the average latency in microseconds. */
+  uint64_t average() const { return (count) ? total / count : 0; }
+};
+LogStream &operator<<(LogStream &, const LatencyHistogram &);
 
 /** @class Thread Thread.h <AsyncFw/Thread> @brief AsyncFw::Thread thread with sockets. */
 class Thread : public AbstractThread {
@@ -27,6 +47,23 @@ public:
   Thread(const std::string & = "Thread");
   ~Thread() override;
 
+  /** @brief Samples the kernel TCP state (AbstractSocket::sampleTcpInfo()) of the connected sockets of the thread periodically. @details One timer serves all sockets: each tick samples the next slice, so every socket is sampled once per interval and the cost is spread over the interval. @param ms Interval in milliseconds, zero stops sampling. @note Called from another thread it takes effect asynchronously. */
+  void setTcpInfoInterval(int);
+  /** @brief Returns the sampling interval set by setTcpInfoInterval(). */
+  int tcpInfoInterval() const { return tcpInfoInterval_; }
+  /** @brief Aggregates the last samples of the sockets of the thread. @return Summary. */
+  TcpInfoSummary tcpInfoSummary() const;
+  /** @brief Records the kernel-arrival-to-dispatch latency of data received by a socket of the thread (see AbstractSocket::setReceiveTimestamps()). @param us Latency in microseconds. @note Call from the thread. */
+  void appendReceiveLatency(uint64_t us) { receiveLatency_.append(us); }
+  /** @brief Returns the histogram of the receive latencies recorded by appendReceiveLatency(). @param reset Clears the histogram. */
+  LatencyHistogram receiveLatency(bool = false);
+  /** @brief Releases the buffer memory of idle connections: a connected socket of the thread without traffic for the idle time gets AbstractSocket::idleEvent(). @details One timer checks all sockets once per idle time, a socket is released after one to two idle times without traffic. @param ms Idle time in milliseconds, zero disables the release. @note Called from another thread it takes effect asynchronously. */
+  void setIdleTimeout(int);
+  /** @brief Returns the idle time set by setIdleTimeout(). */
+  int idleTimeout() const { return idleTimeout_; }
+  /** @brief Returns the buffer memory accounted by the sockets of the thread in the BufferBudget, in bytes. Thread-safe. */
+  int64_t bufferUsage() const { return bufferUsage_; }
+
   /** @brief Signal emitted within the newly spawned thread context immediately after its event loop starts.
   @note Defaults to a Direct connection policy. Subscribers execute instantly inside the target thread frame unless explicitly overridden. */
   FunctionConnector<>::Policy<AbstractFunctionConnector::Direct>::Protected<Thread> started;
@@ -51,5 +88,16 @@ private:
   struct Compare {
     bool operator()(const AbstractSocket *, const AbstractSocket *) const;
   };
+  void sampleTcpInfo();
+  void checkBudget();
+  void checkIdle();
+  int tcpInfoInterval_ = 0;
+  int tcpInfoTimer_ = -1;
+  std::size_t tcpInfoIndex_ = 0;
+  LatencyHistogram receiveLatency_;
+  std::atomic<int64_t> bufferUsage_ = 0;
+  int budgetTimer_ = -1;
+  int idleTimeout_ = 0;
+  int idleTimer_ = -1;
 };
 }  // namespace AsyncFw
@@ -9,17 +9,41 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #include <openssl/err.h>
 #include <openssl/core_names.h>
 #include <openssl/x509v3.h>
+#include <openssl/rand.h>
 
 #include <atomic>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "AbstractThread.h"
 #include "DataArray.h"
 #include "LogStream.h"
 #include "TlsContext.h"
 
+#ifndef TLS_TICKET_KEYS
+  #define TLS_TICKET_KEYS 3
+#endif
+
+#ifndef TLS_CLIENT_SESSIONS
+  #define TLS_CLIENT_SESSIONS 1024
+#endif
+
 using namespace AsyncFw;
 
 struct TlsContext::Private {
+  struct TicketKey {
+    uint8_t name[16];
+    uint8_t aes[32];
+    uint8_t hmac[32];
+    std::chrono::steady_clock::time_point time;
+  };
   ~Private() {
+    for (std::pair<std::string, SSL_SESSION *> &_s : sessions) SSL_SESSION_free(_s.second);
     if (ctx) {
       std::vector<Private *>::iterator it = lower_bound(verify.begin(), verify.end(), this, [](const Private *p1, const Private *p2) { return p1->ctx < p2->ctx; });
       if (it != verify.end()) { verify.erase(it); }
@@ -34,15 +58,98 @@ struct TlsContext::Private {
   std::string info(X509 *);
 
   bool vefifyPeer = true;
+  bool kernelTls = false;
+  bool releaseBuffers = false;
   std::string verifyName;
 
   int serial = 0;
   std::atomic_int ref = 1;
   uint8_t ignoreErrors = 0;
 
+  std::mutex mutex;  // client sessions and ticket keys are used from the socket threads
+  std::list<std::pair<std::string, SSL_SESSION *>> sessions;  // the most recently used first, the least recently used is evicted
+  std::unordered_map<std::string, std::list<std::pair<std::string, SSL_SESSION *>>::iterator> sessionIndex;
+  std::deque<TicketKey> ticketKeys;
+  int ticketRotation = 0;
+  std::vector<AbstractThread *> handshakeThreads;
+
   static inline std::vector<Private *> verify;
+
+  void create();
+  bool rotateTicketKeys();
+  static int newSession(SSL *, SSL_SESSION *);
+  static int ticketKey(SSL *, unsigned char *, unsigned char *, EVP_CIPHER_CTX *, EVP_MAC_CTX *, int);
 };
 
+void TlsContext::Private::create() {
+  if (ctx) return;
+  ctx = SSL_CTX_new(TLS_method());
+  SSL_CTX_set_app_data(ctx, this);
+  // servers cache sessions internally, client sessions are stored per peer by newSession()
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_CLIENT);
+  SSL_CTX_set_session_id_context(ctx, reinterpret_cast<const unsigned char *>("AsyncFw"), 7);
+  SSL_CTX_sess_set_new_cb(ctx, newSession);
+  SSL_CTX_set_num_tickets(ctx, 1);  // clients keep one ticket per peer, a second one is a separate small write delayed by Nagle
+}
+
+int TlsContext::Private::newSession(SSL *ssl, SSL_SESSION *session) {
+  const std::string *_peer = static_cast<const std::string *>(SSL_get_app_data(ssl));
+  if (SSL_is_server(ssl) || !_peer || _peer->empty()) return 0;
+  // a copy: OpenSSL marks the session of the connection not resumable if it is closed without close_notify, e.g. by the peer
+  SSL_SESSION *_s = SSL_SESSION_dup(session);
+  if (!_s) return 0;
+  Private *_p = static_cast<Private *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  std::lock_guard<std::mutex> lock(_p->mutex);
+  std::unordered_map<std::string, std::list<std::pair<std::string, SSL_SESSION *>>::iterator>::iterator it = _p->sessionIndex.find(*_peer);
+  if (it != _p->sessionIndex.end()) {
+    SSL_SESSION_free(it->second->second);
+    it->second->second = _s;
+    _p->sessions.splice(_p->sessions.begin(), _p->sessions, it->second);
+    return 0;
+  }
+  if (_p->sessions.size() >= TLS_CLIENT_SESSIONS) {
+    SSL_SESSION_free(_p->sessions.back().second);
+    _p->sessionIndex.erase(_p->sessions.back().first);
+    _p->sessions.pop_back();
+  }
+  _p->sessions.emplace_front(*_peer, _s);
+  _p->sessionIndex.emplace(*_peer, _p->sessions.begin());
+  return 0;
+}
+
+bool TlsContext::Private::rotateTicketKeys() {
+  const std::chrono::steady_clock::time_point _t = std::chrono::steady_clock::now();
+  if (!ticketKeys.empty() && _t - ticketKeys.front().time < std::chrono::seconds(ticketRotation)) return true;
+  TicketKey _k;
+  if (RAND_bytes(_k.name, sizeof(_k.name)) <= 0 || RAND_bytes(_k.aes, sizeof(_k.aes)) <= 0 || RAND_bytes(_k.hmac, sizeof(_k.hmac)) <= 0) return false;
+  _k.time = _t;
+  ticketKeys.push_front(_k);
+  if (ticketKeys.size() > TLS_TICKET_KEYS) ticketKeys.pop_back();
+  lsDebug() << "ticket key rotated";
+  return true;
+}
+
+int TlsContext::Private::ticketKey(SSL *ssl, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx, int enc) {
+  Private *_p = static_cast<Private *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  std::lock_guard<std::mutex> lock(_p->mutex);
+  if (!_p->rotateTicketKeys()) return -1;
+  std::size_t i = 0;
+  if (enc) {
+    memcpy(name, _p->ticketKeys.front().name, sizeof(TicketKey::name));
+    if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) <= 0) return -1;
+  } else {
+    for (; i != _p->ticketKeys.size() && memcmp(name, _p->ticketKeys[i].name, sizeof(TicketKey::name)); ++i);
+    if (i == _p->ticketKeys.size()) return 0;  // unknown or expired key, full handshake
+  }
+  TicketKey &_k = _p->ticketKeys[i];
+  OSSL_PARAM _params[] = {OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, _k.hmac, sizeof(_k.hmac)), OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char *>("SHA256"), 0), OSSL_PARAM_construct_end()};
+  if (!EVP_MAC_CTX_set_params(hctx, _params)) return -1;
+  if (enc) return (EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, _k.aes, iv)) ? 1 : -1;
+  if (!EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, _k.aes, iv)) return -1;
+  // a ticket of an older key is renewed, TLS 1.3 tickets are always renewed: clients use them once
+  return (i || SSL_version(ssl) == TLS1_3_VERSION) ? 2 : 1;
+}
+
 DataArray TlsContext::Private::key(EVP_PKEY *_k) {
   BIO *_bio = BIO_new(BIO_s_mem());
   PEM_write_bio_PrivateKey(_bio, _k, nullptr, nullptr, 0, nullptr, nullptr);
@@ -120,7 +227,7 @@ bool TlsContext::generateKey(int bits) {
     lsError() << "generate key";
     return false;
   }
-  if (!private_->ctx) private_->ctx = SSL_CTX_new(TLS_method());
+  private_->create();
   int r = SSL_CTX_use_PrivateKey(private_->ctx, _k);
   EVP_PKEY_free(_k);
   return r == 1;
@@ -461,13 +568,84 @@ bool TlsContext::verifyPeer() { return private_->vefifyPeer; }
 
 void TlsContext::setVerifyPeer(bool enable) { private_->vefifyPeer = enable; }
 
+void TlsContext::setSessionCache(int size, int timeout) {
+  private_->create();
+  if (size <= 0) {
+    SSL_CTX_set_session_cache_mode(private_->ctx, SSL_SESS_CACHE_CLIENT);
+    return;
+  }
+  SSL_CTX_set_session_cache_mode(private_->ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_CLIENT);
+  SSL_CTX_sess_set_cache_size(private_->ctx, size);
+  SSL_CTX_set_timeout(private_->ctx, timeout);
+}
+
+void TlsContext::setSessionTickets(int rotation) {
+  private_->create();
+  private_->ticketRotation = rotation;
+  if (rotation <= 0) {
+    SSL_CTX_set_options(private_->ctx, SSL_OP_NO_TICKET);
+    return;
+  }
+  SSL_CTX_clear_options(private_->ctx, SSL_OP_NO_TICKET);
+  SSL_CTX_set_tlsext_ticket_key_evp_cb(private_->ctx, Private::ticketKey);
+}
+
+void TlsContext::clearSessions() {
+  std::lock_guard<std::mutex> lock(private_->mutex);
+  for (std::pair<std::string, SSL_SESSION *> &_s : private_->sessions) SSL_SESSION_free(_s.second);
+  private_->sessions.clear();
+  private_->sessionIndex.clear();
+}
+
+ssl_session_st *TlsContext::session(const std::string &peer) const {
+  std::lock_guard<std::mutex> lock(private_->mutex);
+  std::unordered_map<std::string, std::list<std::pair<std::string, SSL_SESSION *>>::iterator>::iterator it = private_->sessionIndex.find(peer);
+  if (it == private_->sessionIndex.end()) return nullptr;
+  SSL_SESSION *_s = it->second->second;
+  const bool _valid = SSL_SESSION_is_resumable(_s) && SSL_SESSION_get_time(_s) + SSL_SESSION_get_timeout(_s) > std::time(nullptr);
+  // TLS 1.3 tickets are used once, the resumed connection receives new ones
+  if (!_valid || SSL_SESSION_get_protocol_version(_s) == TLS1_3_VERSION) {
+    private_->sessions.erase(it->second);
+    private_->sessionIndex.erase(it);
+  } else {
+    SSL_SESSION_up_ref(_s);
+    private_->sessions.splice(private_->sessions.begin(), private_->sessions, it->second);
+  }
+  if (_valid) return _s;
+  SSL_SESSION_free(_s);
+  return nullptr;
+}
+
+void TlsContext::setHandshakeThreads(const std::vector<AbstractThread *> &threads) { private_->handshakeThreads = threads; }
+
+AbstractThread *TlsContext::handshakeThread() const {
+  AbstractThread *_t = nullptr;
+  int _load = std::numeric_limits<int>::max();
+  for (AbstractThread *_h : private_->handshakeThreads) {
+    const int _l = _h->workLoad();
+    if (_l >= _load) continue;
+    _load = _l;
+    _t = _h;
+    if (!_l) break;
+  }
+  return _t;
+}
+
+bool TlsContext::kernelTls() const { return private_->kernelTls; }
+
+void TlsContext::setKernelTls(bool enable) { private_->kernelTls = enable; }
+
+bool TlsContext::releaseBuffers() const { return private_->releaseBuffers; }
+
+void TlsContext::setReleaseBuffers(bool enable) { private_->releaseBuffers = enable; }
+
 std::string &TlsContext::verifyName() const { return private_->verifyName; }
 
 void TlsContext::setVerifyName(const std::string &name) const { private_->verifyName = name; }
 
 void TlsContext::setIgnoreErrors(IgnoreErrors errors) const {
   private_->ignoreErrors = errors;
-  if (!private_->ctx) private_->ctx = SSL_CTX_new(TLS_method());
+  private_->create();
   std::vector<Private *>::iterator it = lower_bound(private_->verify.begin(), private_->verify.end(), private_, [](const Private *p1, const Private *p2) { return p1->ctx < p2->ctx; });
   if (it == private_->verify.end() || *it != private_) private_->verify.insert(it, private_);
 }
@@ -506,7 +684,7 @@ bool TlsContext::setKey(const DataArray &_da) {
   EVP_PKEY *_k = PEM_read_bio_PrivateKey(_bio, nullptr, nullptr, nullptr);
   BIO_free(_bio);
   if (!_k) return false;
-  if (!private_->ctx) private_->ctx = SSL_CTX_new(TLS_method());
+  private_->create();
   int r = SSL_CTX_use_PrivateKey(private_->ctx, _k);
   EVP_PKEY_free(_k);
   if (r == 1) return true;
@@ -522,7 +700,7 @@ bool TlsContext::setCertificate(const DataArray &_da) {
     lsError() << "read certificate";
     return false;
   }
-  if (!private_->ctx) private_->ctx = SSL_CTX_new(TLS_method());
+  private_->create();
   int r = SSL_CTX_use_certificate(private_->ctx, _c);
   X509_free(_c);
   if (r == 1) return true;
@@ -538,7 +716,7 @@ bool TlsContext::appendTrusted(const DataArray &_da) {
     lsError() << "read certificate";
     return false;
   }
-  if (!private_->ctx) private_->ctx = SSL_CTX_new(TLS_method());
+  private_->create();
   X509_STORE *_store = SSL_CTX_get_cert_store(private_->ctx);
   int r = X509_STORE_add_cert(_store, _c);
   X509_free(_c);
@@ -550,7 +728,7 @@ bool TlsContext::appendTrusted(const DataArray &_da) {
 
 bool TlsContext::setDefaultVerifyPaths() {
   lsDebug() << X509_get_default_cert_dir() << getenv(X509_get_default_cert_dir_env());
-  if (!private_->ctx) private_->ctx = SSL_CTX_new(TLS_method());
+  private_->create();
   return SSL_CTX_set_default_verify_paths(private_->ctx);
 }
 
@@ -13,10 +13,16 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #include <vector>
 #include <cstdint>
 
+#ifndef TLS_SESSION_TIMEOUT
+  #define TLS_SESSION_TIMEOUT 7200
+#endif
+
 struct ssl_ctx_st;
+struct ssl_session_st;
 struct x509_store_ctx_st;
 
 namespace AsyncFw {
+class AbstractThread;
 class DataArray;
 class DataArrayList;
 class LogStream;
@@ -115,6 +121,34 @@ public:
   @warning Thread Affinity: Must only be called during the initialization phase. Modifying this on the fly for active sockets causes critical data races.
   @param hostname The exact domain name or host IP string expected from the remote peer. */
   void setVerifyName(const std::string &) const;
+  /** @brief Checks whether kernel TLS offload is requested for the sockets using the context. @return True if setKernelTls() enabled it. */
+  bool kernelTls() const;
+  /** @brief Requests kernel TLS offload (kTLS, SSL_OP_ENABLE_KTLS) for the sockets using the context.
+  @details After the handshake OpenSSL installs the session keys in the kernel if the kernel tls module and the negotiated cipher support it. The socket then writes plain data to the descriptor, which also enables AbstractSocket::sendFile(), and the kernel decrypts received records. Otherwise the socket keeps encrypting in userspace.
+  @warning Thread Affinity: Must only be called during the initialization phase before the context is shared with active network sockets.
+  @param enable True to request the offload. @note Linux only, ignored with USE_SSL_BIO_PAIR. */
+  void setKernelTls(bool);
+  /** @brief Checks whether the sockets using the context release idle record buffers. @return True if setReleaseBuffers() enabled it. */
+  bool releaseBuffers() const;
+  /** @brief Makes OpenSSL free the record buffers of a connection whenever they are empty (SSL_MODE_RELEASE_BUFFERS), instead of keeping about 34 KB per connection.
+  @details Saves memory with many mostly idle connections at the cost of an allocation per record on busy ones. Independently of it AbstractTlsSocket releases the buffers of connections idle for Thread::setIdleTimeout().
+  @warning Thread Affinity: Must only be called during the initialization phase before the context is shared with active network sockets. @param enable True to release the buffers. */
+  void setReleaseBuffers(bool);
+  /** @brief Configures the server-side session cache, sessions are resumed by session id (TLS 1.2) or by stateful tickets (TLS 1.3 with setSessionTickets() disabled).
+  @warning Thread Affinity: Must only be called during the initialization phase. @param size Maximum number of cached sessions, zero disables the cache. @param timeout Session lifetime in seconds. */
+  void setSessionCache(int, int = TLS_SESSION_TIMEOUT);
+  /** @brief Enables stateless session tickets encrypted with rotating keys.
+  @details A new ticket key is generated every rotation interval, tickets of the previous TLS_TICKET_KEYS - 1 keys are still accepted and renewed with the current key. Without this call OpenSSL issues tickets with a key that never changes.
+  @warning Thread Affinity: Must only be called during the initialization phase. @param rotation Key lifetime in seconds, zero disables tickets. */
+  void setSessionTickets(int);
+  /** @brief Drops the client sessions stored for resumption.
+  @details Client connections store the sessions (TLS 1.2) and tickets (TLS 1.3 resumption PSK) received from a server per address:port of AbstractTlsSocket::connect(), the next connection to the same address and port offers them automatically. Thread-safe. */
+  void clearSessions();
+  /** @brief Moves the handshake steps of the sockets using the context (private key signing, certificate verification) to worker threads, the socket threads keep serving established connections during a burst of new ones.
+  @details Every step runs in the least loaded of the threads, e.g. created by ThreadPool::createThread(). The socket stops polling its descriptor while a step runs, the result is processed in the socket thread.
+  @warning Thread Affinity: Must only be called during the initialization phase, the threads must outlive the sockets using the context.
+  @param threads Worker threads, an empty list runs the handshakes in the socket threads. @note Ignored with USE_SSL_BIO_PAIR. */
+  void setHandshakeThreads(const std::vector<AbstractThread *> &);
   /** @brief Configures specific handshake validation bypass flags.
   @warning This method modifies the global internal verification registry. Calling it concurrently or post-initialization will corrupt the verification state. */
   void setIgnoreErrors(IgnoreErrors) const;
@@ -130,6 +164,10 @@ private:
   /* Low-level OpenSSL verification bridge callback invoked during the TLS handshake process.
   This method intercepts standard X509 certificate validation stages. It maps the raw OpenSSL context back to the corresponding TlsContext instance to evaluate user-defined security profiles, check hostnames, and enforce custom error bypass masks (e.g., IgnoreErrors). */
   static int verify(int, x509_store_ctx_st *);
+  /* Takes the stored client session for address:port, the caller owns the returned reference. */
+  ssl_session_st *session(const std::string &) const;
+  /* Returns the least loaded handshake thread, nullptr if handshakes run in the socket threads. */
+  AbstractThread *handshakeThread() const;
   Private *private_;
 };
 LogStream &operator<<(LogStream &, const TlsContext &);
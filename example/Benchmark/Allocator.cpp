@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Allocation throughput and resident memory of the C library malloc() against MemoryPool, for random block sizes up to 256 B, 4 KB and 64 KB.
+// churn: one thread replaces random blocks of a working set of 4096 blocks.
+// cross-thread: one thread allocates, another one frees, as a socket thread does with the buffers of the frames it hands over.
+// Every allocator runs in its own process, the resident memory is the growth of the process over all runs.
+// usage: BenchmarkAllocator [operations per run] [huge pages 0/1]
+
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <random>
+#include <fstream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <AsyncFw/MemoryPool>
+#include <AsyncFw/LogStream>
+
+using Block = std::pair<void *, std::size_t>;
+
+struct Malloc {
+  static constexpr const char *name = "malloc";
+  static void *allocate(std::size_t size) { return std::malloc(size); }
+  static void deallocate(void *p, std::size_t) { std::free(p); }
+};
+
+struct Pool {
+  static constexpr const char *name = "MemoryPool";
+  static void *allocate(std::size_t size) { return AsyncFw::MemoryPool::allocate(size); }
+  static void deallocate(void *p, std::size_t size) { AsyncFw::MemoryPool::deallocate(p, size); }
+};
+
+static long rss() {
+  std::ifstream f("/proc/self/statm");
+  long size = 0, resident = 0;
+  f >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+template <typename A>
+static double churn(int operations, std::size_t maxSize) {  // nanoseconds per allocation and free
+  std::mt19937 _r(1);
+  std::vector<Block> _set(4096, {nullptr, 0});
+  std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+  for (int i = 0; i != operations; ++i) {
+    Block &_b = _set[_r() % _set.size()];
+    if (_b.first) A::deallocate(_b.first, _b.second);
+    _b.second = 16 + _r() % maxSize;
+    _b.first = A::allocate(_b.second);
+    *static_cast<char *>(_b.first) = 0;
+  }
+  double _ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _start).count() / operations;
+  for (Block &_b : _set)
+    if (_b.first) A::deallocate(_b.first, _b.second);
+  return _ns;
+}
+
+template <typename A>
+static double crossThread(int operations, std::size_t maxSize) {
+  std::mutex _m;
+  std::deque<Block> _queue;
+  bool _done = false;
+  std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+  std::thread _consumer([&]() {
+    for (;;) {
+      std::deque<Block> _l;
+      {
+        std::lock_guard<std::mutex> lock(_m);
+        _l.swap(_queue);
+        if (_l.empty() && _done) return;
+      }
+      for (const Block &_b : _l) A::deallocate(_b.first, _b.second);
+      if (_l.empty()) std::this_thread::yield();
+    }
+  });
+  std::mt19937 _r(2);
+  std::vector<Block> _batch;
+  for (int i = 0; i != operations; ++i) {
+    std::size_t _size = 16 + _r() % maxSize;
+    _batch.emplace_back(A::allocate(_size), _size);
+    if (_batch.size() != 64) continue;
+    std::size_t _queued;
+    {
+      std::lock_guard<std::mutex> lock(_m);
+      _queue.insert(_queue.end(), _batch.begin(), _batch.end());
+      _queued = _queue.size();
+    }
+    _batch.clear();
+    for (; _queued > 4096; std::this_thread::yield()) {  // bounds the blocks in flight
+      std::lock_guard<std::mutex> lock(_m);
+      _queued = _queue.size();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(_m);
+    _queue.insert(_queue.end(), _batch.begin(), _batch.end());
+    _done = true;
+  }
+  _consumer.join();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _start).count() / operations;
+}
+
+template <typename A>
+static void run(int operations) {
+  long r0 = rss();
+  for (std::size_t maxSize : {256, 4096, 65536}) {
+    double _churn = churn<A>(operations, maxSize);
+    double _cross = crossThread<A>(operations, maxSize);
+    lsNotice() << A::name << "max size:" << maxSize << "churn ns/op:" << _churn << "cross-thread ns/op:" << _cross << "resident MB:" << (rss() - r0) / 1000000.0;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int operations = (argc > 1) ? std::atoi(argv[1]) : 4000000;
+  if (argc > 2) AsyncFw::MemoryPool::setHugePages(std::atoi(argv[2]));
+
+  for (void (*_run)(int) : {&run<Malloc>, &run<Pool>}) {
+    pid_t _p = fork();  // a fresh heap for every allocator
+    if (_p == 0) {
+      _run(operations);
+      _exit(0);
+    }
+    int _s;
+    if (_p < 0 || waitpid(_p, &_s, 0) < 0 || !WIFEXITED(_s) || WEXITSTATUS(_s)) {
+      lsError() << "run failed";
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Throughput of DataArray::toBase64(), fromBase64(), toHex() and fromHex() against the scalar base64 of the WebSocket code and a scalar hex loop,
+// for 20 bytes (a WebSocket key), 1 KB and 1 MB of random data. The MB/s are of the binary side.
+// usage: BenchmarkBase64Hex [MB per measurement]
+
+#include <random>
+#include <AsyncFw/DataArray>
+#include <AsyncFw/LogStream>
+#include "../../3rdparty/WebSocket/WebSocket/base64/base64.h"
+
+static std::string scalarHex(const AsyncFw::DataArray &data) {
+  static constexpr char digits[] = "0123456789abcdef";
+  std::string _s;
+  _s.reserve(data.size() * 2);
+  for (uint8_t _c : data) {
+    _s += digits[_c >> 4];
+    _s += digits[_c & 15];
+  }
+  return _s;
+}
+
+static AsyncFw::DataArray scalarFromHex(const std::string &hex) {
+  auto _d = [](char c) { return (c <= '9') ? c - '0' : (c | 0x20) - 'a' + 10; };
+  AsyncFw::DataArray _a(hex.size() / 2, 0);
+  for (std::size_t i = 0; i != _a.size(); ++i) _a[i] = (_d(hex[i * 2]) << 4) | _d(hex[i * 2 + 1]);
+  return _a;
+}
+
+int main(int argc, char *argv[]) {
+  double megabytes = (argc > 1) ? std::atof(argv[1]) : 200;
+  std::mt19937 _r(3);
+
+  for (std::size_t size : {20, 1024, 1024 * 1024}) {
+    AsyncFw::DataArray _d(size, 0);
+    for (uint8_t &_c : _d) _c = _r();
+    const AsyncFw::DataArray _b = AsyncFw::DataArray::toBase64(_d), _h = AsyncFw::DataArray::toHex(_d);
+    const std::string _sb(_b.begin(), _b.end()), _sh(_h.begin(), _h.end());
+    if (base64_encode(_d.data(), _d.size()) != _sb || scalarHex(_d) != _sh || AsyncFw::DataArray::fromBase64(_b) != _d || AsyncFw::DataArray::fromHex(_h) != _d) {
+      lsError() << "mismatch at" << size << "bytes";
+      return 1;
+    }
+    int _n = std::max<int>(10, megabytes * 1000000 / size);
+    auto _measure = [&](auto f) {  // MB/s
+      std::size_t _sum = 0;
+      std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+      for (int i = 0; i != _n; ++i) _sum += f().size();
+      double _us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+      return (_sum) ? static_cast<double>(size) * _n / _us : 0;
+    };
+    lsNotice() << size << "bytes, base64 encode MB/s: scalar" << _measure([&]() { return base64_encode(_d.data(), _d.size()); }) << "toBase64()" << _measure([&]() { return AsyncFw::DataArray::toBase64(_d); }) << "decode MB/s: scalar" << _measure([&]() { return base64_decode(_sb); }) << "fromBase64()" << _measure([&]() { return AsyncFw::DataArray::fromBase64(_b); });
+    lsNotice() << size << "bytes, hex encode MB/s: scalar" << _measure([&]() { return scalarHex(_d); }) << "toHex()" << _measure([&]() { return AsyncFw::DataArray::toHex(_d); }) << "decode MB/s: scalar" << _measure([&]() { return scalarFromHex(_sh); }) << "fromHex()" << _measure([&]() { return AsyncFw::DataArray::fromHex(_h); });
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Bulk DataArrayTcp throughput with the socket buffer profiles of SocketOptions: kernel autotuning, fixed 64 KB buffers and adaptive sizing.
+// The buffers matter on a path with a large bandwidth-delay product, emulate one on the loopback, for example:
+//   tc qdisc add dev lo root netem delay 20ms rate 1gbit
+//   tc qdisc del dev lo root
+// usage: BenchmarkBufferTuning [address] [milliseconds per run]
+
+#include <thread>
+#include <atomic>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18094;
+static constexpr int window = 128;  // frames in flight, enough to fill a 8 MB bandwidth-delay product
+static constexpr int frameSize = 64 * 1024;
+
+int main(int argc, char *argv[]) {
+  std::string address = (argc > 1) ? argv[1] : "127.0.0.1";
+  int duration = (argc > 2) ? std::atoi(argv[2]) : 5000;
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  AsyncFw::DataArrayTcpServer _server;
+  AsyncFw::DataArrayTcpClient _client;
+  for (AsyncFw::DataArrayAbstractTcp *_t : std::initializer_list<AsyncFw::DataArrayAbstractTcp *> {&_server, &_client}) _t->init(30000, 0, 10000, 4, 8, window * 2, window * 2 * frameSize, window * 2, window * 2 * frameSize);
+  _client.setReconnectTimeout(0);
+  _server.received.connect([](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t id) { socket->transmit("k", id); });
+
+  const AsyncFw::DataArray frame(frameSize, 'f');
+  std::atomic<bool> active = false;
+  bool running = false;  // accessed by the main thread
+  uint64_t bytes = 0;
+  _client.connectionStateChanged.connect([&active](const AsyncFw::DataArraySocket *socket) { active = socket->state() == AsyncFw::AbstractSocket::Active; });
+  _client.received.connect([&](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t) {
+    if (!running) return;
+    bytes += frameSize;
+    socket->transmit(frame, 0);
+  });
+
+  AsyncFw::SocketOptions _fixed, _adaptive;
+  _fixed.sendBufferSize = _fixed.receiveBufferSize = 64 * 1024;
+  _adaptive.adaptive = true;
+  _adaptive.adaptiveLimit = 16 * 1024 * 1024;
+
+  std::thread _bench([&]() {
+    bool listening;
+    _main->invoke([&]() { listening = _server.listen(address, port); }, true);
+    if (!listening) lsError() << "listen failed";
+    for (const auto &[name, options] : {std::pair<const char *, AsyncFw::SocketOptions> {"autotuning", {}}, {"fixed 64 KB", _fixed}, {"adaptive", _adaptive}}) {
+      if (!listening) break;
+      AsyncFw::DataArraySocket *socket;
+      _main->invoke([&]() {
+        _server.setSocketOptions(options);
+        _client.setSocketOptions(options);
+        _client.connectToHost(socket = _client.createSocket(), address, port);
+      }, true);
+      while (!active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      std::chrono::steady_clock::time_point _start;
+      _main->invoke([&]() {
+        running = true;
+        bytes = 0;
+        _start = std::chrono::steady_clock::now();
+        for (int i = 0; i != window; ++i) socket->transmit(frame, 0);
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      _main->invoke([&]() {
+        running = false;
+        lsNotice() << name << "throughput MB/s:" << bytes / std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      _main->invoke([&]() { _client.disconnectFromHost(socket); }, true);
+      while (active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      _main->invoke([&]() { _client.destroySocket(socket); }, true);
+    }
+    _main->invoke([]() { AsyncFw::MainThread::exit(); });
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Compression ratio and speed of the DataArray codecs at their fastest, default and a high level on two payloads:
+// an Rrd slice of 300 items as RrdServer sends it and 1 MB of log text. LZ4 and Zstandard need USE_LZ4 and USE_ZSTD.
+// usage: BenchmarkCodecs [MB per measurement]
+
+#include <random>
+#include <AsyncFw/DataArray>
+#include <AsyncFw/LogStream>
+
+static AsyncFw::DataArray rrdSlice(int items) {
+  AsyncFw::DataArrayList _l;
+  std::mt19937 _r(1);
+  double _v = 20;
+  for (int i = 0; i != items; ++i) {
+    AsyncFw::DataStream _s;
+    _v += (static_cast<int>(_r() % 100) - 50) / 100.0;
+    _s << static_cast<uint64_t>(1700000000000ull + i * 1000ull) << _v << static_cast<int32_t>(_r() % 4) << std::string("sensor/temperature/room1");
+    _l.push_back(_s.array());
+  }
+  AsyncFw::DataStream _s;
+  _s << static_cast<uint64_t>(items) << _l << static_cast<uint64_t>(items);
+  return _s.array();
+}
+
+static AsyncFw::DataArray logText(std::size_t size) {
+  const char *_w[] = {"connection", "accepted", "from", "127.0.0.1", "socket", "closed", "timeout", "read", "write", "bytes", "TLS", "handshake", "[INFO]", "[WARN]", "2026-10-19"};
+  std::mt19937 _r(2);
+  std::string _s;
+  while (_s.size() < size) {
+    _s += _w[_r() % std::size(_w)];
+    _s += (_r() % 8) ? ' ' : '\n';
+  }
+  _s.resize(size);
+  return AsyncFw::DataArray(_s);
+}
+
+int main(int argc, char *argv[]) {
+  double megabytes = (argc > 1) ? std::atof(argv[1]) : 20;
+
+  for (const auto &[name, data] : {std::pair<const char *, AsyncFw::DataArray> {"rrd slice", rrdSlice(300)}, {"log text", logText(1024 * 1024)}}) {
+    int _n = std::max<int>(3, megabytes * 1000000 / data.size());
+    for (const auto &[codec, codecName] : {std::pair<uint8_t, const char *> {AsyncFw::DataArray::Zlib, "zlib"}, {AsyncFw::DataArray::Lz4, "lz4"}, {AsyncFw::DataArray::Zstd, "zstd"}}) {
+      if (!AsyncFw::DataArray::codecAvailable(codec)) {
+        lsNotice() << name << codecName << "not available";
+        continue;
+      }
+      for (int level : {1, -1, 9}) {
+        AsyncFw::DataArray _c, _u;
+        std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+        for (int i = 0; i != _n; ++i) _c = AsyncFw::DataArray::compress(data, codec, level);
+        std::chrono::steady_clock::time_point _compressed = std::chrono::steady_clock::now();
+        for (int i = 0; i != _n; ++i) _u = AsyncFw::DataArray::uncompress(_c);
+        double _mb = static_cast<double>(data.size()) * _n;
+        if (_u != data) {
+          lsError() << name << codecName << "round trip failed";
+          return 1;
+        }
+        lsNotice() << name << data.size() << "bytes," << codecName << "level" << level << "ratio:" << static_cast<double>(data.size()) / _c.size() << "compress MB/s:" << _mb / std::chrono::duration<double, std::micro>(_compressed - _start).count() << "uncompress MB/s:" << _mb / std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _compressed).count();
+      }
+    }
+  }
+  return 0;
+}
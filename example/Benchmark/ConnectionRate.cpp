@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Connections per second on the loopback.
+// accept: ListenSocket rejects every connection, blocking clients connect and wait for the close (the accept4() loop alone).
+// session: DataArrayTcpClient sockets connect to DataArrayTcpServer, send one frame and are disconnected by the server (the whole socket life cycle on both ends).
+// usage: BenchmarkConnectionRate [concurrent connections] [milliseconds per run]
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/ListenSocket>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18091;
+
+static bool connectAndWaitClose() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+  sockaddr_in sa {};
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  char c;
+  bool b = ::connect(fd, reinterpret_cast<sockaddr *>(&sa), sizeof sa) == 0 && recv(fd, &c, 1, 0) == 0;
+  ::close(fd);
+  return b;
+}
+
+int main(int argc, char *argv[]) {
+  int concurrent = (argc > 1) ? std::atoi(argv[1]) : 16;
+  int duration = (argc > 2) ? std::atoi(argv[2]) : 2000;
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  AsyncFw::ListenSocket _listener;
+  _listener.incoming.connect([](int, const sockaddr_storage *, bool *accept) { *accept = false; });
+
+  AsyncFw::DataArrayTcpServer _server;
+  AsyncFw::DataArrayTcpClient _client;
+  _server.init(30000, 0, 10000, 4, 1000000);
+  _client.init(30000, 0, 10000, 4, 1000000);
+  _client.setReconnectTimeout(0);
+  std::atomic<uint64_t> sessions = 0;
+  std::atomic<bool> stop = false;
+  _server.received.connect([&_server](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t) { _server.disconnectFromHost(socket); });
+  _client.connectionStateChanged.connect([&](const AsyncFw::DataArraySocket *socket) {
+    if (socket->state() == AsyncFw::AbstractSocket::Active) {
+      socket->transmit("x", 0);
+      return;
+    }
+    ++sessions;
+    _client.destroySocket(const_cast<AsyncFw::DataArraySocket *>(socket));
+    if (!stop) _client.connectToHost(_client.createSocket(), "127.0.0.1", port);
+  });
+
+  std::thread _bench([&]() {
+    bool listening;
+    _main->invoke([&]() { listening = _listener.listen("127.0.0.1", port, 4096); }, true);
+    if (listening) {
+      std::atomic<uint64_t> accepted = 0;
+      std::vector<std::thread> _clients;
+      for (int i = 0; i != concurrent; ++i) {
+        _clients.emplace_back([&]() {
+          uint64_t n = 0;
+          while (!stop && connectAndWaitClose()) ++n;
+          accepted += n;
+        });
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      stop = true;
+      for (std::thread &t : _clients) t.join();
+      _main->invoke([&]() { _listener.close(); }, true);
+      lsNotice() << "accept: concurrent" << concurrent << "connections/s:" << accepted * 1000 / duration;
+    } else
+      lsError() << "listen failed";
+
+    stop = false;
+    _main->invoke([&]() { listening = _server.listen("127.0.0.1", port, 4096); }, true);
+    if (listening) {
+      _main->invoke([&]() {
+        for (int i = 0; i != concurrent; ++i) _client.connectToHost(_client.createSocket(), "127.0.0.1", port);
+      });
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      uint64_t n = sessions;
+      stop = true;
+      lsNotice() << "session: concurrent" << concurrent << "connections/s:" << n * 1000 / duration;
+    } else
+      lsError() << "listen failed";
+    _main->invoke([]() { AsyncFw::MainThread::exit(); });
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
@@ -0,0 +1,102 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Payload copies of a DataArrayTcp echo: the client sends 3 MB frames, the server sends every received frame back.
+// copied: DataArrayAbstractTcp::transmit() of the received DataArray, which copies it into the transmit queue.
+// shared: DataArraySocket::share() of the received DataArray, the transmit queue holds the receive buffer.
+// memcpy() and memmove() of the process are counted from 4 KB up, the kernel copies of the loopback are not included.
+// usage: BenchmarkCopyCount [frames]
+
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <dlfcn.h>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/LogStream>
+
+static std::atomic<uint64_t> copiedBytes = 0, copies = 0;
+static void *(*libcMemcpy)(void *, const void *, size_t) = nullptr;
+static void *(*libcMemmove)(void *, const void *, size_t) = nullptr;
+
+extern "C" void *memcpy(void *__restrict destination, const void *__restrict source, size_t size) noexcept {  // replaces the C library one for the whole process
+  if (!libcMemcpy) libcMemcpy = reinterpret_cast<void *(*)(void *, const void *, size_t)>(dlsym(RTLD_NEXT, "memcpy"));
+  if (size >= 4096) {
+    copiedBytes += size;
+    ++copies;
+  }
+  return libcMemcpy(destination, source, size);
+}
+
+extern "C" void *memmove(void *destination, const void *source, size_t size) noexcept {
+  if (!libcMemmove) libcMemmove = reinterpret_cast<void *(*)(void *, const void *, size_t)>(dlsym(RTLD_NEXT, "memmove"));
+  if (size >= 4096) {
+    copiedBytes += size;
+    ++copies;
+  }
+  return libcMemmove(destination, source, size);
+}
+
+static constexpr uint16_t port = 18098;
+static constexpr int frameSize = 3000000;
+
+int main(int argc, char *argv[]) {
+  int frames = (argc > 1) ? std::atoi(argv[1]) : 200;
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  AsyncFw::DataArrayTcpServer _server;
+  AsyncFw::DataArrayTcpClient _client;
+  _server.init(30000, 0, 10000, 1, 8, 16, 16 * 1024 * 1024, 512, 64 * 1024 * 1024);
+  _client.init(30000, 0, 10000, 1, 8, 16, 16 * 1024 * 1024, 512, 64 * 1024 * 1024);
+  _client.setReconnectTimeout(0);
+  std::atomic<bool> share = false;
+  _server.received.connect([&_server, &share](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *data, uint32_t id) {
+    if (share) _server.transmit(socket, socket->share(data), id);
+    else _server.transmit(socket, *data, id);
+  });
+
+  const AsyncFw::DataArray payload(frameSize, 'p');
+  std::atomic<bool> active = false;
+  std::atomic<int> echoed = 0;
+  _client.connectionStateChanged.connect([&active](const AsyncFw::DataArraySocket *socket) { active = socket->state() == AsyncFw::AbstractSocket::Active; });
+  _client.received.connect([&](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t id) {
+    if (++echoed < frames) socket->transmit(payload, id + 1);
+  });
+
+  std::thread _bench([&]() {
+    bool listening;
+    _main->invoke([&]() { listening = _server.listen("127.0.0.1", port); }, true);
+    if (!listening) lsError() << "listen failed";
+    AsyncFw::DataArraySocket *socket;
+    if (listening) {
+      _main->invoke([&]() { _client.connectToHost(socket = _client.createSocket(), "127.0.0.1", port); }, true);
+      while (!active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (bool shared : {false, true}) {
+      if (!listening) break;
+      share = shared;
+      echoed = 0;
+      uint64_t _b = copiedBytes, _c = copies;
+      std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+      _main->invoke([&]() { socket->transmit(payload, 0); }, true);
+      while (echoed < frames) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      double _us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+      lsNotice() << (shared ? "shared" : "copied") << "frames:" << frames << "us per frame:" << _us / frames << "copies per frame:" << static_cast<double>(copies - _c) / frames << "copied bytes per payload byte:" << static_cast<double>(copiedBytes - _b) / (2.0 * frames * frameSize);
+    }
+    if (listening) {
+      _main->invoke([&]() { _client.disconnectFromHost(socket); }, true);
+      while (active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      _main->invoke([&]() { _client.destroySocket(socket); }, true);
+    }
+    _main->invoke([]() { AsyncFw::MainThread::exit(); });
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
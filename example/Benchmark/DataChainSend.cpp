@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Building and sending messages of 16 pieces, a 16 byte header and 15 shared payloads of 4 KB, over DataArrayTcp:
+// flattened: the pieces are concatenated into one DataArray before transmit().
+// chain: the pieces are appended to a DataChain, which the socket writes with writev().
+// usage: BenchmarkDataChainSend [messages]
+
+#include <thread>
+#include <atomic>
+#include <sys/resource.h>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/DataChain>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18099;
+static constexpr int window = 8;
+static constexpr int pieceSize = 4096;
+
+static double cpuTime() {  // user and system microseconds of the process
+  rusage u;
+  getrusage(RUSAGE_SELF, &u);
+  return (u.ru_utime.tv_sec + u.ru_stime.tv_sec) * 1000000.0 + u.ru_utime.tv_usec + u.ru_stime.tv_usec;
+}
+
+int main(int argc, char *argv[]) {
+  int messages = (argc > 1) ? std::atoi(argv[1]) : 20000;
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  std::vector<AsyncFw::SharedDataArray> pieces;
+  for (int i = 1; i != 16; ++i) pieces.push_back(AsyncFw::SharedDataArray(AsyncFw::DataArray(pieceSize, 'a' + i)));
+  const uint8_t header[16] = {};
+  const std::size_t messageSize = sizeof(header) + pieces.size() * pieceSize;
+  auto _chain = [&]() {
+    AsyncFw::DataChain _c;
+    _c.append(AsyncFw::DataArrayView(header, sizeof(header)));
+    for (const AsyncFw::SharedDataArray &_p : pieces) _c.append(_p);
+    return _c;
+  };
+  auto _flattened = [&]() {
+    AsyncFw::DataArray _a;
+    _a.reserve(messageSize);
+    _a.insert(_a.end(), header, header + sizeof(header));
+    for (const AsyncFw::SharedDataArray &_p : pieces) _a.insert(_a.end(), _p.begin(), _p.end());
+    return _a;
+  };
+
+  AsyncFw::DataArrayTcpServer _server;
+  AsyncFw::DataArrayTcpClient _client;
+  for (AsyncFw::DataArrayAbstractTcp *_t : std::initializer_list<AsyncFw::DataArrayAbstractTcp *> {&_server, &_client}) _t->init(30000, 0, 10000, 1, 8, window * 2, window * 2 * messageSize, window * 2, window * 2 * messageSize);
+  _client.setReconnectTimeout(0);
+  std::atomic<int> bad = 0;
+  _server.received.connect([&_server, &bad, messageSize](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *data, uint32_t id) {
+    if (data->size() != messageSize) ++bad;
+    _server.transmit(socket, "k", id);
+  });
+
+  std::atomic<bool> active = false;
+  std::atomic<int> answered = 0;
+  bool chain = false;  // accessed by the main thread
+  int sent = 0;
+  auto _send = [&](const AsyncFw::DataArraySocket *socket) {
+    if (sent == messages) return;
+    if (chain) _client.transmit(socket, _chain(), sent++);
+    else _client.transmit(socket, _flattened(), sent++);
+  };
+  _client.connectionStateChanged.connect([&active](const AsyncFw::DataArraySocket *socket) { active = socket->state() == AsyncFw::AbstractSocket::Active; });
+  _client.received.connect([&](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t) {
+    ++answered;
+    _send(socket);
+  });
+
+  std::thread _bench([&]() {
+    bool listening;
+    _main->invoke([&]() { listening = _server.listen("127.0.0.1", port); }, true);
+    if (!listening) lsError() << "listen failed";
+    AsyncFw::DataArraySocket *socket;
+    if (listening) {
+      _main->invoke([&]() { _client.connectToHost(socket = _client.createSocket(), "127.0.0.1", port); }, true);
+      while (!active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (bool _c : {false, true}) {
+      if (!listening) break;
+      double _build;
+      _main->invoke([&]() {
+        std::size_t _n = 0;
+        double _cpu = cpuTime();
+        for (int i = 0; i != messages; ++i) _n += (_c) ? _chain().size() : _flattened().size();
+        _build = (cpuTime() - _cpu) * 1000 / messages;
+        if (_n != messages * messageSize) ++bad;
+      }, true);
+      std::chrono::steady_clock::time_point _start;
+      double _cpu;
+      _main->invoke([&]() {
+        chain = _c;
+        sent = answered = 0;
+        _start = std::chrono::steady_clock::now();
+        _cpu = cpuTime();
+        for (int i = 0; i != window; ++i) _send(socket);
+      }, true);
+      while (answered != messages) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      double _us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+      lsNotice() << (_c ? "chain" : "flattened") << "message bytes:" << messageSize << "build ns:" << _build << "send us per message:" << _us / messages << "CPU us per message:" << (cpuTime() - _cpu) / messages;
+    }
+    if (bad) lsError() << "wrong message sizes:" << bad.load();
+    if (listening) {
+      _main->invoke([&]() { _client.disconnectFromHost(socket); }, true);
+      while (active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      _main->invoke([&]() { _client.destroySocket(socket); }, true);
+    }
+    _main->invoke([]() { AsyncFw::MainThread::exit(); });
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
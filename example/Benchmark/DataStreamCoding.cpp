@@ -0,0 +1,76 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// DataStream encoding and decoding of the payloads of Rrd and RrdServer:
+// a vector of 100000 doubles element by element and in bulk, with and without reserve(),
+// and a DataArrayList of 1000 arrays of 200 bytes read as copies and as views into the source.
+// usage: BenchmarkDataStreamCoding [iterations]
+
+#include <numeric>
+#include <AsyncFw/DataArray>
+#include <AsyncFw/LogStream>
+
+template <typename F>
+static double measure(int iterations, F f) {  // microseconds per call
+  std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+  for (int i = 0; i != iterations; ++i) f();
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count() / iterations;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = (argc > 1) ? std::atoi(argv[1]) : 50;
+
+  std::vector<double> values(100000);
+  std::iota(values.begin(), values.end(), 0.5);
+  AsyncFw::DataArrayList list;
+  for (int i = 0; i != 1000; ++i) list.push_back(AsyncFw::DataArray(200, 'a' + i % 26));
+
+  AsyncFw::DataStream _e, _b;
+  for (double _v : values) _e << _v;
+  _b << values;
+  const AsyncFw::DataArray encodedElements = _e.array(), encodedValues = _b.array();
+  AsyncFw::DataStream _l;
+  _l << list;
+  const AsyncFw::DataArray encodedList = _l.array();
+
+  bool failed = false;
+  lsNotice() << "vector<double> encode us: element by element" << measure(iterations, [&]() {
+    AsyncFw::DataStream _s;
+    for (double _v : values) _s << _v;
+  }) << "bulk" << measure(iterations, [&]() {
+    AsyncFw::DataStream _s;
+    _s << values;
+  }) << "element by element after reserve()" << measure(iterations, [&]() {
+    AsyncFw::DataStream _s;
+    _s.reserve(values.size() * sizeof(double) + 8);
+    for (double _v : values) _s << _v;
+  });
+  lsNotice() << "vector<double> decode us: element by element" << measure(iterations, [&]() {
+    AsyncFw::DataStream _s(encodedElements);
+    double _v;
+    for (std::size_t i = 0; i != values.size(); ++i) _s >> _v;
+    failed |= _s.fail();
+  }) << "bulk" << measure(iterations, [&]() {
+    AsyncFw::DataStream _s(encodedValues);
+    std::vector<double> _v;
+    _s >> _v;
+    failed |= _s.fail() || _v.size() != values.size();
+  });
+  lsNotice() << "DataArrayList decode us: copies" << measure(iterations * 10, [&]() {
+    AsyncFw::DataStream _s(encodedList);
+    AsyncFw::DataArrayList _v;
+    _s >> _v;
+    failed |= _s.fail() || _v.size() != list.size();
+  }) << "views" << measure(iterations * 10, [&]() {
+    AsyncFw::DataStream _s(encodedList);
+    std::vector<AsyncFw::DataArrayView> _v;
+    _s >> _v;
+    failed |= _s.fail() || _v.size() != list.size();
+  });
+  if (failed) lsError() << "decode failed";
+  return failed;
+}
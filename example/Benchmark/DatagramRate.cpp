@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// UDP packets per second on the loopback, sent and received by different threads.
+// plain: a sendto() loop and a recvfrom() loop, one system call per datagram.
+// batched: DatagramSocket on both ends (sendmmsg/recvmmsg).
+// offload: DatagramSocket with UDP_SEGMENT on the sender and UDP_GRO on the receiver.
+// usage: BenchmarkDatagramRate [payload size] [milliseconds per run]
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <AsyncFw/Thread>
+#include <AsyncFw/DatagramSocket>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18092;
+
+struct Result {
+  uint64_t sent = 0;
+  uint64_t received = 0;
+};
+
+static Result plain(int size, int duration) {
+  Result r;
+  sockaddr_in sa {};
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int rx = socket(AF_INET, SOCK_DGRAM, 0), tx = socket(AF_INET, SOCK_DGRAM, 0);
+  timeval tv {0, 100000};
+  setsockopt(rx, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+  if (bind(rx, reinterpret_cast<sockaddr *>(&sa), sizeof sa) == 0) {
+    std::atomic<bool> stop = false;
+    std::thread _receiver([&]() {
+      std::vector<char> b(65536);
+      for (;;) {
+        if (recv(rx, b.data(), b.size(), 0) > 0) ++r.received;
+        else if (stop) break;
+      }
+    });
+    std::vector<char> payload(size, 'x');
+    for (auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration); std::chrono::steady_clock::now() < end;) {
+      for (int i = 0; i != 64; ++i) r.sent += sendto(tx, payload.data(), size, 0, reinterpret_cast<sockaddr *>(&sa), sizeof sa) == size;
+    }
+    stop = true;
+    _receiver.join();
+  }
+  ::close(rx);
+  ::close(tx);
+  return r;
+}
+
+static Result batched(int size, int duration, bool offload) {
+  Result r;
+  AsyncFw::Thread _rt("Receiver"), _st("Sender");
+  _rt.start();
+  _st.start();
+  AsyncFw::DatagramSocket *rx, *tx;
+  std::atomic<uint64_t> received = 0;
+  _rt.invoke([&]() {
+    rx = new AsyncFw::DatagramSocket;
+    rx->bind("127.0.0.1", port);
+    if (offload) rx->setReceiveOffload(true);
+    rx->received.connect([&received](const uint8_t *, int, const sockaddr_storage *) { ++received; });
+  }, true);
+  const int segments = offload ? std::min(64, 65000 / size) : 1;  // datagrams in one queued payload
+  std::vector<uint8_t> payload(size * segments, 'x');
+  std::atomic<bool> stop = false;
+  std::function<void()> pump = [&]() {  // queues a batch, lets the thread poll, then queues the next one
+    for (int i = 0; i != 64 && !stop; ++i) {
+      if (tx->send(payload.data(), payload.size()) < 0) break;
+      r.sent += segments;
+    }
+    tx->flush();
+    if (!stop) _st.invoke(pump);
+  };
+  _st.invoke([&]() {
+    tx = new AsyncFw::DatagramSocket;
+    tx->connect("127.0.0.1", port);
+    if (offload) tx->setSegmentSize(size);
+    pump();
+  }, true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+  stop = true;
+  _st.invoke([&]() { delete tx; }, true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  _rt.invoke([&]() { delete rx; }, true);
+  r.received = received;
+  _st.quit();
+  _rt.quit();
+  _st.waitFinished();
+  _rt.waitFinished();
+  return r;
+}
+
+int main(int argc, char *argv[]) {
+  int size = (argc > 1) ? std::atoi(argv[1]) : 64;
+  int duration = (argc > 2) ? std::atoi(argv[2]) : 2000;
+  auto _report = [size, duration](const char *name, const Result &r) { lsNotice() << name << "payload:" << size << "sent pps:" << r.sent * 1000 / duration << "received pps:" << r.received * 1000 / duration; };
+  _report("plain", plain(size, duration));
+  _report("batched", batched(size, duration, false));
+  _report("offload", batched(size, duration, true));
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Requests per second of HttpServer with 1, 2, 4 and 8 SO_REUSEPORT workers.
+// Keep-alive clients send GET requests from their own threads for a fixed time per run.
+// usage: BenchmarkHttpServerRps [clients] [milliseconds per run]
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/HttpServer>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18090;
+
+static int connectToServer() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in sa {};
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&sa), sizeof sa) == 0) return fd;
+  if (fd >= 0) ::close(fd);
+  return -1;
+}
+
+static bool request(int fd, std::string &buf) {  // sends one request and reads the whole response
+  static constexpr std::string_view req = "GET /rps HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  if (send(fd, req.data(), req.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(req.size())) return false;
+  char tmp[4096];
+  for (;;) {
+    if (std::size_t h = buf.find("\r\n\r\n"); h != std::string::npos) {
+      std::size_t l = 0, p = buf.find("Content-Length: ");
+      if (p != std::string::npos && p < h) l = std::stoul(buf.substr(p + 16));
+      if (buf.size() >= h + 4 + l) {
+        buf.erase(0, h + 4 + l);
+        return true;
+      }
+    }
+    ssize_t r = recv(fd, tmp, sizeof tmp, 0);
+    if (r <= 0) return false;
+    buf.append(tmp, r);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int clients = (argc > 1) ? std::atoi(argv[1]) : 16;
+  int duration = (argc > 2) ? std::atoi(argv[2]) : 2000;
+
+  AsyncFw::HttpServer _server;
+  _server.addRoute("/rps", AsyncFw::HttpServer::Request::Method::Get, [](const AsyncFw::HttpServer::Request &request) {
+    AsyncFw::HttpServer::Response *response = request.response();
+    response->setContent(AsyncFw::DataArray("ok"));
+    response->send();
+  });
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  std::thread _bench([&]() {
+    for (int workers : {1, 2, 4, 8}) {
+      bool listening;
+      _main->invoke([&]() { listening = _server.listen(port, workers); }, true);
+      if (!listening) {
+        lsError() << "listen failed";
+        break;
+      }
+      std::atomic<uint64_t> requests = 0;
+      std::atomic<bool> stop = false;
+      std::vector<std::thread> _clients;
+      for (int i = 0; i != clients; ++i) {
+        _clients.emplace_back([&]() {
+          int fd = connectToServer();
+          if (fd < 0) return;
+          std::string buf;
+          uint64_t n = 0;
+          while (!stop && request(fd, buf)) ++n;
+          requests += n;
+          ::close(fd);
+        });
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      stop = true;
+      for (std::thread &t : _clients) t.join();
+      lsNotice() << "workers:" << workers << "clients:" << clients << "rps:" << requests * 1000 / duration;
+      _main->invoke([&]() { _server.close(); }, true);
+    }
+    AsyncFw::MainThread::exit();
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
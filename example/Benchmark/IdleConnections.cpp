@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Resident memory per idle TLS connection, both ends in the process. Every connection exchanges one 16 KB frame each way and then stays idle.
+// baseline: OpenSSL keeps its record buffers, the sockets keep their read and write buffers.
+// release buffers: TlsContext::setReleaseBuffers() (SSL_MODE_RELEASE_BUFFERS).
+// idle timeout: DataArrayAbstractTcp::setIdleTimeout(), idle sockets free the OpenSSL buffers (SSL_free_buffers()) and shrink their read and write buffers.
+// Every profile runs in its own process. Both ends take a descriptor per connection, raise the hard limit (ulimit -Hn) for large counts.
+// usage: BenchmarkIdleConnections [connections]
+
+#include <fstream>
+#include <unistd.h>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/TlsContext>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18097;
+static constexpr int portConnections = 25000;  // connections per server port, within the ephemeral port range of one destination
+static constexpr int idleTimeout = 1000;
+
+static long rss() {
+  std::ifstream f("/proc/self/statm");
+  long size = 0, resident = 0;
+  f >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+static int run(const char *name, int connections, bool releaseBuffers, int idle) {
+  AsyncFw::TlsContext _context;
+  _context.generateKey(2048);
+  _context.generateCertificate();
+  _context.setVerifyPeer(false);
+  _context.setReleaseBuffers(releaseBuffers);
+
+  std::vector<std::unique_ptr<AsyncFw::DataArrayTcpServer>> _servers;
+  AsyncFw::DataArrayTcpClient _client;
+  _client.init(600000, 0, 60000, 1, connections + 1);
+  _client.setTlsContext(_context);
+  _client.setEncryptionDisabled(std::vector<std::string> {});
+  _client.setReconnectTimeout(0);
+  if (idle) _client.setIdleTimeout(idle);
+  for (int i = 0; i * portConnections < connections; ++i) {
+    AsyncFw::DataArrayTcpServer *_s = _servers.emplace_back(std::make_unique<AsyncFw::DataArrayTcpServer>()).get();
+    _s->init(600000, 0, 60000, 1, connections + 1);
+    _s->setTlsContext(_context);
+    _s->setEncryptionDisabled(std::vector<std::string> {});
+    if (idle) _s->setIdleTimeout(idle);
+    _s->received.connect([](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t id) { socket->transmit(AsyncFw::DataArray(16 * 1024, 'r'), id); });
+    if (!_s->listen("127.0.0.1", port + i)) {
+      lsError() << "listen failed";
+      return 1;
+    }
+  }
+
+  int started = 0, answered = 0;
+  long r0 = rss();
+  auto _connect = [&]() {
+    if (started == connections) return;
+    _client.connectToHost(_client.createSocket(), "127.0.0.1", port + started / portConnections);
+    ++started;
+  };
+  _client.connectionStateChanged.connect([&](const AsyncFw::DataArraySocket *socket) {
+    if (socket->state() != AsyncFw::AbstractSocket::Active) return;
+    socket->transmit(AsyncFw::DataArray(16 * 1024, 'q'), 0);
+    _connect();
+  });
+  _client.received.connect([&](const AsyncFw::DataArraySocket *, const AsyncFw::DataArray *, uint32_t) {
+    if (++answered != connections) return;
+    long r1 = rss();
+    AsyncFw::AbstractThread::current()->appendTimerTask(3 * idleTimeout, [&, r1]() {
+      long r2 = rss();
+      malloc_trim(0);
+      lsNotice() << name << "connections:" << connections << "KB per connection after the exchange:" << (r1 - r0) / 1024.0 / connections << "idle:" << (r2 - r0) / 1024.0 / connections << "idle after malloc_trim():" << (rss() - r0) / 1024.0 / connections;
+      AsyncFw::MainThread::exit(0);
+    });
+  });
+  for (int i = 0; i != 64; ++i) _connect();
+  return AsyncFw::MainThread::exec();
+}
+
+int main(int argc, char *argv[]) {
+  int connections = (argc > 1) ? std::atoi(argv[1]) : 50000;
+  rlimit _l;
+  getrlimit(RLIMIT_NOFILE, &_l);
+  _l.rlim_cur = _l.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &_l);
+  if (_l.rlim_cur < 2 * static_cast<rlim_t>(connections) + 64) lsWarning() << "descriptor limit" << _l.rlim_cur << "is too low for" << connections << "connections";
+
+  for (const auto &[name, releaseBuffers, idle] : {std::tuple<const char *, bool, int> {"baseline", false, 0}, {"release buffers", true, 0}, {"idle timeout", false, idleTimeout}, {"release buffers and idle timeout", true, idleTimeout}}) {
+    pid_t _p = fork();  // a fresh heap for every profile
+    if (_p == 0) _exit(run(name, connections, releaseBuffers, idle));
+    int _s;
+    if (_p < 0 || waitpid(_p, &_s, 0) < 0 || !WIFEXITED(_s) || WEXITSTATUS(_s)) {
+      lsError() << name << "failed";
+      return 1;
+    }
+  }
+  return 0;
+}
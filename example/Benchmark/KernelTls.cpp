@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Bulk DataArrayTcp throughput over TLS with and without kernel TLS offload (TlsContext::setKernelTls()), and the process CPU time it takes.
+// The offload needs the tls module of the kernel (modprobe tls) and OpenSSL built with enable-ktls, otherwise OpenSSL falls back to user space records.
+// usage: BenchmarkKernelTls [milliseconds per run]
+
+#include <thread>
+#include <atomic>
+#include <sys/resource.h>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/TlsContext>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18096;
+static constexpr int window = 32;
+static constexpr int frameSize = 256 * 1024;
+
+static double cpuTime() {  // user and system milliseconds of the process
+  rusage u;
+  getrusage(RUSAGE_SELF, &u);
+  return (u.ru_utime.tv_sec + u.ru_stime.tv_sec) * 1000.0 + (u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1000.0;
+}
+
+int main(int argc, char *argv[]) {
+  int duration = (argc > 1) ? std::atoi(argv[1]) : 3000;
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  AsyncFw::DataArrayTcpServer _server;
+  AsyncFw::DataArrayTcpClient _client;
+  for (AsyncFw::DataArrayAbstractTcp *_t : std::initializer_list<AsyncFw::DataArrayAbstractTcp *> {&_server, &_client}) {
+    _t->init(30000, 0, 10000, 4, 8, window * 2, window * 2 * frameSize, window * 2, window * 2 * frameSize);
+    _t->setEncryptionDisabled(std::vector<std::string> {});
+  }
+  _client.setReconnectTimeout(0);
+  _server.received.connect([](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t id) { socket->transmit("k", id); });
+
+  const AsyncFw::DataArray frame(frameSize, 'f');
+  std::atomic<bool> active = false;
+  bool running = false;  // accessed by the main thread
+  uint64_t bytes = 0;
+  _client.connectionStateChanged.connect([&active](const AsyncFw::DataArraySocket *socket) { active = socket->state() == AsyncFw::AbstractSocket::Active; });
+  _client.received.connect([&](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t) {
+    if (!running) return;
+    bytes += frameSize;
+    socket->transmit(frame, 0);
+  });
+
+  AsyncFw::TlsContext _context;
+  _context.generateKey(2048);
+  _context.generateCertificate();
+  _context.setVerifyPeer(false);
+
+  std::thread _bench([&]() {
+    bool listening;
+    _main->invoke([&]() { listening = _server.listen("127.0.0.1", port); }, true);
+    if (!listening) lsError() << "listen failed";
+    for (bool kernel : {false, true}) {
+      if (!listening) break;
+      AsyncFw::DataArraySocket *socket;
+      _main->invoke([&]() {
+        _context.setKernelTls(kernel);
+        _server.setTlsContext(_context);
+        _client.setTlsContext(_context);
+        _client.connectToHost(socket = _client.createSocket(), "127.0.0.1", port);
+      }, true);
+      while (!active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      std::chrono::steady_clock::time_point _start;
+      double _cpu;
+      _main->invoke([&]() {
+        running = true;
+        bytes = 0;
+        _start = std::chrono::steady_clock::now();
+        _cpu = cpuTime();
+        for (int i = 0; i != window; ++i) socket->transmit(frame, 0);
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      _main->invoke([&]() {
+        running = false;
+        double _us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+        lsNotice() << "kTLS requested:" << kernel << "send offload:" << socket->kernelTlsSend() << "receive offload:" << socket->kernelTlsReceive() << "MB/s:" << bytes / _us << "CPU ms per GB:" << (cpuTime() - _cpu) * 1000 / (bytes / 1000000.0);
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      _main->invoke([&]() { _client.disconnectFromHost(socket); }, true);
+      while (active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      _main->invoke([&]() { _client.destroySocket(socket); }, true);
+    }
+    _main->invoke([]() { AsyncFw::MainThread::exit(); });
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
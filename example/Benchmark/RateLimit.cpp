@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Latency of an interactive DataArrayTcp connection while a bulk connection transfers 64 KB frames to the same server thread:
+// without bulk traffic, with unlimited bulk traffic and with the bulk client limited by setRateLimit().
+// usage: BenchmarkRateLimit [bulk limit in MB/s] [milliseconds per run]
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/LogStream>
+
+static constexpr uint16_t port = 18095;
+static constexpr int window = 16;
+static constexpr int frameSize = 64 * 1024;
+
+int main(int argc, char *argv[]) {
+  uint64_t limit = (argc > 1) ? std::atoi(argv[1]) : 100;
+  int duration = (argc > 2) ? std::atoi(argv[2]) : 3000;
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  AsyncFw::DataArrayTcpServer _server;
+  AsyncFw::DataArrayTcpClient _bulk("Bulk"), _interactive("Interactive");
+  _server.init(30000, 0, 10000, 1, 8, window * 2, window * 2 * frameSize, window * 2, window * 2 * frameSize);  // one thread serves both connections
+  _bulk.init(30000, 0, 10000, 1, 8, window * 2, window * 2 * frameSize, window * 2, window * 2 * frameSize);
+  _bulk.setReconnectTimeout(0);
+  _interactive.setReconnectTimeout(0);
+  _server.received.connect([](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t id) { socket->transmit("k", id); });
+
+  const AsyncFw::DataArray ping(64, 'p'), frame(frameSize, 'f');
+  std::atomic<int> active = 0;
+  bool running = false;  // accessed by the main thread
+  std::vector<double> rtt;
+  std::chrono::steady_clock::time_point sent;
+  uint64_t bytes = 0;
+  for (AsyncFw::DataArrayTcpClient *_c : {&_bulk, &_interactive}) _c->connectionStateChanged.connect([&active](const AsyncFw::DataArraySocket *socket) { active += (socket->state() == AsyncFw::AbstractSocket::Active) ? 1 : -1; });
+  _interactive.received.connect([&](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t) {
+    if (!running) return;
+    std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+    rtt.push_back(std::chrono::duration<double, std::micro>(_now - sent).count());
+    sent = _now;
+    socket->transmit(ping, 0);
+  });
+  _bulk.received.connect([&](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t) {
+    if (!running) return;
+    bytes += frameSize;
+    socket->transmit(frame, 0);
+  });
+
+  std::thread _bench([&]() {
+    bool listening;
+    _main->invoke([&]() { listening = _server.listen("127.0.0.1", port); }, true);
+    if (!listening) lsError() << "listen failed";
+    for (const auto &[name, bulk, rate] : {std::tuple<const char *, bool, uint64_t> {"idle", false, 0}, {"bulk", true, 0}, {"bulk with setRateLimit()", true, limit * 1000000}}) {
+      if (!listening) break;
+      AsyncFw::DataArraySocket *_is, *_bs = nullptr;
+      _main->invoke([&]() {
+        _bulk.setRateLimit(rate);
+        _interactive.connectToHost(_is = _interactive.createSocket(), "127.0.0.1", port);
+        if (bulk) _bulk.connectToHost(_bs = _bulk.createSocket(), "127.0.0.1", port);
+      }, true);
+      while (active != (bulk ? 2 : 1)) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      std::chrono::steady_clock::time_point _start;
+      _main->invoke([&]() {
+        running = true;
+        rtt.clear();
+        bytes = 0;
+        _start = sent = std::chrono::steady_clock::now();
+        _is->transmit(ping, 0);
+        if (_bs)
+          for (int i = 0; i != window; ++i) _bs->transmit(frame, 0);
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      _main->invoke([&]() {
+        running = false;
+        std::sort(rtt.begin(), rtt.end());
+        if (!rtt.empty()) lsNotice() << name << "interactive us p50:" << rtt[rtt.size() / 2] << "p99:" << rtt[rtt.size() * 99 / 100] << "bulk MB/s:" << bytes / std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      _main->invoke([&]() {
+        _interactive.disconnectFromHost(_is);
+        if (_bs) _bulk.disconnectFromHost(_bs);
+      }, true);
+      while (active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      _main->invoke([&]() {
+        _interactive.destroySocket(_is);
+        if (_bs) _bulk.destroySocket(_bs);
+      }, true);
+    }
+    _main->invoke([]() { AsyncFw::MainThread::exit(); });
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
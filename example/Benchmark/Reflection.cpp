@@ -0,0 +1,111 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// DataStream serialization of messages with DataStruct reflection against hand-written operators, both produce the same bytes:
+// fixed: a 31 byte message of integers and floating point values, reflected as one block with a single bounds check.
+// variable: a message with a string and a vector of doubles, reflected field by field.
+// usage: BenchmarkReflection [messages]
+
+#include <AsyncFw/DataStruct>
+#include <AsyncFw/LogStream>
+
+namespace {
+struct Point {
+  int32_t x;
+  int32_t y;
+  double w;
+};
+
+struct Fixed {  // reflected
+  uint64_t time;
+  Point point;
+  uint16_t kind;
+  uint8_t on;
+  float value;
+};
+
+struct Variable {  // reflected
+  uint64_t time;
+  std::string name;
+  std::vector<double> values;
+};
+
+struct HandFixed {
+  uint64_t time;
+  Point point;
+  uint16_t kind;
+  uint8_t on;
+  float value;
+};
+
+struct HandVariable {
+  uint64_t time;
+  std::string name;
+  std::vector<double> values;
+};
+
+AsyncFw::DataStream &operator<<(AsyncFw::DataStream &ds, const HandFixed &m) { return ds << m.time << m.point.x << m.point.y << m.point.w << m.kind << m.on << m.value; }
+
+AsyncFw::DataStream &operator>>(AsyncFw::DataStream &ds, HandFixed &m) { return ds >> m.time >> m.point.x >> m.point.y >> m.point.w >> m.kind >> m.on >> m.value; }
+
+AsyncFw::DataStream &operator<<(AsyncFw::DataStream &ds, const HandVariable &m) { return ds << m.time << m.name << m.values; }
+
+AsyncFw::DataStream &operator>>(AsyncFw::DataStream &ds, HandVariable &m) { return ds >> m.time >> m.name >> m.values; }
+}  // namespace
+
+template <typename F>
+static double measure(int messages, F f) {  // nanoseconds per message
+  std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _start).count() / messages;
+}
+
+template <typename H, typename R, typename M>
+static bool run(const char *name, int messages, M make) {
+  AsyncFw::DataStream _hw, _rw;
+  double _he = measure(messages, [&]() {
+    for (int i = 0; i != messages; ++i) _hw << make.template operator()<H>(i);
+  });
+  double _re = measure(messages, [&]() {
+    for (int i = 0; i != messages; ++i) _rw << make.template operator()<R>(i);
+  });
+  if (_hw.array() != _rw.array()) {
+    lsError() << name << "wire mismatch";
+    return false;
+  }
+  AsyncFw::DataStream _hr(_hw.array()), _rr(_rw.array());
+  uint64_t _sum = 0;
+  double _hd = measure(messages, [&]() {
+    H _m;
+    for (int i = 0; i != messages; ++i) {
+      _hr >> _m;
+      _sum += _m.time;
+    }
+  });
+  double _rd = measure(messages, [&]() {
+    R _m;
+    for (int i = 0; i != messages; ++i) {
+      _rr >> _m;
+      _sum -= _m.time;
+    }
+  });
+  if (_hr.fail() || _rr.fail() || _sum) {
+    lsError() << name << "decode failed";
+    return false;
+  }
+  lsNotice() << name << "message bytes:" << _hw.array().size() / messages << "ns hand-written encode:" << _he << "decode:" << _hd << "reflected encode:" << _re << "decode:" << _rd;
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  int messages = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+  const std::vector<double> values(16, 0.25);
+
+  bool ok = run<HandFixed, Fixed>("fixed", messages, []<typename T>(int i) { return T {static_cast<uint64_t>(i), {i, -i, 0.5}, 3, 1, 2.5f}; });
+  ok &= run<HandVariable, Variable>("variable", messages / 10, [&values]<typename T>(int i) { return T {static_cast<uint64_t>(i), "sensor", values}; });
+  return !ok;
+}
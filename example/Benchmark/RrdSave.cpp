@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// Rrd::save() of a 256 MB database (4M items of 64 bytes) with the compressions of Rrd::setCompression():
+// zlib as a whole on the calling thread, which is the default, and in blocks compressed by ThreadPool threads together with the calling one.
+// usage: BenchmarkRrdSave [threads] [file]
+
+#include <random>
+#include <filesystem>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/ThreadPool>
+#include <AsyncFw/Rrd>
+#include <AsyncFw/LogStream>
+
+static constexpr int items = 4 * 1024 * 1024;
+
+int main(int argc, char *argv[]) {
+  int threads = (argc > 1) ? std::atoi(argv[1]) : 3;
+  std::string file = (argc > 2) ? argv[2] : (std::filesystem::temp_directory_path() / "BenchmarkRrdSave.rrd").string();
+  AsyncFw::ThreadPool *_pool = AsyncFw::Instance<AsyncFw::ThreadPool>::create("BenchmarkRrdSavePool", threads);
+
+  AsyncFw::Rrd _rrd(items);
+  std::mt19937 _r(7);
+  double _v = 20;
+  uint64_t _bytes = 0;
+  for (int i = 0; i != items; ++i) {
+    AsyncFw::DataStream _s;
+    _v += (static_cast<int>(_r() % 100) - 50) / 100.0;
+    _s << static_cast<uint64_t>(1700000000000ull + i * 1000ull) << _v << static_cast<int32_t>(_r() % 4) << std::string("sensor/temperature/room") + static_cast<char>('0' + _r() % 8) + " status=ok unit=C ";
+    _bytes += _s.array().size();
+    _rrd.append(_s.array(), i + 1);
+  }
+
+  for (const auto &[name, codec, level, blocks] : {std::tuple<const char *, uint8_t, int, bool> {"zlib whole", AsyncFw::DataArray::Zlib, -1, false}, {"zlib blocks", AsyncFw::DataArray::Zlib, -1, true}, {"zlib level 1 blocks", AsyncFw::DataArray::Zlib, 1, true}, {"lz4 blocks", AsyncFw::DataArray::Lz4, -1, true}, {"zstd blocks", AsyncFw::DataArray::Zstd, -1, true}, {"zstd level 1 blocks", AsyncFw::DataArray::Zstd, 1, true}}) {
+    if (!AsyncFw::DataArray::codecAvailable(codec)) {
+      lsNotice() << name << "not available";
+      continue;
+    }
+    _rrd.setCompression(codec, level, blocks ? _pool->getThreads(threads) : std::vector<AsyncFw::AbstractThread *> {});
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+    _rrd.save(file);
+    double _ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+    lsNotice() << name << "items MB:" << _bytes / 1000000.0 << "threads:" << (blocks ? threads : 0) << "save ms:" << _ms << "file MB:" << std::filesystem::file_size(file) / 1000000.0;
+  }
+  std::filesystem::remove(file);
+  return 0;
+}
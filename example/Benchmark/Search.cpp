@@ -0,0 +1,46 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// DataArrayView searching against the standard library equivalents on a 4 KB HTTP request header:
+// the end of the header, a case insensitive header name, splitting into lines and a set of absent delimiters.
+// usage: BenchmarkSearch [iterations]
+
+#include <algorithm>
+#include <AsyncFw/DataArray>
+#include <AsyncFw/LogStream>
+
+static volatile std::size_t sink;  // keeps the results alive
+
+template <typename F>
+static double measure(int iterations, F f) {  // nanoseconds per call
+  std::size_t _sum = 0;
+  std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+  for (int i = 0; i != iterations; ++i) _sum += f();
+  double _ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _start).count() / iterations;
+  sink = _sum;
+  return _ns;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = (argc > 1) ? std::atoi(argv[1]) : 200000;
+
+  std::string _header = "POST /api/upload HTTP/1.1\r\nHost: example.com\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\nAccept: */*\r\n";
+  for (int i = 0; _header.size() < 4000; ++i) _header += "X-Custom-Header-" + std::to_string(i) + ": some value with text\r\n";
+  _header += "Content-Length: 1234\r\n\r\n";
+  const AsyncFw::DataArray data(_header);
+  const AsyncFw::DataArrayView view(data);
+
+  lsNotice() << "end of header, ns: string_view::find()" << measure(iterations, [&]() { return view.find("\r\n\r\n"); }) << "indexOf()" << measure(iterations, [&]() { return view.indexOf("\r\n\r\n"); });
+  lsNotice() << "header name, ns: lowercase copy and find()" << measure(iterations, [&]() {
+    std::string _l(data.size(), 0);
+    std::transform(data.begin(), data.end(), _l.begin(), [](unsigned char c) { return std::tolower(c); });
+    return _l.find("content-length:");
+  }) << "indexOfIgnoreCase()" << measure(iterations, [&]() { return view.indexOfIgnoreCase("content-length:"); });
+  lsNotice() << "split into" << view.splitViews('\n').size() << "lines, ns: split()" << measure(iterations / 10, [&]() { return view.split('\n').size(); }) << "splitViews()" << measure(iterations / 10, [&]() { return view.splitViews('\n').size(); });
+  lsNotice() << "absent delimiters, ns: find_first_of()" << measure(iterations, [&]() { return view.find_first_of("{}[]"); }) << "indexOfAny()" << measure(iterations, [&]() { return view.indexOfAny("{}[]"); });
+  return 0;
+}
@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+// DataArrayTcpClient to DataArrayTcpServer over TCP loopback and over unix domain sockets.
+// latency: one 64 byte frame in flight, answered with one byte.
+// throughput: a window of 64 KB frames, each acknowledged with one byte.
+// usage: BenchmarkUnixSocket [milliseconds per run]
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <AsyncFw/MainThread>
+#include <AsyncFw/DataArrayTcpServer>
+#include <AsyncFw/DataArrayTcpClient>
+#include <AsyncFw/LogStream>
+
+static constexpr int window = 8;
+static constexpr int frameSize = 64 * 1024;
+
+int main(int argc, char *argv[]) {
+  int duration = (argc > 1) ? std::atoi(argv[1]) : 2000;
+  AsyncFw::AbstractThread *_main = AsyncFw::AbstractThread::current();
+
+  AsyncFw::DataArrayTcpServer _tcpServer("TcpServer"), _unixServer("UnixServer");
+  AsyncFw::DataArrayTcpClient _client;
+  _client.setReconnectTimeout(0);
+  for (AsyncFw::DataArrayTcpServer *_s : {&_tcpServer, &_unixServer}) _s->received.connect([](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t id) { socket->transmit("k", id); });
+
+  const AsyncFw::DataArray ping(64, 'p'), frame(frameSize, 'f');
+  std::atomic<bool> active = false;
+  int phase = 0;  // 1 latency, 2 throughput, accessed by the main thread
+  std::vector<double> rtt;
+  std::chrono::steady_clock::time_point sent;
+  uint64_t bytes = 0;
+  _client.connectionStateChanged.connect([&active](const AsyncFw::DataArraySocket *socket) { active = socket->state() == AsyncFw::AbstractSocket::Active; });
+  _client.received.connect([&](const AsyncFw::DataArraySocket *socket, const AsyncFw::DataArray *, uint32_t) {
+    if (phase == 1) {
+      std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+      rtt.push_back(std::chrono::duration<double, std::micro>(_now - sent).count());
+      sent = _now;
+      socket->transmit(ping, 0);
+    } else if (phase == 2) {
+      bytes += frameSize;
+      socket->transmit(frame, 0);
+    }
+  });
+
+  std::thread _bench([&]() {
+    bool listening;
+    _main->invoke([&]() { listening = _tcpServer.listen("127.0.0.1", 18093) && _unixServer.listen("/tmp/asyncfw-benchmark.sock", 0); }, true);
+    if (!listening) lsError() << "listen failed";
+    for (const auto &[name, address, port] : {std::tuple<const char *, const char *, uint16_t> {"tcp", "127.0.0.1", 18093}, {"unix", "/tmp/asyncfw-benchmark.sock", 0}}) {
+      if (!listening) break;
+      AsyncFw::DataArraySocket *socket;
+      _main->invoke([&]() { _client.connectToHost(socket = _client.createSocket(), address, port); }, true);
+      while (!active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+      _main->invoke([&]() {
+        phase = 1;
+        rtt.clear();
+        sent = std::chrono::steady_clock::now();
+        socket->transmit(ping, 0);
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      _main->invoke([&]() { phase = 0; }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      _main->invoke([&]() {
+        std::sort(rtt.begin(), rtt.end());
+        if (!rtt.empty()) lsNotice() << name << "latency us p50:" << rtt[rtt.size() / 2] << "p99:" << rtt[rtt.size() * 99 / 100] << "round trips:" << rtt.size();
+      }, true);
+
+      std::chrono::steady_clock::time_point _start;
+      _main->invoke([&]() {
+        phase = 2;
+        bytes = 0;
+        _start = std::chrono::steady_clock::now();
+        for (int i = 0; i != window; ++i) socket->transmit(frame, 0);
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+      _main->invoke([&]() {
+        phase = 0;
+        lsNotice() << name << "throughput MB/s:" << bytes / std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+      }, true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      _main->invoke([&]() { _client.disconnectFromHost(socket); }, true);
+      while (active) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      _main->invoke([&]() { _client.destroySocket(socket); }, true);
+    }
+    _main->invoke([]() { AsyncFw::MainThread::exit(); });
+  });
+
+  int ret = AsyncFw::MainThread::exec();
+  _bench.join();
+  return ret;
+}
@@ -26,7 +26,7 @@ public:
 
 int main(int argc, char *argv[]) {
   AsyncFw::ListenSocket ls;
-  ls.incoming.connect([](int fd, const std::string &address, bool *accept) {
+  ls.incoming.connect([](int fd, const sockaddr_storage *address, bool *accept) {
     TcpSocket *socket = TcpSocket::create();
     socket->setDescriptor(fd);
     socket->received.connect([socket](const AsyncFw::DataArray &data) {
@@ -34,7 +34,7 @@ int main(int argc, char *argv[]) {
       socket->write("Answer\n");
       if (data == AsyncFw::DataArray('q')) AsyncFw::MainThread::exit(0);
     });
-    logInfo() << "Incoming:" << fd << address;
+    logInfo() << "Incoming:" << fd << AsyncFw::ListenSocket::addressString(address);
     *accept = true;
   });
 
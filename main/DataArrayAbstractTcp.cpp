@@ -7,6 +7,8 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 #include <openssl/crypto.h>
 #include <algorithm>
+#include "core/DataArray.h"
+#include "core/DataChain.h"
 #include "core/LogStream.h"
 #include "DataArraySocket.h"
 #include "DataArrayAbstractTcp.h"
@@ -15,6 +17,10 @@ using namespace AsyncFw;
 
 DataArrayAbstractTcp::DataArrayAbstractTcp(const std::string &name) : AbstractThreadPool(name) { init(); }
 
+DataArrayAbstractTcp::~DataArrayAbstractTcp() {
+  if (rebalanceTimer >= 0) thread_->removeTimer(rebalanceTimer);
+}
+
 DataArrayAbstractTcp::Thread *DataArrayAbstractTcp::findMinimalSocketsThread() {
   int index = -1;
   for (int i = 0, n = threads_.size(), m = maxSockets; i != n; ++i) {
@@ -35,17 +41,39 @@ DataArrayAbstractTcp::Thread *DataArrayAbstractTcp::findMinimalSocketsThread() {
   return static_cast<Thread *>(t);
 }
 
-int DataArrayAbstractTcp::transmit(const DataArraySocket *socket, const DataArray &ba, uint32_t pi, bool wait) {
+bool DataArrayAbstractTcp::socketProfile(SocketOptions &options) const {
+  if (!socketOptions && socketReadBufferSize <= 0) return false;
+  options = socketOptions ? *socketOptions : SocketOptions();
+  if (options.receiveBufferSize <= 0) options.receiveBufferSize = socketReadBufferSize;
+  return true;
+}
+
+int DataArrayAbstractTcp::transmit(const DataArraySocket *socket, const DataArray &ba, uint32_t pi, bool wait) { return transmit(socket, SharedDataArray(DataArrayView(ba)), pi, wait); }
+
+int DataArrayAbstractTcp::transmit(const DataArraySocket *socket, const SharedDataArray &ba, uint32_t pi, bool wait) {
   if (socket->state_ != AbstractSocket::State::Active) return ErrorTransmitNotActive;
   if (!socket->thread()) return ErrorTransmitInvoke;
+  if (socket->overBudget()) return ErrorTransmitBudget;
+  bool b = const_cast<DataArraySocket *>(socket)->transmit(ba, pi, wait);
+  return (b) ? 0 : ErrorTransmit;
+}
+
+int DataArrayAbstractTcp::transmit(const DataArraySocket *socket, const DataChain &ba, uint32_t pi, bool wait) {
+  if (socket->state_ != AbstractSocket::State::Active) return ErrorTransmitNotActive;
+  if (!socket->thread()) return ErrorTransmitInvoke;
+  if (socket->overBudget()) return ErrorTransmitBudget;
   bool b = const_cast<DataArraySocket *>(socket)->transmit(ba, pi, wait);
   return (b) ? 0 : ErrorTransmit;
 }
 
 void DataArrayAbstractTcp::disconnectFromHost(const DataArraySocket *socket) {
-  socket->thread()->invoke([socket]() { const_cast<DataArraySocket *>(socket)->disconnect(); });
+  socket->invokeThread([socket]() { const_cast<DataArraySocket *>(socket)->disconnect(); });
 }
 
+void DataArrayAbstractTcp::pauseReceive(const DataArraySocket *socket) { socket->pauseReceive(); }
+
+void DataArrayAbstractTcp::resumeReceive(const DataArraySocket *socket) { socket->resumeReceive(); }
+
 void DataArrayAbstractTcp::setEncryptionDisabled(const std::string &address, bool disable) {
   std::vector<std::string>::iterator it = std::find(disabledEncryptionHosts_.begin(), disabledEncryptionHosts_.end(), address);
   if (!disable) {
@@ -57,6 +85,102 @@ void DataArrayAbstractTcp::setEncryptionDisabled(const std::string &address, boo
 
 void DataArrayAbstractTcp::setTlsContext(DataArraySocket *socket, const TlsContext &context) { socket->setContext(context); }
 
+void DataArrayAbstractTcp::setTcpInfoInterval(int ms) {
+  std::lock_guard<std::mutex> lock(mutex);
+  tcpInfoInterval = ms;
+  for (AbstractThread *thread : threads_) static_cast<Thread *>(thread)->setTcpInfoInterval(ms);
+}
+
+void DataArrayAbstractTcp::setIdleTimeout(int ms) {
+  std::lock_guard<std::mutex> lock(mutex);
+  idleTimeout = ms;
+  for (AbstractThread *thread : threads_) static_cast<Thread *>(thread)->setIdleTimeout(ms);
+}
+
+TcpInfoSummary DataArrayAbstractTcp::tcpInfoSummary() {
+  TcpInfoSummary _s;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (AbstractThread *thread : threads_) _s.append(static_cast<Thread *>(thread)->tcpInfoSummary());
+  return _s;
+}
+
+void DataArrayAbstractTcp::setRebalanceInterval(int ms) {
+  thread_->invoke([this, ms]() {
+    if (rebalanceTimer >= 0) thread_->removeTimer(rebalanceTimer);
+    rebalanceTimer = (ms > 0) ? thread_->appendTimerTask(ms, [this]() { rebalance(); }) : -1;
+    rebalanceSamples.clear();
+  }, true);
+}
+
+void DataArrayAbstractTcp::rebalance() {
+  struct Load {
+    Thread *thread;
+    uint64_t bytes;
+    std::vector<std::pair<DataArraySocket *, uint64_t>> sockets;
+  };
+  std::vector<Load> _loads;
+  std::vector<std::pair<const AbstractSocket *, uint64_t>> _samples;
+  {  //lock scope
+    std::lock_guard<std::mutex> lock(mutex);
+    if (threads_.size() < 2) return;
+    for (AbstractThread *thread : threads_) _loads.push_back(Load {static_cast<Thread *>(thread), 0, {}});
+  }
+  // the threads are destroyed by tasks of this thread (see Thread::checkEmpty()), they stay valid until rebalance() returns
+  for (Load &_l : _loads) {
+    _l.thread->invoke([this, &_l, &_samples]() {
+      for (AbstractSocket *_s : _l.thread->sockets_) {
+        const uint64_t _b = _s->bytesReceived() + _s->bytesSent();
+        _samples.emplace_back(_s, _b);
+        if (static_cast<DataArraySocket *>(_s)->state() != AbstractSocket::State::Active) continue;
+        std::vector<std::pair<const AbstractSocket *, uint64_t>>::iterator it = std::lower_bound(rebalanceSamples.begin(), rebalanceSamples.end(), std::make_pair(static_cast<const AbstractSocket *>(_s), uint64_t(0)));
+        // a new socket has no sample yet, its load counts from the next interval
+        const uint64_t _d = (it != rebalanceSamples.end() && it->first == _s && it->second <= _b) ? _b - it->second : 0;
+        _l.sockets.emplace_back(static_cast<DataArraySocket *>(_s), _d);
+        _l.bytes += _d;
+      }
+    }, true);
+  }
+  std::sort(_samples.begin(), _samples.end());
+  rebalanceSamples.swap(_samples);
+  std::vector<Load>::iterator _hot = std::max_element(_loads.begin(), _loads.end(), [](const Load &l1, const Load &l2) { return l1.bytes < l2.bytes; });
+  std::vector<Load>::iterator _cold = std::min_element(_loads.begin(), _loads.end(), [](const Load &l1, const Load &l2) { return l1.bytes < l2.bytes; });
+  if (_hot->sockets.size() < 2 || _hot->bytes <= _cold->bytes * 2) return;
+  // moving a socket carrying more than half of the difference would only swap the roles of the threads
+  const uint64_t _gap = (_hot->bytes - _cold->bytes) / 2;
+  DataArraySocket *_socket = nullptr;
+  uint64_t _max = 0;
+  for (const std::pair<DataArraySocket *, uint64_t> &_p : _hot->sockets) {
+    if (_p.second > _max && _p.second <= _gap) {
+      _max = _p.second;
+      _socket = _p.first;
+    }
+  }
+  if (!_socket) return;
+  Thread *_target = _cold->thread;
+  ++_target->arriving;  // the target is not destroyed until the socket arrives
+  lsDebug() << LogStream::Color::Cyan << "move socket" << '(' + _hot->thread->name() + ')' << _hot->bytes << "->" << '(' + _target->name() + ')' << _cold->bytes << "socket bytes:" << _max;
+  const auto _arrived = [_target]() { _target->invoke([_target]() { _target->arrived(); }); };
+  if (!_hot->thread->invoke([_hot_thread = _hot->thread, _socket, _target, _arrived]() {
+    // the socket may be destroyed in the meantime, it is looked up without dereferencing
+    if (std::find(_hot_thread->sockets_.begin(), _hot_thread->sockets_.end(), _socket) != _hot_thread->sockets_.end() && _socket->state() == AbstractSocket::State::Active) _socket->moveToThread(_target);
+    _arrived();  // queued after the socket in the target thread
+  })) _arrived();
+}
+
+LatencyHistogram DataArrayAbstractTcp::receiveLatency(bool reset) {
+  LatencyHistogram _h;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (AbstractThread *thread : threads_) _h.append(static_cast<Thread *>(thread)->receiveLatency(reset));
+  return _h;
+}
+
+int64_t DataArrayAbstractTcp::bufferUsage() {
+  int64_t _s = 0;
+  std::lock_guard<std::mutex> lock(mutex);
+  for (AbstractThread *thread : threads_) _s += static_cast<Thread *>(thread)->bufferUsage();
+  return _s;
+}
+
 int DataArrayAbstractTcp::sockets(std::vector<DataArraySocket *> *list) {
   int count = 0;
   mutex.lock();
@@ -76,6 +200,13 @@ void DataArrayAbstractTcp::Thread::initSocket(DataArraySocket *socket) {
   socket->setWaitForEncryptionTimeout(tcp->waitForEncryptionTimeout);
   socket->setReadBuffers(tcp->maxReadBuffers, tcp->maxReadSize);
   socket->setWriteBuffers(tcp->maxWriteBuffers, tcp->maxWriteSize);
+  socket->setReadWatermarks(tcp->readHighWatermark, tcp->readLowWatermark);
+  if (tcpInfoInterval() != tcp->tcpInfoInterval) setTcpInfoInterval(tcp->tcpInfoInterval);
+  if (idleTimeout() != tcp->idleTimeout) setIdleTimeout(tcp->idleTimeout);
+  socket->setReceiveTimestamps(tcp->receiveTimestamps);
+  socket->setPacingRate(tcp->pacingRate);
+  socket->setRateLimit(tcp->rateLimit);
+  if (SocketOptions _o; tcp->socketProfile(_o)) socket->setOptions(_o);
   socket->received.connect([tcp, socket](const DataArray *da, uint32_t pi) {
     tcp->thread_->invoke([tcp, socket, da, pi]() {
       tcp->received(socket, da, pi);
@@ -89,9 +220,20 @@ void DataArrayAbstractTcp::Thread::destroySocket(DataArraySocket *socket) {
   socket->removeTimer();
   socket->close();
   socket->removeFromThread();
-  if (sockets_.empty()) {
-    OPENSSL_thread_stop();
-    pool->thread()->invoke([this]() { destroy(); });
-  }
+  checkEmpty();
   if (!pool->thread()->invoke([socket]() { socket->destroy(); })) socket->destroy();
 }
+
+void DataArrayAbstractTcp::Thread::arrived() {
+  --arriving;
+  checkEmpty();
+}
+
+void DataArrayAbstractTcp::Thread::checkEmpty() {
+  if (!sockets_.empty() || arriving) return;
+  OPENSSL_thread_stop();
+  pool->thread()->invoke([this]() {
+    // rebalance() may have chosen the thread as a target meanwhile, arrived() checks it again
+    if (!arriving) destroy();
+  });
+}
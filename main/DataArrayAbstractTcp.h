@@ -9,6 +9,9 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 /** @file DataArrayAbstractTcp.h @brief The DataArrayAbstractTcp class. */
 
+#include <atomic>
+#include <memory>
+#include "../core/AbstractSocket.h"
 #include "../core/FunctionConnector.h"
 #include "../core/TlsContext.h"
 #include "ThreadPool.h"
@@ -16,6 +19,7 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 namespace AsyncFw {
 class DataArraySocket;
 class DataArray;
+class DataChain;
 class TlsContext;
 
 /** @class DataArrayAbstractTcp DataArrayAbstractTcp.h <AsyncFw/DataArrayAbstractTcp> @brief Abstract base class implementing a multi-threaded TCP pool for socket and packet management.
@@ -26,12 +30,15 @@ public:
   enum Result {
     ErrorTransmitInvoke = -100,    /**< Cross-thread invocation failure during data transmission. */
     ErrorTransmitNotActive = -101, /**< Transmission aborted because the target socket is not actively connected. */
-    ErrorTransmit = -102           /**< Low-level or buffer-queue failure while sending data. */
+    ErrorTransmit = -102,          /**< Low-level or buffer-queue failure while sending data. */
+    ErrorTransmitBudget = -103     /**< The socket is over the BufferBudget, retry later. */
   };
 
   /** @brief Constructs a new DataArrayAbstractTcp instance. @param name Name identifier for the underlying thread pool. */
   DataArrayAbstractTcp(const std::string &);
-  void init(int readTimeout = 30000, int waitKeepAliveAnswerTimeout = 0, int waitForEncryptionTimeout = 10000, int maxThreads = 4, int maxSockets = 8, int maxReadBuffers = 16, int maxReadSize = 16 * 1024 * 1024, int maxWriteBuffers = 16, int maxWriteSize = 16 * 1024 * 1024, int socketReadBufferSize = 1024 * 512) {
+  ~DataArrayAbstractTcp() override;
+  /** @brief Sets the limits of new sockets. @param readTimeout Data absence timeout in milliseconds. @param waitKeepAliveAnswerTimeout Ping response timeout in milliseconds. @param waitForEncryptionTimeout TLS handshake timeout in milliseconds. @param maxThreads Worker thread limit. @param maxSockets Socket limit. @param maxReadBuffers Inbound buffers per socket. @param maxReadSize Inbound bytes per socket. @param maxWriteBuffers Outbound buffers per socket. @param maxWriteSize Outbound bytes per socket. @param socketReadBufferSize SO_RCVBUF of new sockets in bytes, zero keeps the kernel autotuning (see SocketOptions::receiveBufferSize). */
+  void init(int readTimeout = 30000, int waitKeepAliveAnswerTimeout = 0, int waitForEncryptionTimeout = 10000, int maxThreads = 4, int maxSockets = 8, int maxReadBuffers = 16, int maxReadSize = 16 * 1024 * 1024, int maxWriteBuffers = 16, int maxWriteSize = 16 * 1024 * 1024, int socketReadBufferSize = 0) {
     this->readTimeout = readTimeout;
     this->waitKeepAliveAnswerTimeout = waitKeepAliveAnswerTimeout;
     this->waitForEncryptionTimeout = waitForEncryptionTimeout;
@@ -45,14 +52,50 @@ public:
   }
   /** @brief Asynchronously transmits a DataArray packet through a given socket context. @param socket Pointer to the target DataArraySocket. @param data Reference to the DataArray containing payload data. @param id Packet identification tag. @param wait If true, forces caller thread blocking until the buffer queues up. @return 0 on success, or a negative value from the Result enum on failure. */
   int transmit(const DataArraySocket *, const DataArray &, uint32_t, bool = false);
+  /** @brief Asynchronously transmits a shared array through a given socket context without copying it (see DataArraySocket::share()). @param socket Pointer to the target DataArraySocket. @param data Shared array. @param id Packet identification tag. @param wait If true, forces caller thread blocking until the buffer queues up. @return 0 on success, or a negative value from the Result enum on failure. */
+  int transmit(const DataArraySocket *, const SharedDataArray &, uint32_t, bool = false);
+  /** @brief Asynchronously transmits a chain of segments through a given socket context, see DataArraySocket::transmit(). @param socket Pointer to the target DataArraySocket. @param chain Segments of the packet. @param id Packet identification tag. @param wait If true, forces caller thread blocking until the buffer queues up. @return 0 on success, or a negative value from the Result enum on failure. */
+  int transmit(const DataArraySocket *, const DataChain &, uint32_t, bool = false);
+  /** @brief Sets the tuning profile of new sockets (and of the listener of DataArrayTcpServer). @param options Socket options. */
+  void setSocketOptions(const SocketOptions &options) { socketOptions = std::make_unique<SocketOptions>(options); }
   /** @brief Signals a specific managed socket to disconnect from its remote peer. @param socket Pointer to the DataArraySocket instance to be disconnected. */
   void disconnectFromHost(const DataArraySocket *);
+  /** @brief Pauses receiving on a managed socket, the peer is held back by TCP flow control. @param socket Pointer to the DataArraySocket instance. */
+  void pauseReceive(const DataArraySocket *);
+  /** @brief Resumes receiving on a managed socket paused by pauseReceive(). @param socket Pointer to the DataArraySocket instance. */
+  void resumeReceive(const DataArraySocket *);
+  /** @brief Sets read flow control for new sockets: reading pauses when unreleased received data reaches the high watermark and resumes at the low watermark (see DataArraySocket::setReadWatermarks()). @param high High watermark in bytes, zero disconnects on overflow as before. @param low Low watermark in bytes. */
+  void setReadWatermarks(int high, int low) {
+    readHighWatermark = high;
+    readLowWatermark = low;
+  }
+  /** @brief Limits the transmit rate of each new socket (see AbstractSocket::setPacingRate()). @param rate Bytes per second, zero removes the limit. */
+  void setPacingRate(uint64_t rate) { pacingRate = rate; }
+  /** @brief Limits the aggregate transmit rate of the new sockets with one shared token bucket (see AbstractSocket::setRateLimit()). @param rate Bytes per second, zero removes the limit. */
+  void setRateLimit(uint64_t rate) { rateLimit = (rate) ? std::make_shared<RateLimit>(rate) : nullptr; }
+  /** @brief Moves connections between the worker threads by load.
+  @details Every interval the application bytes transferred by each socket are compared. When the busiest thread moved more than twice the bytes of the idlest one, the socket that narrows the gap the most moves over (AbstractSocket::moveToThread()), one socket per interval. @param ms Interval in milliseconds, zero disables. */
+  void setRebalanceInterval(int);
+  /** @brief Samples the kernel TCP state of the managed sockets periodically, batched per worker thread (see Thread::setTcpInfoInterval()). @param ms Interval in milliseconds, zero stops sampling. */
+  void setTcpInfoInterval(int);
+  /** @brief Releases the buffer memory of the managed sockets idle for the given time, checked per worker thread (see Thread::setIdleTimeout()). @param ms Idle time in milliseconds, zero disables the release. */
+  void setIdleTimeout(int);
+  /** @brief Aggregates the last TCP_INFO samples of all managed sockets. @return Summary. */
+  TcpInfoSummary tcpInfoSummary();
+  /** @brief Enables kernel receive timestamps on new sockets, the latency of every received frame is recorded in the histogram of its worker thread (see DataArraySocket::receiveLatency()). @param enable Enable timestamps. */
+  void setReceiveTimestamps(bool enable) { receiveTimestamps = enable; }
+  /** @brief Merges the receive latency histograms of the worker threads. @param reset Clears the histograms. @return Histogram. */
+  LatencyHistogram receiveLatency(bool = false);
+  /** @brief Returns the buffer memory accounted by the sockets of the worker threads in the BufferBudget, in bytes. */
+  int64_t bufferUsage();
   /** @brief Gathers a list of all active managed sockets and counts them. @param list Optional destination vector to populate with socket pointers. @return The total count of active sockets running in the framework. */
   int sockets(std::vector<DataArraySocket *> * = nullptr);
   /** @brief Sets a strict list of remote IP addresses where TLS encryption must be bypassed. @param list Vector of IP addresses as strings. */
   void setEncryptionDisabled(const std::vector<std::string> &list) { disabledEncryptionHosts_ = list; }
   /** @brief Configures or overrides the TLS encryption toggle for a specific target address. @param address Remote host IP address string. @param disable If true, encryption is bypassed. */
   void setEncryptionDisabled(const std::string &, bool = true);
+  /** @brief Matches unix domain peers as the loopback address 127.0.0.1 in the encryption and always-connect lists. Otherwise they are matched by the socket path, the listening path on the server side. @param enable Match as loopback. */
+  void setUnixAsLoopback(bool enable) { unixAsLoopback = enable; }
   /** @brief Assigns and initializes TLS security parameters on a specific socket. @param socket Pointer to the target DataArraySocket. @param context TLS certificates, keys, and security parameters. */
   void setTlsContext(DataArraySocket *, const TlsContext &);
   /** @brief Sets up the TLS credentials and configuration for secure client connections. @param context The TLS context object containing certificates and keys. */
@@ -78,19 +121,39 @@ protected:
     /** @brief Performs cleanup routines and safely removes a socket from the thread loop. @param socket Pointer to the target DataArraySocket. */
     void destroySocket(DataArraySocket *);
     AbstractThreadPool *pool; /**< Backward reference pointer to the base thread pool interface. */
+
+  private:
+    void arrived();
+    void checkEmpty();
+    std::atomic<int> arriving = 0;  // sockets chosen by rebalance() to move to the thread, it is not destroyed while they are on the way
   };
+  /** @brief Compares the load of the worker threads and moves a socket from the busiest to the idlest one, see setRebalanceInterval(). */
+  void rebalance();
   /** @brief Locates the worker thread currently hosting the lowest number of socket contexts. @return Pointer to the least occupied Thread, or nullptr if no threads are running. */
   Thread *findMinimalSocketsThread();
+  /** @brief Builds the tuning profile of new sockets from socketOptions and socketReadBufferSize. @param options Receives the profile. @return False if there is nothing to apply. */
+  bool socketProfile(SocketOptions &) const;
   int readTimeout;                /**< Data absence timeout in milliseconds. */
   int waitKeepAliveAnswerTimeout; /**< Ping response timeout window in milliseconds. */
   int waitForEncryptionTimeout;   /**< TLS handshake maximum window in milliseconds. */
   std::size_t maxThreads;         /**< Allowed thread capacity configuration limit. */
   std::size_t maxSockets;         /**< Absolute global count threshold for sockets. */
-  int socketReadBufferSize;       /**< System level network chunk buffer capability size. */
+  int socketReadBufferSize;       /**< SO_RCVBUF of new sockets unless socketOptions sets SocketOptions::receiveBufferSize, zero keeps the kernel autotuning. */
   int maxReadBuffers;             /**< Maximum incoming buffer blocks allocated per socket. */
   int maxReadSize;                /**< Absolute maximum byte bounds for inbound data allocation. */
   int maxWriteBuffers;            /**< Maximum outbound frame descriptors allocated per socket. */
   int maxWriteSize;               /**< Absolute maximum byte bounds for outbound transmission queue data. */
+  int readHighWatermark = 0;      /**< Unreleased inbound bytes that pause reading, zero disables flow control. */
+  int readLowWatermark = 0;       /**< Unreleased inbound bytes that resume paused reading. */
+  int tcpInfoInterval = 0;        /**< TCP_INFO sampling interval of the worker threads in milliseconds, zero disables sampling. */
+  int idleTimeout = 0;            /**< Idle time of the worker threads after which the socket buffers are released, zero disables the release. */
+  bool receiveTimestamps = false; /**< Kernel receive timestamps of new sockets. */
+  bool unixAsLoopback = false;    /**< Unix domain peers are matched as 127.0.0.1 in the encryption and always-connect lists. */
+  uint64_t pacingRate = 0;        /**< Transmit rate limit of each socket in bytes per second, zero is unlimited. */
+  std::shared_ptr<RateLimit> rateLimit; /**< Aggregate transmit rate limit shared by the sockets, none is unlimited. */
+  std::unique_ptr<SocketOptions> socketOptions; /**< Tuning profile of new sockets, none keeps the system defaults. */
+  int rebalanceTimer = -1;        /**< Rebalance timer of the pool thread. */
+  std::vector<std::pair<const AbstractSocket *, uint64_t>> rebalanceSamples; /**< Transferred bytes of each socket at the last rebalance, ordered by socket. */
   /** @brief Internal array of remote endpoints exempted from TLS handshake logic. */
   std::vector<std::string> disabledEncryptionHosts_ = {"127.0.0.1"};
   TlsContext tlsContext;
@@ -6,8 +6,12 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 */
 
 #include <algorithm>
-#include <deque>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <list>
 #include "core/DataArray.h"
+#include "core/DataChain.h"
 #include "core/TlsContext.h"
 #include "core/LogStream.h"
 #include "core/Thread.h"
@@ -20,19 +24,20 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 #undef AsyncFw_THREAD
 #define AsyncFw_THREAD this->thread()
+#ifndef DATA_ARRAY_SOCKET_GATHER_SIZE
+  #define DATA_ARRAY_SOCKET_GATHER_SIZE 16384
+#endif
+
 using namespace AsyncFw;
 
 struct DataArraySocket::Private {
+  struct Frame : DataArray, std::enable_shared_from_this<Frame> {};  // a received array, shared by share()
+  struct Transmit {
+    uint64_t header;  // id and size
+    DataChain data;
+  };
+  Frame *receiveByteArray = nullptr;
   int sslConnection = 0;
-  DataArray *receiveByteArray = nullptr;
-
-  // 0x01 — transient error marker: set before disconnect() on error, cleared inside disconnect() (prevents setting 0x08)
-  // 0x02 — waiting for keep-alive response
-  // 0x04 — connection attempt timer active (set when initiating connect)
-  // 0x08 — explicit user disconnect: persists until stateEvent(Unconnected) to suppress auto-reconnect; also guards against re-entry into disconnect()
-  // 0x80 — keep-alive response timeout enabled
-  uint8_t flags = 0;
-
   int maxReadBuffers = 16;
   int maxReadSize = 1024 * 1024;
   int maxWriteBuffers = 16;
@@ -42,25 +47,55 @@ struct DataArraySocket::Private {
   int readTimeout = 0;
   int waitForEncryptionTimeout = 10000;
   int waitKeepAliveResponseTimeout = 0;
+  int readHighWatermark = 0;
+  int readLowWatermark = 0;
   int timerId = 0;
+  int timerInterval = 0;
+  int tid = -1;
   uint32_t readSize = 0;
   uint32_t readId = 0;
+  uint32_t latency = 0;
+  uint64_t readTime = 0;  // kernel arrival time of the header of the frame in progress
   uint16_t port = 0;
-  std::string address;
+  bool server = false;  // accepted by a server, see initServerConnection()
+  bool header = false;  // the header of the next frame is read, the frame waits for buffer space while reading is paused
 
-  mutable std::vector<DataArray *> receiveList;
-  std::deque<DataArray> transmitList;
-  int tid = -1;
+  // 0x01 — transient error marker: set before disconnect() on error, cleared inside disconnect() (prevents setting 0x08)
+  // 0x02 — waiting for keep-alive response
+  // 0x04 — connection attempt timer active (set when initiating connect)
+  // 0x08 — explicit user disconnect: persists until stateEvent(Unconnected) to suppress auto-reconnect; also guards against re-entry into disconnect()
+  // 0x10 — receiving paused by pauseReceive()
+  // 0x20 — receiving paused by the read high watermark, cleared when released buffers drop to the low watermark
+  // 0x40 — the timer is restarted in the new thread after moveToThread()
+  // 0x80 — keep-alive response timeout enabled
+  uint8_t flags = 0;
+
+  std::string address;
+  mutable std::vector<std::shared_ptr<Frame>> receiveList;
+  std::list<Transmit> transmitList;  // an empty list holds no memory, unlike std::deque
   AsyncFw::AbstractThread::Waiter waiter;
 
   void releaseBuffer(const DataArray *) const;
+  int bufferedSize() const {
+    int _s = 0;
+    for (const std::shared_ptr<Frame> &da : receiveList)
+      if (da.get() != receiveByteArray) _s += da->size();
+    return _s;
+  }
+  void checkWatermarks() {
+    // a high watermark above the read size limit would overflow before it pauses
+    if (readHighWatermark > maxReadSize) {
+      lsWarning() << "read high watermark" << readHighWatermark << "above read size limit" << maxReadSize;
+      readHighWatermark = maxReadSize;
+    }
+    if (readLowWatermark > readHighWatermark) readLowWatermark = readHighWatermark;
+  }
 };
 
 void DataArraySocket::Private::releaseBuffer(const DataArray *da) const {
   for (std::size_t i = 0; i != receiveList.size(); ++i) {
-    if (receiveList[i] == da) {
+    if (receiveList[i].get() == da) {
       receiveList.erase(receiveList.begin() + i);
-      delete da;
       return;
     }
   }
@@ -71,12 +106,12 @@ DataArraySocket::DataArraySocket() : AbstractTlsSocket(), private_(*new Private(
 
 DataArraySocket::~DataArraySocket() {
   if (thread_) removeTimer();
-  while (!private_.receiveList.empty()) private_.releaseBuffer(private_.receiveList.back());
   delete &private_;
   trace();
 }
 
 void DataArraySocket::startTimer(int _ms) {
+  private_.timerInterval = _ms;
   if (private_.tid < 0) private_.tid = thread_->appendTimerTask(_ms, [this]() { timerEvent(); });
   else thread_->modifyTimer(private_.tid, _ms);
 }
@@ -88,6 +123,35 @@ void DataArraySocket::removeTimer() {
   }
 }
 
+void DataArraySocket::moveEvent(bool arrived) {
+  if (arrived) {
+    if (!(private_.flags & 0x40)) return;
+    private_.flags &= ~0x40;
+    startTimer(private_.timerInterval);
+    return;
+  }
+  if (private_.tid < 0) return;
+  private_.flags |= 0x40;
+  removeTimer();
+}
+
+void DataArraySocket::budgetEvent() {
+  // a frame in progress is completed first, it is released only as a whole
+  if (!private_.readSize) AbstractSocket::budgetEvent();
+}
+
+void DataArraySocket::idleEvent() {
+  if (private_.receiveList.empty()) private_.receiveList.shrink_to_fit();
+  AbstractTlsSocket::idleEvent();
+}
+
+int64_t DataArraySocket::bufferedBytes() const {
+  int64_t _s = 0;
+  for (const std::shared_ptr<Private::Frame> &da : private_.receiveList) _s += da->size();
+  for (const Private::Transmit &t : private_.transmitList) _s += t.data.size() + sizeof(t.header);
+  return _s;
+}
+
 void DataArraySocket::stateEvent() {
   trace() << static_cast<int>(state_);
   if (state_ == State::Connected) {
@@ -110,12 +174,14 @@ void DataArraySocket::stateEvent() {
     if (private_.readTimeout > 0) startTimer(private_.readTimeout);
     else if (private_.reconnectTimeout > 0) { removeTimer(); }
   } else if (state_ == AbstractSocket::State::Unconnected) {
+    private_.flags &= ~0x30;
     if (!(private_.flags & 0x08)) {
       if (private_.reconnectTimeout > 0) startTimer(private_.reconnectTimeout);
       else if (private_.readTimeout > 0) { removeTimer(); }
     }
     private_.readSize = 0;
-    std::vector<DataArray *>::iterator it = std::find(private_.receiveList.begin(), private_.receiveList.end(), private_.receiveByteArray);
+    private_.header = false;
+    std::vector<std::shared_ptr<Private::Frame>>::iterator it = std::find_if(private_.receiveList.begin(), private_.receiveList.end(), [this](const std::shared_ptr<Private::Frame> &da) { return da.get() == private_.receiveByteArray; });
     if (private_.receiveByteArray && it != private_.receiveList.end()) {
       private_.receiveList.erase(it);
       private_.receiveByteArray = nullptr;
@@ -132,6 +198,11 @@ void DataArraySocket::stateEvent() {
 void DataArraySocket::timerEvent() {
   removeTimer();
   if (state_ == AbstractSocket::State::Active) {
+    if (readPaused() && private_.sslConnection != 3) {
+      // the peer is held back by the paused reading (pauseReceive(), the read watermark or the BufferBudget), silence is expected
+      if (private_.readTimeout > 0) startTimer(private_.readTimeout);
+      return;
+    }
     if (private_.sslConnection != 3 && private_.flags == 0x80 && private_.readTimeout > 0) {
       sendKeepAlive(true);
     } else {
@@ -187,9 +258,22 @@ void DataArraySocket::readEvent() {
     return;
   }
   for (;;) {
-    if (!pendingRead()) break;
-    bool start = (private_.readSize == 0);
+    if (readPaused() || (!pendingRead() && !private_.header)) break;
+    bool start = (private_.readSize == 0 && !private_.header);
     if (start) {
+      if (private_.readHighWatermark > 0 && (static_cast<int>(private_.receiveList.size()) >= private_.maxReadBuffers || private_.bufferedSize() >= private_.readHighWatermark)) {
+        trace() << LogStream::Color::Yellow << "read high watermark (" + peerString() + ')' << private_.bufferedSize();
+        private_.flags |= 0x20;
+        setReadPaused(true);
+        break;
+      }
+      if (BufferBudget::limit()) {
+        updateBudget();
+        if (overBudget()) {
+          pauseForBudget();
+          break;
+        }
+      }
       if (pendingRead() < static_cast<int>(sizeof(uint64_t))) return;
       read(reinterpret_cast<uint8_t *>(&private_.readSize), sizeof(uint32_t));
       read(reinterpret_cast<uint8_t *>(&private_.readId), sizeof(uint32_t));
@@ -202,39 +286,53 @@ void DataArraySocket::readEvent() {
         }
         warning_if(private_.readId != 0xffffffff) << LogStream::Color::Red << "read array empty (" + peerString() + ')';
       }
-      bool e = false;
       if (private_.readSize > static_cast<uint32_t>(private_.maxReadSize)) {
         setErrorString("Big received size: " + std::to_string(private_.readSize) + "  (" + peerString() + ')');
-        e = true;
-      } else if (static_cast<int>(private_.receiveList.size()) >= private_.maxReadBuffers) {
-        setErrorString("Many receive buffers (" + peerString() + ')');
-        e = true;
-      } else {
-        uint32_t size = private_.readSize;
-        for (const DataArray *ba : private_.receiveList) {
-          size += static_cast<uint32_t>(ba->size());
-          if (size > static_cast<uint32_t>(private_.maxReadSize)) {
-            setErrorString("Receive overflow (" + peerString() + ')');
-            e = true;
-            break;
-          }
-        }
+        private_.readSize = 0;
+        disconnect();
+        return;
       }
-      if (e) {
+      private_.header = true;
+      private_.readTime = receiveTimestamp();
+    }
+    if (private_.header) {
+      std::string _e;
+      if (static_cast<int>(private_.receiveList.size()) >= private_.maxReadBuffers) _e = "Many receive buffers (" + peerString() + ')';
+      else if (private_.bufferedSize() + private_.readSize > static_cast<uint32_t>(private_.maxReadSize)) _e = "Receive overflow (" + peerString() + ')';
+      if (!_e.empty()) {
+        if (private_.readHighWatermark > 0 && !private_.receiveList.empty()) {
+          // the frame fits once the received buffers are released, see releaseBuffer()
+          trace() << LogStream::Color::Yellow << "read paused, " + _e << private_.bufferedSize();
+          private_.flags |= 0x20;
+          setReadPaused(true);
+          break;
+        }
+        setErrorString(_e);
         private_.readSize = 0;
+        private_.header = false;
         disconnect();
         return;
       }
-      private_.receiveByteArray = new DataArray;
-      private_.receiveList.emplace_back(private_.receiveByteArray);
+      private_.header = false;
+      private_.receiveList.emplace_back(std::make_shared<Private::Frame>());
+      private_.receiveByteArray = private_.receiveList.back().get();
     }
     if (private_.readSize > 0) {
       if (!pendingRead()) break;
-      DataArray ba = read(private_.readSize - static_cast<uint32_t>(private_.receiveByteArray->size()));
-      private_.receiveByteArray->insert(private_.receiveByteArray->end(), ba.begin(), ba.end());
+      // read straight into the frame, without an intermediate array
+      const std::size_t _o = private_.receiveByteArray->size();
+      const int _n = std::min(pendingRead(), static_cast<int>(private_.readSize - _o));
+      private_.receiveByteArray->resize(_o + _n);
+      private_.receiveByteArray->resize(_o + read(private_.receiveByteArray->data() + _o, _n));
     }
     if (static_cast<uint32_t>(private_.receiveByteArray->size()) == private_.readSize) {
       private_.readSize = 0;
+      private_.latency = 0;
+      if (const uint64_t _ts = private_.readTime) {
+        const int64_t _ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - static_cast<int64_t>(_ts);
+        private_.latency = (_ns > 0) ? static_cast<uint32_t>(std::min<int64_t>(_ns / 1000, std::numeric_limits<uint32_t>::max())) : 0;
+        thread_->appendReceiveLatency(private_.latency);
+      }
       received(private_.receiveByteArray, private_.readId);
       private_.receiveByteArray = nullptr;
     }
@@ -265,16 +363,36 @@ void DataArraySocket::writeSocket() {
       return;
     }
     if (private_.transmitList.empty()) { break; }
-    write(private_.transmitList.front());
+    Private::Transmit &_t = private_.transmitList.front();
+    int _w;
+    if (_t.data.size() <= DATA_ARRAY_SOCKET_GATHER_SIZE) {
+      // a small array goes with its header in one write (one TLS record, no small segment waiting for Nagle)
+      uint8_t _b[sizeof(_t.header) + DATA_ARRAY_SOCKET_GATHER_SIZE];
+      std::memcpy(_b, &_t.header, sizeof(_t.header));
+      _t.data.copy(_b + sizeof(_t.header));
+      _w = write(_b, sizeof(_t.header) + _t.data.size());
+    } else _w = write(_t.data.prependView(DataArrayView(reinterpret_cast<const uint8_t *>(&_t.header), sizeof(_t.header))));
     private_.transmitList.pop_front();
+    if (_w < 0) {  // a part of the frame may be sent, the stream can not continue
+      setErrorString("Write error (" + peerString() + ')');
+      disconnect();
+      return;
+    }
   }
+  updateBudget();
   if (pendingWrite() > private_.maxWriteSize) {
     setErrorString("Write buffer overflow (" + peerString() + ')');
     disconnect();
   }
 }
 
-bool DataArraySocket::transmit(const DataArray &ba, uint32_t pi, bool wait) const {
+bool DataArraySocket::transmit(const DataArray &ba, uint32_t pi, bool wait) const { return transmit(SharedDataArray(DataArrayView(ba)), pi, wait); }
+
+bool DataArraySocket::transmit(const SharedDataArray &ba, uint32_t pi, bool wait) const { return enqueue(DataChain(ba), pi, wait); }
+
+bool DataArraySocket::transmit(const DataChain &ba, uint32_t pi, bool wait) const { return enqueue(ba.detached(), pi, wait); }
+
+bool DataArraySocket::enqueue(DataChain &&ba, uint32_t pi, bool wait) const {
   if (!thread()) {
     lsError("thread is nullptr") << static_cast<int>(state_);
     return false;
@@ -287,26 +405,30 @@ bool DataArraySocket::transmit(const DataArray &ba, uint32_t pi, bool wait) cons
     lsWarning("tried transmit to inactive socket");
     return false;
   }
+  if (overBudget()) {
+    trace() << LogStream::Color::Yellow << "buffer budget exceeded (" + peerString() + ')';
+    return false;
+  }
   warning_if(ba.empty()) << "transmit array empty (" + peerString() + ')';
   if (static_cast<int>(ba.size()) > private_.maxWriteSize) {
     setErrorString("Big transmit size: " + std::to_string(ba.size()) + " (" + peerString() + ')');
-    if (!private_.port) const_cast<DataArraySocket *>(this)->disconnect();
+    if (private_.server) const_cast<DataArraySocket *>(this)->disconnect();
     return false;
   }
   bool _r = false;
-  thread_->invoke([this, &_r, &ba, pi, wait]() {
+  invokeThread([this, &_r, &ba, pi, wait]() {
     int buffers = private_.transmitList.size();
     if (buffers >= private_.maxWriteBuffers) {
       setErrorString("Many transmit buffers (" + peerString() + ')');
-      if (!private_.port) const_cast<DataArraySocket *>(this)->disconnect();
+      if (private_.server) const_cast<DataArraySocket *>(this)->disconnect();
       return;
     }
     int size = 0;
-    for (const DataArray &t : private_.transmitList) {
-      size += t.size() - 8;
+    for (const Private::Transmit &t : private_.transmitList) {
+      size += t.data.size();
       if (size > private_.maxWriteSize) {
         setErrorString("Transmit overflow (" + peerString() + ')');
-        if (!private_.port) const_cast<DataArraySocket *>(this)->disconnect();
+        if (private_.server) const_cast<DataArraySocket *>(this)->disconnect();
         return;
       }
     }
@@ -314,10 +436,8 @@ bool DataArraySocket::transmit(const DataArray &ba, uint32_t pi, bool wait) cons
     uint64_t _v = pi;
     _v <<= 32;
     _v |= static_cast<uint32_t>(ba.size());
-    DataArray _da(((uint8_t *)&_v), ((uint8_t *)&_v) + 8);
-    _da += ba;
-    private_.transmitList.push_back(_da);
-    if (buffers == 0) thread_->invoke([this]() { const_cast<DataArraySocket *>(this)->writeSocket(); }, wait);
+    private_.transmitList.push_back({_v, std::move(ba)});
+    if (buffers == 0) invokeThread([this]() { const_cast<DataArraySocket *>(this)->writeSocket(); }, wait);
     else {
       if (wait) {
         thread_->requestInterrupt();
@@ -329,6 +449,25 @@ bool DataArraySocket::transmit(const DataArray &ba, uint32_t pi, bool wait) cons
   return _r;
 }
 
+bool DataArraySocket::invokeThread(const std::function<void()> &f, bool sync) const {
+  // a task queued before the socket moved to another thread (see moveToThread()) follows the socket
+  for (;;) {
+    Thread *_t = thread_;
+    if (!_t) return false;
+    if (!sync) return _t->invoke([this, _t, f]() {
+      if (thread_ == _t) f();
+      else invokeThread(f);
+    });
+    bool _d = false;
+    if (!_t->invoke([this, _t, &f, &_d]() {
+      if (thread_ != _t) return;
+      f();
+      _d = true;
+    }, true)) return false;
+    if (_d) return true;
+  }
+}
+
 void DataArraySocket::setConnectTimeout(int timeout) { private_.waitForConnectTimeout = timeout; }
 
 void DataArraySocket::setReconnectTimeout(int timeout) { private_.reconnectTimeout = timeout; }
@@ -342,6 +481,7 @@ void DataArraySocket::setWaitKeepAliveResponseTimeout(int timeout) { ((private_.
 void DataArraySocket::setReadBuffers(int buffers, int size) {
   private_.maxReadBuffers = buffers;
   private_.maxReadSize = size;
+  private_.checkWatermarks();
 }
 
 void DataArraySocket::setWriteBuffers(int buffers, int size) {
@@ -349,13 +489,53 @@ void DataArraySocket::setWriteBuffers(int buffers, int size) {
   private_.maxWriteSize = size;
 }
 
+void DataArraySocket::setReadWatermarks(int high, int low) {
+  private_.readHighWatermark = high;
+  private_.readLowWatermark = low;
+  private_.checkWatermarks();
+}
+
 void DataArraySocket::releaseBuffer(const DataArray *da) const {
-  if (thread_) thread_->invoke([this, da]() { private_.releaseBuffer(da); });
+  invokeThread([this, da]() {
+    private_.releaseBuffer(da);
+    const_cast<DataArraySocket *>(this)->updateBudget();
+    if (!(private_.flags & 0x20) || private_.bufferedSize() > private_.readLowWatermark || static_cast<int>(private_.receiveList.size()) >= private_.maxReadBuffers) return;
+    private_.flags &= ~0x20;
+    trace() << LogStream::Color::Green << "read low watermark (" + peerString() + ')';
+    if (!(private_.flags & 0x10)) const_cast<DataArraySocket *>(this)->setReadPaused(false);
+  });
+}
+
+SharedDataArray DataArraySocket::share(const DataArray *da) const { return SharedDataArray(std::shared_ptr<const DataArray>(static_cast<const Private::Frame *>(da)->shared_from_this())); }
+
+uint32_t DataArraySocket::receiveLatency() const { return private_.latency; }
+
+void DataArraySocket::pauseReceive() const {
+  if (!thread_) return;
+  auto _f = [this]() {
+    if (state_ != AbstractSocket::State::Active) return;
+    private_.flags |= 0x10;
+    const_cast<DataArraySocket *>(this)->setReadPaused(true);
+  };
+  if (std::this_thread::get_id() == thread_->id()) _f();
+  else invokeThread(_f);
+}
+
+void DataArraySocket::resumeReceive() const {
+  if (!thread_) return;
+  auto _f = [this]() {
+    if (!(private_.flags & 0x10)) return;
+    private_.flags &= ~0x10;
+    if (!(private_.flags & 0x20)) const_cast<DataArraySocket *>(this)->setReadPaused(false);
+  };
+  if (std::this_thread::get_id() == thread_->id()) _f();
+  else invokeThread(_f);
 }
 
 void DataArraySocket::initServerConnection() {
   private_.address = peerAddress();
   private_.port = peerPort();
+  private_.server = true;
   lsTrace();
   if (!contextEmpty()) {
     private_.sslConnection = 3;
@@ -375,7 +555,7 @@ uint16_t DataArraySocket::hostPort() const { return private_.port; }
 
 bool DataArraySocket::connectToHost() {
   checkCurrentThread();
-  if (private_.address.empty() || !private_.port) {
+  if (private_.address.empty() || (!private_.port && !isUnixAddress(private_.address))) {
     lsWarning("empty host address or port");
     return false;
   }
@@ -406,7 +586,7 @@ bool DataArraySocket::connectToHost(int timeout) {
     return false;
   }
 
-  thread_->invoke([this, timeout]() {
+  invokeThread([this, timeout]() {
     private_.flags |= 0x04;
     startTimer(timeout);
     connectToHost();
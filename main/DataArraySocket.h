@@ -9,11 +9,14 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 /** @file DataArraySocket.h @brief The DataArraySocket class. */
 
+#include <functional>
 #include "../core/AbstractTlsSocket.h"
 #include "../core/FunctionConnector.h"
 
 namespace AsyncFw {
 class TlsContext;
+class SharedDataArray;
+class DataChain;
 /** @class DataArraySocket DataArraySocket.h <AsyncFw/DataArraySocket> @brief An asynchronous socket class for transmitting data arrays (DataArray) with TLS support. Manages high-level data packet processing, read/write buffer boundaries, timeout intervals, keep-alive monitoring, and integration with TLS layers. */
 class DataArraySocket : public AbstractTlsSocket {
   friend class DataArrayAbstractTcp;
@@ -22,8 +25,12 @@ class DataArraySocket : public AbstractTlsSocket {
   friend LogStream &operator<<(LogStream &, const DataArraySocket &);
 
 public:
-  /** @brief Asynchronously transmits a data array through the socket. @param da Reference to the DataArray being sent. @param id The packet identifier. @param wait If true and called from outside the socket thread, blocks the thread until completion. @return True if the data was successfully queued for transmission. */
+  /** @brief Asynchronously transmits a data array through the socket. @param da Reference to the DataArray being sent. @param id The packet identifier. @param wait If true and called from outside the socket thread, blocks the thread until completion. @return True if the data was successfully queued for transmission, false also while the socket is over the BufferBudget (retry after the peer or the application drained the buffers). */
   bool transmit(const DataArray &, uint32_t, bool = false) const;
+  /** @brief Asynchronously transmits a shared array without copying it, see transmit(). @param da Array, the transmit queue holds a reference to it. @param id The packet identifier. @param wait Blocks the calling thread until completion. @return True if the data was queued for transmission. */
+  bool transmit(const SharedDataArray &, uint32_t, bool = false) const;
+  /** @brief Asynchronously transmits a chain of segments, see transmit(). Shared segments are queued without copying, borrowed ones are copied (DataChain::detached()). @param chain Segments of the array. @param id The packet identifier. @param wait Blocks the calling thread until completion. @return True if the data was queued for transmission. */
+  bool transmit(const DataChain &, uint32_t, bool = false) const;
   /** @brief Sets the timeout interval for connection establishment. @param timeout Timeout interval in milliseconds. */
   void setConnectTimeout(int timeout);
   /** @brief Sets the timeout interval for automatic reconnection upon disconnection. @param timeout Timeout interval in milliseconds. */
@@ -36,11 +43,19 @@ public:
   void setWaitKeepAliveResponseTimeout(int timeout);
   /** @brief Configures limits for incoming (read) data buffers. @param buffers Maximum number of simultaneously stored read buffers. @param size Maximum size of a single read buffer in bytes. */
   void setReadBuffers(int buffers, int size);
+  /** @brief Configures read flow control on the received buffers that are not yet released.
+  @details When the buffered size reaches the high watermark (or the buffer count reaches the read buffers limit), reading is paused instead of disconnecting: unread data stays in the kernel and TCP flow control slows the peer down. A frame that does not fit in the read size limit next to the buffered frames pauses reading as well. Reading resumes once releaseBuffer() brings the buffered size down to the low watermark.
+  @param high High watermark in bytes, zero disables flow control. It is lowered to the read size limit (see setReadBuffers()). @param low Low watermark in bytes. */
+  void setReadWatermarks(int high, int low);
+  /** @brief Pauses receiving until resumeReceive(), applying TCP backpressure to the peer. Thread-safe. */
+  void pauseReceive() const;
+  /** @brief Resumes receiving paused by pauseReceive(). Reading stays paused while the read high watermark holds it. Thread-safe. */
+  void resumeReceive() const;
   /** @brief Configures limits for outgoing (write) data buffers. @param buffers Maximum number of packet chunks allowed in the transmit queue. @param size Maximum cumulative size of the transmission data in bytes. */
   void setWriteBuffers(int buffers, int size);
   /** @brief Initializes the socket for a server-side connection (handling an accepted client). */
   void initServerConnection();
-  /** @brief Configures the remote host address and port for subsequent connection attempts. @param address IP address or domain name of the remote host. @param port Network port of the remote host. */
+  /** @brief Configures the remote host address and port for subsequent connection attempts. @param address IP address or domain name of the remote host, or a unix domain socket path. @param port Network port of the remote host, zero for a unix domain socket. */
   void setHost(const std::string &address, uint16_t port) const;
   /** @brief Gets the remote host address previously assigned via setHost. @return The host address string. */
   const std::string hostAddress() const;
@@ -56,6 +71,10 @@ public:
   void disconnect() override;
   /** @brief Frees the memory allocated for the read buffer associated with the given pointer. @param da Pointer to the data array that is no longer needed. */
   void releaseBuffer(const DataArray *) const;
+  /** @brief Shares a received buffer: the returned array keeps the bytes after releaseBuffer(), without copying them. @param da Pointer passed by received(), not yet released. @return Array holding the received bytes. Thread-safe. */
+  SharedDataArray share(const DataArray *) const;
+  /** @brief Returns the kernel-arrival-to-dispatch latency of the frame delivered by the current received emission, in microseconds. @details Measured only with AbstractSocket::setReceiveTimestamps(), zero otherwise. Every measured latency is also recorded in the histogram of the socket thread (Thread::receiveLatency()). */
+  uint32_t receiveLatency() const;
 
   /** @brief Signal / Connector triggered when the socket state changes. */
   FunctionConnector<AbstractSocket::State>::Policy<AbstractFunctionConnector::DirectOnly>::Protected<DataArraySocket> stateChanged;
@@ -68,6 +87,10 @@ protected:
   ~DataArraySocket() override;
   void stateEvent() override;
   void readEvent() override;
+  void moveEvent(bool) override;
+  void budgetEvent() override;
+  void idleEvent() override;
+  int64_t bufferedBytes() const override;
   using AbstractTlsSocket::connect;
 
 private:
@@ -75,6 +98,8 @@ private:
   bool connectToHost(int);
   void sendKeepAlive(bool);
   void writeSocket();
+  bool enqueue(DataChain &&, uint32_t, bool) const;
+  bool invokeThread(const std::function<void()> &, bool = false) const;
   void startTimer(int);
   void removeTimer();
   void timerEvent();
@@ -53,8 +53,8 @@ DataArraySocket *DataArrayTcpClient::createSocket(Thread *thread) {
 }
 
 void DataArrayTcpClient::destroySocket(DataArraySocket *socket) {
-  Thread *thread = static_cast<Thread *>(socket->thread());
-  thread->invoke([thread, socket]() { thread->destroySocket(socket); }, true);
+  // the socket may move to another thread while the task is queued, it is destroyed by the thread it belongs to
+  socket->invokeThread([socket]() { static_cast<Thread *>(socket->thread())->destroySocket(socket); }, true);
 }
 
 int DataArrayTcpClient::exchange(const DataArraySocket *socket, const DataArray &wda, const DataArray *rda, uint32_t pi, int timeout) {
@@ -107,8 +107,9 @@ void DataArrayTcpClient::connectToHost(const DataArraySocket *socket, int timeou
     lsWarning("unknown socket");
     return;
   }
-  if (std::find(disabledEncryptionHosts_.begin(), disabledEncryptionHosts_.end(), socket->hostAddress()) != disabledEncryptionHosts_.end()) const_cast<DataArraySocket *>(socket)->setContext(TlsContext());
-  clientThread->invoke([&socket, &timeout]() { const_cast<DataArraySocket *>(socket)->connectToHost(timeout); }, true);
+  const std::string _host = (unixAsLoopback && AbstractSocket::isUnixAddress(socket->hostAddress())) ? "127.0.0.1" : socket->hostAddress();
+  if (std::find(disabledEncryptionHosts_.begin(), disabledEncryptionHosts_.end(), _host) != disabledEncryptionHosts_.end()) const_cast<DataArraySocket *>(socket)->setContext(TlsContext());
+  socket->invokeThread([&socket, &timeout]() { const_cast<DataArraySocket *>(socket)->connectToHost(timeout); }, true);
   lsTrace();
 }
 
@@ -131,9 +132,9 @@ DataArraySocket *DataArrayTcpClient::Thread::createSocket() {
   tcpSocket->setReconnectTimeout(client()->reconnectTimeout_);
   tcpSocket->setContext(client()->tlsContext);
   initSocket(const_cast<DataArraySocket *>(tcpSocket));
-  tcpSocket->stateChanged.connect([this, tcpSocket](AbstractSocket::State state) {
+  tcpSocket->stateChanged.connect([tcpSocket](AbstractSocket::State state) {
     if (state != AbstractSocket::State::Connected && state != AbstractSocket::State::Active && state != AbstractSocket::State::Unconnected) return;
-    client()->socketStateChanged(tcpSocket);
+    static_cast<Thread *>(tcpSocket->thread())->client()->socketStateChanged(tcpSocket);  // the socket may have moved to another thread
   });
   return tcpSocket;
 }
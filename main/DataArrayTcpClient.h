@@ -42,7 +42,7 @@ public:
   };
   /** @brief Constructs a new DataArrayTcpClient object. @param name Optional name identifier for the client thread/instance (defaults to "TcpClient"). */
   DataArrayTcpClient(const std::string & = "TcpClient");
-  /** @brief Explicitly connects a specific socket to a target host and port. @param socket Pointer to the managed DataArraySocket instance. @param address Target IP address or hostname. @param port Target network port. @param timeout Connection timeout in milliseconds. If 0, uses the default timeout. */
+  /** @brief Explicitly connects a specific socket to a target host and port. @param socket Pointer to the managed DataArraySocket instance. @param address Target IP address or hostname, or a unix domain socket path. @param port Target network port, zero for a unix domain socket. @param timeout Connection timeout in milliseconds. If 0, uses the default timeout. */
   void connectToHost(DataArraySocket *socket, const std::string &, uint16_t, int = 0);
   /** @brief Initiates a connection using a pre-configured socket's internal host settings. @param socket Pointer to the managed DataArraySocket instance. @param timeout Connection timeout in milliseconds. If 0, uses the default timeout. */
   void connectToHost(const DataArraySocket *, int = 0);
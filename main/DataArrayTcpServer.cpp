@@ -6,6 +6,9 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 */
 
 #include <algorithm>
+#ifndef _WIN32
+  #include <sys/socket.h>
+#endif
 #include "core/LogStream.h"
 #include "ListenSocket.h"
 #include "DataArraySocket.h"
@@ -15,7 +18,7 @@ using namespace AsyncFw;
 
 DataArrayTcpServer::DataArrayTcpServer(const std::string &name) : DataArrayAbstractTcp(name) {
   listener = std::make_unique<ListenSocket>();
-  listener->incoming.connect([this](int descriptor, const std::string &address, bool *accept) { *accept = incomingConnection(descriptor, address); });
+  listener->incoming.connect([this](int descriptor, const sockaddr_storage *address, bool *accept) { *accept = incomingConnection(descriptor, address); });
   alwaysConnect_.emplace_back("127.0.0.1");
   lsTrace();
 }
@@ -25,15 +28,26 @@ void DataArrayTcpServer::quit() {
   DataArrayAbstractTcp::quit();
 }
 
-bool DataArrayTcpServer::listen(const std::string &address, uint16_t port) { return listener->listen(address, port); }
+bool DataArrayTcpServer::listen(const std::string &address, uint16_t port, int backlog) {
+  if (SocketOptions _o; socketProfile(_o)) listener->setOptions(_o);
+  return listener->listen(address, port, backlog);
+}
 
 void DataArrayTcpServer::close() { listener->close(); }
 
 void DataArrayTcpServer::setAlwaysConnect(const std::vector<std::string> &list) { alwaysConnect_ = list; }
 
-bool DataArrayTcpServer::listening() { return listener->port() != 0; }
+bool DataArrayTcpServer::listening() { return listener->listening(); }
+
+std::string DataArrayTcpServer::peerHost(const sockaddr_storage *address) {
+#ifndef _WIN32
+  // unix domain peers are mostly unnamed, they are matched by the listening path
+  if (reinterpret_cast<const sockaddr *>(address)->sa_family == AF_UNIX) return (unixAsLoopback) ? "127.0.0.1" : listener->address();
+#endif
+  return ListenSocket::addressString(address);
+}
 
-bool DataArrayTcpServer::incomingConnection(int socketDescriptor, const std::string &address) {
+bool DataArrayTcpServer::incomingConnection(int socketDescriptor, const sockaddr_storage *address) {
   lsTrace("readTimeout: {}, waitKeepAliveAnswerTimeout: {}, waitForEncryptionTimeout: {}, maxThreads: {}, maxSockets: {}, maxReadBuffers = {}, maxReadSize = {}, maxWriteBuffers = {}, maxWriteSize = {}", readTimeout, waitKeepAliveAnswerTimeout, waitForEncryptionTimeout, maxThreads, maxSockets, maxReadBuffers, maxReadSize, maxWriteBuffers, maxWriteSize);
   Thread *serverThread;
   mutex.lock();
@@ -45,7 +59,7 @@ bool DataArrayTcpServer::incomingConnection(int socketDescriptor, const std::str
   } else {
     mutex.lock();
     serverThread = static_cast<Thread *>(findMinimalSocketsThread());
-    if (!serverThread && std::find(alwaysConnect_.begin(), alwaysConnect_.end(), address) == alwaysConnect_.end()) b = true;
+    if (!serverThread && std::find(alwaysConnect_.begin(), alwaysConnect_.end(), peerHost(address)) == alwaysConnect_.end()) b = true;
     mutex.unlock();
     if (!serverThread) {
       lsError() << "many connections";
@@ -54,7 +68,7 @@ bool DataArrayTcpServer::incomingConnection(int socketDescriptor, const std::str
     if (b) return false;
   }
 
-  bool encrypt = std::find(disabledEncryptionHosts_.begin(), disabledEncryptionHosts_.end(), address) == disabledEncryptionHosts_.end() && !tlsContext.empty();
+  bool encrypt = !tlsContext.empty() && std::find(disabledEncryptionHosts_.begin(), disabledEncryptionHosts_.end(), peerHost(address)) == disabledEncryptionHosts_.end();
 
   serverThread->invoke([serverThread, socketDescriptor, encrypt]() { serverThread->createSocket(socketDescriptor, encrypt); }, true);
   return true;
@@ -70,9 +84,9 @@ void DataArrayTcpServer::Thread::createSocket(int socketDescriptor, bool encrypt
   std::string address = tcpSocket->peerAddress();
   initSocket(tcpSocket);
 
-  tcpSocket->stateChanged.connect([this, tcpSocket](AbstractSocket::State state) {
+  tcpSocket->stateChanged.connect([tcpSocket](AbstractSocket::State state) {
     if (state != AbstractSocket::State::Unconnected) return;
-    destroySocket(tcpSocket);
+    static_cast<Thread *>(tcpSocket->thread())->destroySocket(tcpSocket);  // the socket may have moved to another thread
   });
 
   if (encrypt) server()->setTlsContext(tcpSocket, server()->tlsContext);
@@ -22,8 +22,8 @@ public:
   DataArrayTcpServer(const std::string & = "TcpServer");
   /** @brief Stops the server and terminates all active worker threads and connections. */
   void quit() override;
-  /** @brief Starts listening for incoming connections on the specified address and port. @param address IP address to bind to (e.g., "0.0.0.0" or "127.0.0.1"). @param port Network port to listen on. @return True if the server successfully started listening. */
-  bool listen(const std::string &address, uint16_t port);
+  /** @brief Starts listening for incoming connections on the specified address and port. @param address IP address to bind to (e.g., "0.0.0.0" or "127.0.0.1"), or a unix domain socket path (e.g., "/run/app.sock" or "@app" in the abstract namespace). @param port Network port to listen on, ignored for a unix domain socket. @param backlog Maximum length of the queue of pending connections. @return True if the server successfully started listening. */
+  bool listen(const std::string &address, uint16_t port, int backlog = SOCKET_CONNECTION_QUEUED);
   /** @brief Closes the listening socket, preventing new connections while keeping current ones active. */
   void close();
   /** @brief Sets a list of remote addresses that are prioritized or persistently connected. @param list Vector of IP addresses. */
@@ -44,7 +44,8 @@ private:
   };
   std::unique_ptr<ListenSocket> listener;
 
-  bool incomingConnection(int, const std::string &);
+  bool incomingConnection(int, const sockaddr_storage *);
+  std::string peerHost(const sockaddr_storage *);
   std::vector<std::string> alwaysConnect_;
 };
 }  // namespace AsyncFw
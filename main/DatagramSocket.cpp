@@ -0,0 +1,400 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <vector>
+
+#include "core/AbstractSocket.h"
+#include "core/DataArray.h"
+#include "core/LogStream.h"
+#include "DatagramSocket.h"
+
+#ifndef UDP_SEGMENT
+  #define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+  #define UDP_GRO 104
+#endif
+
+#if !defined LS_NO_ERROR
+  #define AsyncFw_THREAD private_.thread
+#endif
+
+#ifdef EXTEND_SOCKET_TRACE
+  #define ENABLE_EXTEND_TRACE
+#endif
+#include "core/extend_trace.hpp"
+
+#define DATAGRAM_SOCKET_MAX_SIZE 65535
+#define DATAGRAM_SOCKET_READ_BATCHES 8
+
+using namespace AsyncFw;
+
+struct DatagramSocket::Private {
+  struct Control {
+    alignas(cmsghdr) uint8_t data[CMSG_SPACE(sizeof(int))];
+  };
+  void resizeReadBuffers(int size) {
+    rb.resize(static_cast<std::size_t>(size) * DATAGRAM_SOCKET_BATCH);
+    for (int i = 0; i != DATAGRAM_SOCKET_BATCH; ++i) {
+      riov[i].iov_base = rb.data() + static_cast<std::size_t>(size) * i;
+      riov[i].iov_len = size;
+      rm[i].msg_hdr.msg_iov = &riov[i];
+      rm[i].msg_hdr.msg_iovlen = 1;
+      rm[i].msg_hdr.msg_name = &ra[i];
+    }
+  }
+  AbstractThread *thread;
+  int fd = -1;
+  int family = AF_INET;
+  std::vector<uint8_t> rb;  // read buffer ring, DATAGRAM_SOCKET_BATCH slots
+  mmsghdr rm[DATAGRAM_SOCKET_BATCH];
+  iovec riov[DATAGRAM_SOCKET_BATCH];
+  sockaddr_storage ra[DATAGRAM_SOCKET_BATCH];
+  Control rc[DATAGRAM_SOCKET_BATCH];
+  DataArray sd[DATAGRAM_SOCKET_BATCH];  // send queue slots, capacity is kept between batches
+  mmsghdr sm[DATAGRAM_SOCKET_BATCH];
+  iovec siov[DATAGRAM_SOCKET_BATCH];
+  sockaddr_storage sa[DATAGRAM_SOCKET_BATCH];
+  int sq = 0;  // queued datagrams
+  int ss = 0;  // first unsent datagram
+  bool gro = false;
+  bool pollOut = false;
+  bool dispatch = false;  // received() slots are executing, the queue is flushed after them
+};
+
+DatagramSocket::DatagramSocket() : private_(*new Private) {
+  private_.thread = AbstractThread::current();
+  memset(private_.rm, 0, sizeof(private_.rm));
+  memset(private_.sm, 0, sizeof(private_.sm));
+  for (int i = 0; i != DATAGRAM_SOCKET_BATCH; ++i) private_.rc[i] = {};
+  private_.resizeReadBuffers(DATAGRAM_SOCKET_BUFFER_SIZE);
+  lsTrace();
+}
+
+DatagramSocket::~DatagramSocket() {
+  if (private_.fd != -1) {
+    if (private_.sq) flush();
+    close();
+  }
+  delete &private_;
+  lsTrace();
+}
+
+bool DatagramSocket::createSocket(int family) {
+  if (private_.fd != -1) {
+    if (private_.family == family) return true;
+    lsError() << "address family mismatch" << private_.fd;
+    return false;
+  }
+  int _fd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+  if (_fd < 0) {
+    lsError() << "socket descriptor error" << _fd << errno;
+    return false;
+  }
+  if (!private_.thread->appendPollTask(_fd, AbstractThread::PollIn, [this](AbstractThread::PollEvents _e) { pollEvent(_e); })) {
+    lsError() << "append poll task error" << _fd;
+    ::close(_fd);
+    return false;
+  }
+  private_.fd = _fd;
+  private_.family = family;
+  trace() << private_.fd;
+  return true;
+}
+
+bool DatagramSocket::makeAddress(const std::string &address, uint16_t port, sockaddr_storage *result) {
+  memset(result, 0, sizeof(sockaddr_storage));
+  if (address.find(':') != std::string::npos) {
+    sockaddr_in6 *_a = reinterpret_cast<sockaddr_in6 *>(result);
+    _a->sin6_family = AF_INET6;
+    _a->sin6_port = htons(port);
+    return inet_pton(AF_INET6, address.c_str(), &_a->sin6_addr) == 1;
+  }
+  sockaddr_in *_a = reinterpret_cast<sockaddr_in *>(result);
+  _a->sin_family = AF_INET;
+  _a->sin_port = htons(port);
+  if (address.empty()) {
+    _a->sin_addr.s_addr = htonl(INADDR_ANY);
+    return true;
+  }
+  return inet_pton(AF_INET, address.c_str(), &_a->sin_addr) == 1;
+}
+
+bool DatagramSocket::bind(const std::string &address, uint16_t port) {
+  checkCurrentThread();
+  sockaddr_storage _a;
+  if (!makeAddress(address, port, &_a)) {
+    lsError() << "invalid address:" << address;
+    return false;
+  }
+  if (!createSocket(_a.ss_family)) return false;
+  int _val = 1;
+  if (setsockopt(private_.fd, SOL_SOCKET, SO_REUSEADDR, &_val, sizeof _val) < 0) lsError("set SO_REUSEADDR");
+  if (::bind(private_.fd, reinterpret_cast<sockaddr *>(&_a), (_a.ss_family == AF_INET) ? sizeof(sockaddr_in) : sizeof(sockaddr_in6))) {
+    lsError() << "bind error:" << address << port << errno;
+    return false;
+  }
+  return true;
+}
+
+bool DatagramSocket::connect(const std::string &address, uint16_t port) {
+  checkCurrentThread();
+  sockaddr_storage _a;
+  if (!makeAddress(address, port, &_a)) {
+    lsError() << "invalid address:" << address;
+    return false;
+  }
+  if (!createSocket(_a.ss_family)) return false;
+  if (::connect(private_.fd, reinterpret_cast<sockaddr *>(&_a), (_a.ss_family == AF_INET) ? sizeof(sockaddr_in) : sizeof(sockaddr_in6))) {
+    lsError() << "connect error:" << address << port << errno;
+    return false;
+  }
+  return true;
+}
+
+void DatagramSocket::close() {
+  checkCurrentThread();
+  if (private_.fd == -1) return;
+  trace() << private_.fd;
+  private_.thread->removePollDescriptor(private_.fd);
+  ::close(private_.fd);
+  private_.fd = -1;
+  private_.sq = 0;
+  private_.ss = 0;
+  private_.pollOut = false;
+}
+
+int DatagramSocket::send(const uint8_t *data, int size, const sockaddr_storage *address) {
+  checkCurrentThread();
+  if (private_.fd == -1 && !createSocket((address) ? address->ss_family : AF_INET)) return -1;
+  if (private_.sq == DATAGRAM_SOCKET_BATCH) {
+    flush();
+    if (private_.sq == DATAGRAM_SOCKET_BATCH) {
+      trace() << LogStream::Color::Red << "send queue full";
+      return -1;
+    }
+  }
+  const int i = private_.sq++;
+  private_.sd[i].assign(data, data + size);
+  private_.siov[i].iov_base = private_.sd[i].data();
+  private_.siov[i].iov_len = size;
+  msghdr &_h = private_.sm[i].msg_hdr;
+  _h.msg_iov = &private_.siov[i];
+  _h.msg_iovlen = 1;
+  if (address) {
+    private_.sa[i] = *address;
+    _h.msg_name = &private_.sa[i];
+    _h.msg_namelen = (address->ss_family == AF_INET) ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+  } else {
+    _h.msg_name = nullptr;
+    _h.msg_namelen = 0;
+  }
+  if (private_.sq == DATAGRAM_SOCKET_BATCH && !private_.dispatch) flush();
+  return size;
+}
+
+int DatagramSocket::send(const DataArray &data, const sockaddr_storage *address) { return send(data.data(), data.size(), address); }
+
+int DatagramSocket::send(const DataArray &data, const std::string &address, uint16_t port) {
+  sockaddr_storage _a;
+  if (!makeAddress(address, port, &_a)) {
+    lsError() << "invalid address:" << address;
+    return -1;
+  }
+  return send(data.data(), data.size(), &_a);
+}
+
+int DatagramSocket::flush() {
+  checkCurrentThread();
+  int _n = 0;
+  while (private_.ss != private_.sq) {
+    int r = sendmmsg(private_.fd, private_.sm + private_.ss, private_.sq - private_.ss, 0);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) {
+        if (!private_.pollOut) {
+          private_.pollOut = true;
+          private_.thread->modifyPollDescriptor(private_.fd, static_cast<AbstractThread::PollEvents>(AbstractThread::PollIn | AbstractThread::PollOut));
+        }
+        return _n;
+      }
+      // the failed datagram is dropped, the rest of the batch is retried
+      lsWarning() << LogStream::Color::Red << "send error" << private_.fd << errno;
+      ++private_.ss;
+      continue;
+    }
+    private_.ss += r;
+    _n += r;
+  }
+  private_.sq = 0;
+  private_.ss = 0;
+  if (private_.pollOut) {
+    private_.pollOut = false;
+    private_.thread->modifyPollDescriptor(private_.fd, AbstractThread::PollIn);
+  }
+  return _n;
+}
+
+int DatagramSocket::pendingSend() const { return private_.sq - private_.ss; }
+
+bool DatagramSocket::setSegmentSize(int size) {
+  checkCurrentThread();
+  if (private_.fd == -1 && !createSocket(AF_INET)) return false;
+  if (setsockopt(private_.fd, SOL_UDP, UDP_SEGMENT, &size, sizeof size) < 0) {
+    lsError() << "set UDP_SEGMENT" << errno;
+    return false;
+  }
+  return true;
+}
+
+bool DatagramSocket::setReceiveOffload(bool enable) {
+  checkCurrentThread();
+  if (private_.fd == -1 && !createSocket(AF_INET)) return false;
+  int _val = enable;
+  if (setsockopt(private_.fd, SOL_UDP, UDP_GRO, &_val, sizeof _val) < 0) {
+    lsError() << "set UDP_GRO" << errno;
+    return false;
+  }
+  private_.gro = enable;
+  private_.resizeReadBuffers((enable) ? DATAGRAM_SOCKET_MAX_SIZE : DATAGRAM_SOCKET_BUFFER_SIZE);
+  return true;
+}
+
+bool DatagramSocket::joinGroup(const std::string &group, const std::string &interface) { return multicast(group, interface, true); }
+
+bool DatagramSocket::leaveGroup(const std::string &group, const std::string &interface) { return multicast(group, interface, false); }
+
+bool DatagramSocket::multicast(const std::string &group, const std::string &interface, bool join) {
+  checkCurrentThread();
+  sockaddr_storage _a;
+  if (!makeAddress(group, 0, &_a)) {
+    lsError() << "invalid group address:" << group;
+    return false;
+  }
+  if (!createSocket(_a.ss_family)) return false;
+  const unsigned int _i = (interface.empty()) ? 0 : if_nametoindex(interface.c_str());
+  if (!interface.empty() && !_i) {
+    lsError() << "invalid interface:" << interface;
+    return false;
+  }
+  int r;
+  if (_a.ss_family == AF_INET) {
+    ip_mreqn _m {};
+    _m.imr_multiaddr = reinterpret_cast<sockaddr_in *>(&_a)->sin_addr;
+    _m.imr_ifindex = _i;
+    r = setsockopt(private_.fd, IPPROTO_IP, (join) ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &_m, sizeof _m);
+  } else {
+    ipv6_mreq _m {};
+    _m.ipv6mr_multiaddr = reinterpret_cast<sockaddr_in6 *>(&_a)->sin6_addr;
+    _m.ipv6mr_interface = _i;
+    r = setsockopt(private_.fd, IPPROTO_IPV6, (join) ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP, &_m, sizeof _m);
+  }
+  if (r < 0) {
+    lsError() << ((join) ? "join group error:" : "leave group error:") << group << errno;
+    return false;
+  }
+  return true;
+}
+
+bool DatagramSocket::setMulticastLoop(bool enable) {
+  checkCurrentThread();
+  if (private_.fd == -1 && !createSocket(AF_INET)) return false;
+  int _val = enable;
+  if (private_.family == AF_INET) return setsockopt(private_.fd, IPPROTO_IP, IP_MULTICAST_LOOP, &_val, sizeof _val) == 0;
+  return setsockopt(private_.fd, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &_val, sizeof _val) == 0;
+}
+
+bool DatagramSocket::setMulticastTtl(int ttl) {
+  checkCurrentThread();
+  if (private_.fd == -1 && !createSocket(AF_INET)) return false;
+  if (private_.family == AF_INET) return setsockopt(private_.fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof ttl) == 0;
+  return setsockopt(private_.fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &ttl, sizeof ttl) == 0;
+}
+
+int DatagramSocket::descriptor() const { return private_.fd; }
+
+std::string DatagramSocket::address() const {
+  sockaddr_storage _a;
+  socklen_t _l = sizeof _a;
+  if (private_.fd == -1 || getsockname(private_.fd, reinterpret_cast<sockaddr *>(&_a), &_l)) return {};
+  return AbstractSocket::addressString(&_a);
+}
+
+uint16_t DatagramSocket::port() const {
+  sockaddr_storage _a;
+  socklen_t _l = sizeof _a;
+  if (private_.fd == -1 || getsockname(private_.fd, reinterpret_cast<sockaddr *>(&_a), &_l)) return 0;
+  if (_a.ss_family == AF_INET) return ntohs(reinterpret_cast<sockaddr_in *>(&_a)->sin_port);
+  return ntohs(reinterpret_cast<sockaddr_in6 *>(&_a)->sin6_port);
+}
+
+void DatagramSocket::pollEvent(AbstractThread::PollEvents events) {
+  trace() << private_.fd << events;
+  if (events & AbstractThread::PollOut) flush();
+  if (events & AbstractThread::PollIn) readEvent();
+  if (events & ~(AbstractThread::PollIn | AbstractThread::PollOut)) {
+    int _e = 0;
+    socklen_t _l = sizeof _e;
+    getsockopt(private_.fd, SOL_SOCKET, SO_ERROR, &_e, &_l);  // clears a pending ICMP error
+    lsDebug() << LogStream::Color::Red << "descriptor:" << private_.fd << "event:" << events << "error:" << _e;
+  }
+}
+
+void DatagramSocket::readEvent() {
+  const int _size = private_.riov[0].iov_len;
+  for (int _b = 0; _b != DATAGRAM_SOCKET_READ_BATCHES; ++_b) {
+    for (int i = 0; i != DATAGRAM_SOCKET_BATCH; ++i) {
+      private_.rm[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+      private_.rm[i].msg_hdr.msg_control = (private_.gro) ? private_.rc[i].data : nullptr;
+      private_.rm[i].msg_hdr.msg_controllen = (private_.gro) ? sizeof(Private::Control) : 0;
+    }
+    int r = recvmmsg(private_.fd, private_.rm, DATAGRAM_SOCKET_BATCH, 0, nullptr);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN) lsWarning() << LogStream::Color::Red << "receive error" << private_.fd << errno;
+      break;
+    }
+    private_.dispatch = true;
+    for (int i = 0; i != r; ++i) {
+      const msghdr &_h = private_.rm[i].msg_hdr;
+      const uint8_t *_d = static_cast<const uint8_t *>(_h.msg_iov->iov_base);
+      const int _l = private_.rm[i].msg_len;
+      if (_h.msg_flags & MSG_TRUNC) lsWarning() << "datagram truncated to" << _size;
+      int _s = _l;
+      if (private_.gro) {
+        for (const cmsghdr *_c = CMSG_FIRSTHDR(&_h); _c; _c = CMSG_NXTHDR(const_cast<msghdr *>(&_h), const_cast<cmsghdr *>(_c))) {
+          if (_c->cmsg_level == SOL_UDP && _c->cmsg_type == UDP_GRO) {
+            int _v;
+            memcpy(&_v, CMSG_DATA(_c), sizeof _v);
+            if (_v > 0) _s = _v;
+            break;
+          }
+        }
+      }
+      for (int _o = 0; _o < _l; _o += _s) received(_d + _o, std::min(_s, _l - _o), &private_.ra[i]);
+      if (!_l) received(_d, 0, &private_.ra[i]);
+      if (private_.fd == -1) {
+        private_.dispatch = false;
+        return;
+      }
+    }
+    private_.dispatch = false;
+    if (r != DATAGRAM_SOCKET_BATCH) break;
+  }
+  if (private_.sq) flush();
+}
+
+namespace AsyncFw {
+LogStream &operator<<(LogStream &log, const DatagramSocket &s) { return log << s.private_.fd << '-' << s.address() + ':' + std::to_string(s.port()) << s.pendingSend(); }
+}  // namespace AsyncFw
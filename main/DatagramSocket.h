@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2019-2026 Alexandr Kuzmuk
+
+This file is part of the AsyncFw project. Licensed under the MIT License.
+See {Link: LICENSE file https://mit-license.org} in the project root for full license information.
+*/
+
+#pragma once
+
+/** @file DatagramSocket.h @brief The DatagramSocket class. */
+
+#include <cstdint>
+#include <string>
+#include "../core/FunctionConnector.h"
+
+#ifndef DATAGRAM_SOCKET_BATCH
+  #define DATAGRAM_SOCKET_BATCH 32
+#endif
+
+#ifndef DATAGRAM_SOCKET_BUFFER_SIZE
+  #define DATAGRAM_SOCKET_BUFFER_SIZE 2048
+#endif
+
+struct sockaddr_storage;
+
+namespace AsyncFw {
+class DataArray;
+class LogStream;
+
+/** @class DatagramSocket DatagramSocket.h <AsyncFw/DatagramSocket> @brief UDP socket integrated with the AbstractThread polling loop.
+@details Incoming datagrams are received in batches (recvmmsg) into a preallocated buffer ring and delivered through the \ref received connector. Outgoing datagrams are queued and sent in batches (sendmmsg): the queue is flushed when it is full, after the \ref received slots of a batch return, or by flush(). The socket is created by bind(), connect() or the first send() and must be used from the thread that constructed it.
+@note Linux only. */
+class DatagramSocket {
+  friend LogStream &operator<<(LogStream &, const DatagramSocket &);
+
+public:
+  DatagramSocket();
+  ~DatagramSocket();
+  /** @brief Binds the socket to a local address. @param address IPv4 or IPv6 address, empty string binds to any IPv4 address. @param port Local port, zero selects an ephemeral port. @return True if success. */
+  bool bind(const std::string &, uint16_t);
+  /** @brief Sets the default destination, datagrams from other sources are discarded by the kernel. @param address Remote IPv4 or IPv6 address. @param port Remote port. @return True if success. */
+  bool connect(const std::string &, uint16_t);
+  /** @brief Closes the socket, unsent datagrams are discarded. */
+  void close();
+  /** @brief Queues a datagram. @param data Payload. @param size Payload size. @param address Destination, nullptr sends to the connected address. @return Size of queued data, or -1 if the queue is full and the socket is not writable. */
+  int send(const uint8_t *, int, const sockaddr_storage * = nullptr);
+  /** @brief Queues a datagram. @param data Payload. @param address Destination, nullptr sends to the connected address. @return Size of queued data, or -1 on error. */
+  int send(const DataArray &, const sockaddr_storage * = nullptr);
+  /** @brief Queues a datagram. @param data Payload. @param address Destination address. @param port Destination port. @return Size of queued data, or -1 on error. */
+  int send(const DataArray &, const std::string &, uint16_t);
+  /** @brief Sends the queued datagrams. @return Number of datagrams sent. */
+  int flush();
+  /** @brief Returns the number of queued datagrams. */
+  int pendingSend() const;
+  /** @brief Enables UDP generic segmentation offload (UDP_SEGMENT): a queued payload larger than the segment size is split by the kernel into datagrams of that size. @param size Segment size, zero disables. @return True if success. @note At most 64 segments per payload. */
+  bool setSegmentSize(int);
+  /** @brief Enables UDP generic receive offload (UDP_GRO): the kernel coalesces datagrams of one flow, they are split back before delivery. @param enable Enable offload. @return True if success. @note Enlarges the receive buffers to the maximum datagram size. */
+  bool setReceiveOffload(bool);
+  /** @brief Joins a multicast group. @param group Multicast group address. @param interface Interface name, empty string lets the kernel choose. @return True if success. */
+  bool joinGroup(const std::string &, const std::string & = {});
+  /** @brief Leaves a multicast group. @param group Multicast group address. @param interface Interface name. @return True if success. */
+  bool leaveGroup(const std::string &, const std::string & = {});
+  /** @brief Enables loopback of sent multicast datagrams. @param enable Enable loopback. @return True if success. */
+  bool setMulticastLoop(bool);
+  /** @brief Sets the time-to-live (hop limit) of sent multicast datagrams. @param ttl Time-to-live. @return True if success. */
+  bool setMulticastTtl(int);
+  /** @brief Returns the socket descriptor. */
+  int descriptor() const;
+  /** @brief Return local address bound to this socket. */
+  std::string address() const;
+  /** @brief Return local port bound to this socket. */
+  uint16_t port() const;
+  /** @brief Converts an address string and port to a native socket address. @param address IPv4 or IPv6 address. @param port Port. @param result Pointer to the native address. @return True if success. */
+  static bool makeAddress(const std::string &, uint16_t, sockaddr_storage *);
+
+  /** @brief Synchronous signal connector emitted for every received datagram.
+  @details Slots subscribing to this connector must accept: @n - const uint8_t *: The datagram payload, valid only during the call. @n - int: The payload size. @n - const sockaddr_storage *: The source address, AbstractSocket::addressString() converts it to a string. */
+  AsyncFw::FunctionConnector<const uint8_t *, int, const sockaddr_storage *>::Policy<AsyncFw::AbstractFunctionConnector::SyncOnly>::Protected<DatagramSocket> received;
+
+private:
+  DatagramSocket(const DatagramSocket &) = delete;
+  DatagramSocket &operator=(const DatagramSocket &) = delete;
+  bool createSocket(int);
+  void pollEvent(AbstractThread::PollEvents);
+  void readEvent();
+  bool multicast(const std::string &, const std::string &, bool);
+  struct Private;
+  Private &private_;
+};
+}  // namespace AsyncFw
@@ -350,10 +350,19 @@ struct HttpServer::Private {
       {"zip", "application/zip"},
   };
 
+  struct Worker {
+    AsyncFw::Thread *thread;
+    AsyncFw::ListenSocket *listener;
+  };
+
   std::string httpPath;
   AsyncFw::TlsContext tlsContext;
   AsyncFw::ListenSocket listener;
   FunctionConnectionGuard listenerGuard;
+  std::vector<Worker> workers;
+  std::unique_ptr<AsyncFw::SocketOptions> socketOptions;
+  int tcpInfoInterval = 0;
+  bool cpuSteering = false;
 };
 
 struct HttpServer::Request::Private {
@@ -375,8 +384,12 @@ HttpServer::TcpSocket::TcpSocket(HttpServer *server) : HttpSocket(), server_(ser
   stateChanged.connect([this](AbstractSocket::State _state) {
     if (_state != Unconnected) return;
     if (response) response->socket_ = nullptr;
-    if (server_) server_->sockets.erase(std::find(server_->sockets.begin(), server_->sockets.end(), this));
-    lsInfoCyan() << "unconnected" << peerAddress() << peerPort() << "sockets:" << server_->sockets.size();
+    if (server_) {
+      std::lock_guard<std::mutex> lock(server_->socketsMutex);
+      server_->sockets.erase(std::find(server_->sockets.begin(), server_->sockets.end(), this));
+      lsInfoCyan() << "unconnected" << peerAddress() << peerPort() << "sockets:" << server_->sockets.size();
+    } else
+      lsInfoCyan() << "unconnected" << peerAddress() << peerPort();
     destroy();
   });
   received.connect([this](const DataArray &request) {
@@ -465,31 +478,64 @@ HttpServer::~HttpServer() {
   if (instance_.value == this) instance_.value = nullptr;
   if (peek) delete peek;
   clearConnections();
+  stopWorkers();
   delete &private_;
   lsTrace();
 }
 
 void HttpServer::clearConnections() {
+  std::lock_guard<std::mutex> lock(socketsMutex);
   for (TcpSocket *socket : sockets) disconnectFromHost(socket);
 }
 
+void HttpServer::stopWorkers() {
+  for (Private::Worker &_w : private_.workers) {
+    _w.thread->invoke([this, &_w]() {
+      _w.listener->destroy();
+      std::vector<TcpSocket *> _l;
+      {  //lock scope
+        std::lock_guard<std::mutex> lock(socketsMutex);
+        for (TcpSocket *socket : sockets)
+          if (socket->thread() == _w.thread) _l.push_back(socket);
+      }
+      for (TcpSocket *socket : _l) socket->close();
+    }, true);
+    _w.thread->quit();
+    _w.thread->waitFinished();
+    delete _w.thread;
+  }
+  private_.workers.clear();
+}
+
 void HttpServer::fileUploadProgress(TcpSocket *, int progress) { trace() << progress; }
 
 void HttpServer::disconnectFromHost(TcpSocket *socket) {
   lsTrace();
-  AbstractThread::current()->invoke([socket]() { socket->disconnect(); });
+  socket->thread()->invoke([socket]() { socket->disconnect(); });
+}
+
+bool HttpServer::writeSocket(TcpSocket *socket, const DataArray &da) {
+  if (socket->thread() == AbstractThread::current()) return socket->write(da) > 0;
+  return socket->thread()->invoke([this, socket, da]() {
+    {  //lock scope
+      std::lock_guard<std::mutex> lock(socketsMutex);
+      if (std::find(sockets.begin(), sockets.end(), socket) == sockets.end()) return;
+    }
+    socket->write(da);
+  });
 }
 
 bool HttpServer::webSocketSend(const HttpSocket *socket, const DataArray &data) {
   if (!static_cast<const TcpSocket *>(socket)->ws_) return false;
   DataArray _out;
   if (makeWebSocketFrame(data, &_out) <= 0) return false;
-  return const_cast<HttpSocket *>(socket)->write(_out) > 0;
+  return writeSocket(static_cast<TcpSocket *>(const_cast<HttpSocket *>(socket)), _out);
 }
 
 void HttpServer::sendToWebSockets(const std::string &data) {  //Дичь, для отладки, надо убрать
   std::string _f;
 
+  std::lock_guard<std::mutex> lock(socketsMutex);
   for (HttpServer::TcpSocket *socket : sockets) {
     if (!socket->ws_) continue;
     if (_f.empty()) {
@@ -497,45 +543,119 @@ void HttpServer::sendToWebSockets(const std::string &data) {  //Дичь, для
       int size = socket->ws_->makeFrame(WebSocketFrameType::TEXT_FRAME, (unsigned char *)data.data(), data.size(), (unsigned char *)_f.data(), _f.size());
       _f.resize(size);
     }
-    socket->write(_f);
+    writeSocket(socket, _f);
   }
 }
 
-bool HttpServer::listen(uint16_t port) {
+bool HttpServer::listen(uint16_t port, int workers, int backlog) {
   warning_if(!private_.tlsContext.empty()) << private_.tlsContext.infoCertificate();
-  bool b = private_.listener.listen("0.0.0.0", port);
-  if (b) {
-    private_.listenerGuard = private_.listener.incoming.connect([this](int descriptor, const std::string &address, bool *accept) {
-      incoming(descriptor, address, accept);
-      if (!*accept) {
-        TcpSocket *socket = new TcpSocket(this);
-        sockets.emplace_back(socket);
-        trace() << "(incoming) socket created, total:" << sockets.size() << "tls data" << !private_.tlsContext.empty();
-        if (!private_.tlsContext.empty()) socket->AbstractSocket::setDescriptor(descriptor);
-        else {
-          socket->setContext(private_.tlsContext);
-          socket->setDescriptor(descriptor);
-        }
-        *accept = true;
-      }
-    });
-    lsDebug() << LogStream::Color::Green << *this;
-  } else {
-    lsError() << "Tcp server listen error, port:" << port;
+  if (workers <= 0) {
+    if (private_.socketOptions) private_.listener.setOptions(*private_.socketOptions);
+    bool b = private_.listener.listen("0.0.0.0", port, backlog);
+    if (b) {
+      if (private_.tcpInfoInterval) private_.listener.thread()->setTcpInfoInterval(private_.tcpInfoInterval);
+      private_.listenerGuard = private_.listener.incoming.connect([this](int descriptor, const sockaddr_storage *address, bool *accept) { incomingConnection(descriptor, address, accept); });
+      lsDebug() << LogStream::Color::Green << *this;
+    } else {
+      lsError() << "Tcp server listen error, port:" << port;
+    }
+    return b;
   }
-  return b;
+  if (!port || !private_.workers.empty()) {
+    lsError() << "Tcp server workers listen error, port:" << port << "workers:" << private_.workers.size();
+    return false;
+  }
+  for (int i = 0; i != workers; ++i) {
+    Thread *_t = new Thread("HttpServer-" + std::to_string(i));
+    _t->start();
+    bool b = false;
+    _t->invoke([this, port, workers, backlog, &b]() {
+      ListenSocket *_l = new ListenSocket;
+      _l->setReusePort(true);
+      if (private_.socketOptions) _l->setOptions(*private_.socketOptions);
+      if ((b = _l->listen("0.0.0.0", port, backlog))) {
+        _l->incoming.connect([this](int descriptor, const sockaddr_storage *address, bool *accept) { incomingConnection(descriptor, address, accept); });
+        private_.workers.push_back({Thread::current(), _l});
+        if (private_.tcpInfoInterval) Thread::current()->setTcpInfoInterval(private_.tcpInfoInterval);
+        if (private_.cpuSteering && static_cast<int>(private_.workers.size()) == workers) _l->setCpuSteering(workers);
+      } else _l->destroy();
+    }, true);
+    if (!b) {
+      lsError() << "Tcp server listen error, port:" << port << "worker:" << i;
+      _t->quit();
+      _t->waitFinished();
+      delete _t;
+      stopWorkers();
+      return false;
+    }
+  }
+  lsDebug() << LogStream::Color::Green << *this;
+  return true;
+}
+
+void HttpServer::incomingConnection(int descriptor, const sockaddr_storage *address, bool *accept) {
+  incoming(descriptor, address, accept);
+  if (*accept) return;
+  TcpSocket *socket = new TcpSocket(this);
+  std::size_t _n;
+  {  //lock scope
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    sockets.emplace_back(socket);
+    _n = sockets.size();
+  }
+  trace() << "(incoming) socket created, total:" << _n << "tls data" << !private_.tlsContext.empty();
+  if (private_.socketOptions) socket->setOptions(*private_.socketOptions);
+  if (!private_.tlsContext.empty()) socket->AbstractSocket::setDescriptor(descriptor);
+  else {
+    socket->setContext(private_.tlsContext);
+    socket->setDescriptor(descriptor);
+  }
+  *accept = true;
 }
 
 void HttpServer::close() {
-  if (!private_.listener.port()) {
+  if (!port()) {
     lsError() << "not listen";
     return;
   }
-  lsDebug() << LogStream::Color::Blue << "Tcp server close, port: " + std::to_string(private_.listener.port());
+  lsDebug() << LogStream::Color::Blue << "Tcp server close, port: " + std::to_string(port());
+  stopWorkers();
   private_.listener.close();
   private_.listenerGuard = {};
 }
 
+void HttpServer::setCpuSteering(bool b) { private_.cpuSteering = b; }
+
+void HttpServer::setSocketOptions(const SocketOptions &options) { private_.socketOptions = std::make_unique<SocketOptions>(options); }
+
+void HttpServer::setTcpInfoInterval(int ms) {
+  private_.tcpInfoInterval = ms;
+  if (private_.workers.empty()) {
+    if (private_.listener.listening()) private_.listener.thread()->setTcpInfoInterval(ms);
+    return;
+  }
+  for (Private::Worker &_w : private_.workers) _w.thread->setTcpInfoInterval(ms);
+}
+
+TcpInfoSummary HttpServer::tcpInfoSummary() {
+  TcpInfoSummary _s;
+  const auto _f = [this, &_s]() {
+    std::lock_guard<std::mutex> lock(socketsMutex);
+    for (TcpSocket *socket : sockets)
+      if (socket->thread() == Thread::current()) _s.append(socket->tcpInfo());
+  };
+  if (private_.workers.empty()) private_.listener.thread()->invoke(_f, true);
+  for (Private::Worker &_w : private_.workers) _w.thread->invoke(_f, true);
+  return _s;
+}
+
+int64_t HttpServer::bufferUsage() {
+  int64_t _s = 0;
+  std::lock_guard<std::mutex> lock(socketsMutex);
+  for (const TcpSocket *socket : sockets) _s += socket->bufferUsage();
+  return _s;
+}
+
 bool HttpServer::execRule(const Request &req) {
   RulesMap::iterator rule;
   std::string path = req.path();
@@ -556,7 +676,7 @@ bool HttpServer::execRule(const Request &req) {
   return true;
 }
 
-uint16_t HttpServer::port() { return private_.listener.port(); }
+uint16_t HttpServer::port() { return (private_.workers.empty()) ? private_.listener.port() : private_.workers.front().listener->port(); }
 
 void HttpServer::received(TcpSocket *socket, const std::string_view &ba) {
   trace() << LogStream::Color::Red << ba;
@@ -641,8 +761,8 @@ bool HttpServer::Response::send() {
     destroy();
     return false;
   }
-  if (content_.view().find("file://") == 0) {
-    std::string fn(content_.begin() + 7, content_.end());
+  if (content_.segmentCount() == 1 && content_.segment(0).starts_with("file://")) {
+    std::string fn(content_.segment(0).substr(7));
     if (std::filesystem::exists(fn)) {
       if (mimeType_.empty()) {
         std::string ext = std::filesystem::path(fn).extension().string();
@@ -663,20 +783,28 @@ bool HttpServer::Response::send() {
     destroy();
     return true;
   }
-  trace() << LogStream::Color::Green << header();
-  socket_->write(header());
-  if (!content_.empty()) socket_->write(content_);
+  const std::string _h = header();
+  trace() << LogStream::Color::Green << _h;
+  DataChain _c;
+  _c.append(std::string_view(_h));
+  _c.append(content_);
+  socket_->write(_c);
   destroy();
   return true;
 }
 
 void HttpServer::Response::setContent(const DataArray &ba) {
-  content_ = ba;
+  content_ = DataChain(SharedDataArray(DataArrayView(ba)));
   contentLength = ba.size();
 }
 
 void HttpServer::Response::setContent(const std::vector<uint8_t> &v) {
-  content_ = DataArray(v.begin(), v.end());
+  content_ = DataChain(SharedDataArray(DataArray(v.begin(), v.end())));
+  contentLength = content_.size();
+}
+
+void HttpServer::Response::setContent(const DataChain &c) {
+  content_ = c.detached();
   contentLength = content_.size();
 }
 
@@ -706,16 +834,8 @@ std::string HttpServer::Request::methodName() const { return private_.request.me
 std::string HttpServer::Request::path() const { return private_.uri->path; }
 
 std::string HttpServer::Request::heaaderItemValue(const std::string &name) const {
-  for (const httpparser::Request::HeaderItem &item : private_.request.headers) {
-    if (name.size() == item.name.size()) {
-      for (size_t i = 0; i != name.size(); ++i) {
-        if (std::tolower(name[i]) != std::tolower(item.name[i])) goto FAIL;
-      }
-      return item.value;
-    FAIL:
-      continue;
-    }
-  }
+  for (const httpparser::Request::HeaderItem &item : private_.request.headers)
+    if (name.size() == item.name.size() && DataArrayView(std::string_view(item.name)).indexOfIgnoreCase(name) == 0) return item.value;
   return "";
 }
 
@@ -742,7 +862,9 @@ bool HttpServer::Request::fail() const { return private_.res != httpparser::Http
 
 namespace AsyncFw {
 LogStream &operator<<(LogStream &log, const HttpServer &s) {
-  std::string str = "Listening: " + ((s.private_.listener.port()) ? s.private_.listener.address() + ':' + std::to_string(s.private_.listener.port()) : "no");
+  const ListenSocket &_l = (s.private_.workers.empty()) ? s.private_.listener : *s.private_.workers.front().listener;
+  std::string str = "Listening: " + ((_l.port()) ? _l.address() + ':' + std::to_string(_l.port()) : "no");
+  if (!s.private_.workers.empty()) str += " (" + std::to_string(s.private_.workers.size()) + " workers" + ((s.private_.cpuSteering) ? ", cpu steering)" : ")");
   str += std::string("\nSSL: ") + ((!s.private_.tlsContext.empty()) ? "enabled" : "disabled");
   str += "\nWeb root: " + ((!s.private_.httpPath.empty()) ? s.private_.httpPath : "none");
 
@@ -13,6 +13,7 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #include <memory>
 
 #include "../core/TlsContext.h"
+#include "../core/DataChain.h"
 #include "HttpSocket.h"
 #include "Instance.h"
 
@@ -135,6 +136,8 @@ public:
     void setContent(const AsyncFw::DataArray &);
     /** @brief Sets the payload content from a byte vector. */
     void setContent(const std::vector<uint8_t> &);
+    /** @brief Sets the payload content from a chain of segments, sent after the header with one write without concatenating them. Borrowed segments are copied (DataChain::detached()). */
+    void setContent(const AsyncFw::DataChain &);
     /** @brief Assigns the HTTP status code for this response. */
     void setStatusCode(const StatusCode &_statusCode) { statusCode_ = _statusCode; }
     /** @brief Checks if the response delivery is bound to fail due to a disconnected socket. */
@@ -145,7 +148,7 @@ public:
     /** @brief Retrieves the currently assigned HTTP status code. */
     Response::StatusCode statusCode() { return statusCode_; }
     /** @brief Retrieves the current response payload body. */
-    AsyncFw::DataArray content() { return content_; }
+    AsyncFw::DataArray content() { return content_.flatten(); }
     /** @brief Returns the underlying socket through which this response is transmitted. */
     TcpSocket *socket() { return socket_; }
 
@@ -154,7 +157,7 @@ public:
     mutable StatusCode statusCode_ = Response::StatusCode::Ok;
     mutable int contentLength = 0;
     mutable std::string mimeType_;
-    AsyncFw::DataArray content_;
+    AsyncFw::DataChain content_;
 
     std::string version = "1.1";
     bool cors_headers_enabled = false;
@@ -264,6 +267,7 @@ public:
   int sendToWebSockets(const T &_data, const AsyncFw::DataArray &_da) {
     AsyncFw::DataArray _f;
     int _r = 0;
+    std::lock_guard<std::mutex> lock(socketsMutex);
     for (TcpSocket *socket : sockets) {
       if (!socket->ws_) continue;
       if (socket->data_.has_value() && _data == std::any_cast<T>(socket->data_)) {
@@ -271,7 +275,7 @@ public:
           int _s = makeWebSocketFrame(_da, &_f);
           if (_s <= 0) return -1;
         }
-        socket->write(_f);
+        writeSocket(socket, _f);
         ++_r;
       }
     }
@@ -287,6 +291,7 @@ public:
   /** @brief Explicitly severs connections with active sockets holding custom user metadata matching data. @tparam T Type identifier matching the socket data context block. @param _data Target match signature identifying channels to be dropped. */
   template <typename T>
   void clearConnections(const T &data) {
+    std::lock_guard<std::mutex> lock(socketsMutex);
     for (TcpSocket *socket : sockets) {
       if (socket->data_.has_value() && data == std::any_cast<T>(socket->data_)) disconnectFromHost(socket);
     }
@@ -299,9 +304,20 @@ public:
   void sendToWebSockets(const std::string &);
   /** @brief Disconnects a specific client socket and clears it from the internally managed pool. */
   void disconnectFromHost(TcpSocket *socket);
-  /** @brief Binds to all available interfaces (0.0.0.0) and starts listening for incoming traffic on a specific TCP port. */
-  bool listen(uint16_t port);
-  /** @brief Stops the server listener immediately, preventing any new connections from being accepted. */
+  /** @brief Binds to all available interfaces (0.0.0.0) and starts listening for incoming traffic on a specific TCP port.
+  @param port TCP port. @param workers Number of worker threads. Each worker owns its own SO_REUSEPORT listener and serves the connections it accepts, so route handlers run in the worker threads. Zero accepts and serves in the current thread. @param backlog Maximum length of the queue of pending connections. */
+  bool listen(uint16_t port, int workers = 0, int backlog = SOCKET_CONNECTION_QUEUED);
+  /** @brief Steers connections between the workers by the CPU that received them (SO_ATTACH_REUSEPORT_CBPF). @note Takes effect on the next listen() with workers. */
+  void setCpuSteering(bool);
+  /** @brief Sets the tuning profile of the listening sockets and of every accepted connection. @param options Socket options. @note Takes effect on the next listen(). */
+  void setSocketOptions(const SocketOptions &);
+  /** @brief Samples the kernel TCP state of the connections periodically, batched per serving thread (see Thread::setTcpInfoInterval()). @param ms Interval in milliseconds, zero stops sampling. */
+  void setTcpInfoInterval(int);
+  /** @brief Aggregates the last TCP_INFO samples of the connections. @return Summary. */
+  TcpInfoSummary tcpInfoSummary();
+  /** @brief Returns the buffer memory accounted by the connections in the BufferBudget, in bytes. */
+  int64_t bufferUsage();
+  /** @brief Stops the server listener immediately, preventing any new connections from being accepted. @note With workers, the worker threads are stopped and their connections closed, so listen() can be called again. */
   void close();
   /** @brief Returns the local TCP port number the server listener is actively bound to. */
   uint16_t port();
@@ -315,7 +331,7 @@ public:
   /** @brief Accessor to fetch the globally managed singleton instance reference of the active HttpServer. */
   static inline HttpServer *instance() { return instance_.value; }
   /** @brief Signal connector emitted whenever a fresh client socket establishes a network link. */
-  AsyncFw::FunctionConnector<int, const std::string &, bool *>::Policy<AsyncFw::AbstractFunctionConnector::SyncOnly>::Protected<HttpServer> incoming;
+  AsyncFw::FunctionConnector<int, const sockaddr_storage *, bool *>::Policy<AsyncFw::AbstractFunctionConnector::SyncOnly>::Protected<HttpServer> incoming;
   /** @brief Signal connector emitted when incoming validated WebSocket framed blocks are assembled for read operations. */
   AsyncFw::FunctionConnector<const HttpSocket *, const DataArray &>::Protected<HttpServer> webSocketReceived;
 
@@ -332,8 +348,12 @@ private:
     HttpServer::rules.emplace(url, std::make_unique<HttpRule>(HttpServer::HttpRule(method, exec)));
   }
   void received(TcpSocket *, const std::string_view &);
+  void incomingConnection(int, const sockaddr_storage *, bool *);
+  void stopWorkers();
+  bool writeSocket(TcpSocket *, const DataArray &);
   RulesMap::iterator findRule(const std::string &, const Request::Method);
   std::vector<TcpSocket *> sockets;
+  std::mutex socketsMutex;
   bool cors_request_enabled = true;
   static Instance<HttpServer> instance_;
   Invocable<bool(const Request &, std::any)>::Abstract *peek = nullptr;
@@ -6,6 +6,11 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 */
 
 #include <algorithm>
+#include <fstream>
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
 #include "core/Thread.h"
 #include "core/LogStream.h"
 #include "HttpSocket.h"
@@ -17,6 +22,10 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 #define SOCKET_WRITE_SIZE 8192
 
+#ifndef HTTP_SOCKET_SENDFILE_SIZE
+  #define HTTP_SOCKET_SENDFILE_SIZE (1024 * 1024)
+#endif
+
 using namespace AsyncFw;
 
 HttpSocket *HttpSocket::create(AsyncFw::Thread *_t) {
@@ -30,6 +39,9 @@ HttpSocket::HttpSocket() : AbstractTlsSocket() { lsTrace(); }
 
 HttpSocket::~HttpSocket() {
   if (tid_ != -1) thread_->removeTimer(tid_);
+#ifndef _WIN32
+  if (fileFd_ >= 0) ::close(fileFd_);
+#endif
   lsTrace();
 }
 
@@ -67,18 +79,20 @@ void HttpSocket::readEvent() {
       thread_->removeTimer(tid_);
       tid_ = -1;
     }
-    std::size_t i = _da.view().find("\r\n\r\n");
-    if (i == std::string::npos) return;
+    std::size_t i = _da.view().indexOf("\r\n\r\n", (searched_ < _da.size()) ? searched_ : 0);
+    if (i == std::string::npos) {
+      searched_ = (_da.size() > 3) ? _da.size() - 3 : 0;
+      return;
+    }
+    searched_ = 0;
     headerSize_ = i;
 
     received_ += read(headerSize_ + 4);
 
     std::size_t j;
-    std::string _lc;
-    _lc.resize(received_.size());
-    std::transform(received_.begin(), received_.begin() + received_.size(), _lc.begin(), [](unsigned char c) { return std::tolower(c); });
-    if ((i = _lc.find("content-length:")) != std::string::npos) {
-      if ((j = received_.view().find("\r\n", i + 15)) != std::string::npos) {
+    const DataArrayView _header = received_.view();
+    if ((i = _header.indexOfIgnoreCase("content-length:")) != std::string::npos) {
+      if ((j = _header.indexOf("\r\n", i + 15)) != std::string::npos) {
         std::string str(received_.begin() + i + 15, received_.begin() + j);
         contentLenght_ = std::stoi(str);
       }
@@ -92,8 +106,8 @@ void HttpSocket::readEvent() {
         disconnect();
         return;
       }
-    } else if ((i = _lc.find("transfer-encoding:")) != std::string::npos) {
-      if ((j = received_.view().find("\r\n", i + 18)) != std::string::npos) {
+    } else if ((i = _header.indexOfIgnoreCase("transfer-encoding:")) != std::string::npos) {
+      if ((j = _header.indexOf("\r\n", i + 18)) != std::string::npos) {
         std::string str(received_.begin() + i + 18, received_.begin() + j);
         if (str.find("chunked") == std::string::npos) {
           lsError("error http read");
@@ -123,7 +137,7 @@ void HttpSocket::readEvent() {
   }
 
   for (;;) {
-    std::size_t _s = _da.view().find("\r\n");
+    std::size_t _s = _da.view().indexOf("\r\n");
     if (_s == std::string::npos) return;
     std::string str(_da.begin(), _da.begin() + _s);
 
@@ -153,6 +167,31 @@ void HttpSocket::writeEvent() {
   if (full_) clearReceived();
   if (pendingWrite() >= SOCKET_WRITE_SIZE) return;
   if (file_.isOpen()) {
+#ifndef _WIN32
+    if (fileFd_ >= 0) {
+      const int64_t _s = file_.size();
+      int r = 0;
+      for (int _n = 0; fileOffset_ < _s && r == _n;) {
+        _n = static_cast<int>(std::min<int64_t>(_s - fileOffset_, HTTP_SOCKET_SENDFILE_SIZE));
+        if ((r = AbstractSocket::sendFile(fileFd_, fileOffset_, _n)) < 0) break;
+        fileOffset_ += r;
+      }
+      if (r >= 0) {
+        const int p = (_s > 0) ? fileOffset_ * 100 / _s : 100;
+        if (progress_ != p) progress(progress_ = p);
+        if (fileOffset_ < _s) return;
+        ::close(fileFd_);
+        fileFd_ = -1;
+        file_.close();
+        if (connectionClose) disconnect();
+        return;
+      }
+      // sendfile() is not available for the socket (userspace TLS or rate limit), continue with the stream
+      ::close(fileFd_);
+      fileFd_ = -1;
+      file_.fstream().seekg(fileOffset_);
+    }
+#endif
     DataArray da = file_.read(SOCKET_WRITE_SIZE);
     if (!da.empty()) write(da);
     std::streamsize _p = file_.tellg();
@@ -188,6 +227,7 @@ DataArrayView HttpSocket::content() { return received_.view(headerSize_ + 4); }
 
 void HttpSocket::clearReceived() {
   received_.clear();
+  searched_ = 0;
   full_ = false;
   lsTrace();
 }
@@ -204,6 +244,11 @@ void HttpSocket::sendFile(const std::string &fn) {
   }
   progress(0);
   progress_ = 0;
+#ifndef _WIN32
+  if (fileFd_ >= 0) ::close(fileFd_);
+  fileFd_ = ::open(fn.c_str(), O_RDONLY | O_CLOEXEC);
+  fileOffset_ = 0;
+#endif
   writeEvent();
 }
 
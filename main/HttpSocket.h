@@ -51,8 +51,11 @@ protected:
 private:
   DataArray received_;
   File file_;
+  int fileFd_ = -1;  // descriptor of file_ for sendFile(), -1 after a fallback to reading the stream
+  int64_t fileOffset_ = 0;
   int progress_;
   int headerSize_;
+  std::size_t searched_ = 0;  // bytes of the read buffer already searched for the end of the header
   std::size_t contentLenght_ = std::string::npos;
   int tid_ = -1;
   bool full_ = false;
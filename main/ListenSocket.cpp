@@ -7,12 +7,16 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 
 #ifndef _WIN32
   #include <arpa/inet.h>
+  #include <linux/filter.h>
+  #include <netinet/tcp.h>
   #include <unistd.h>
   #define close_fd ::close
+  #define setsockopt_ptr
 #else
   #include <winsock2.h>
   #include <ws2tcpip.h>
   #define close_fd ::closesocket
+  #define setsockopt_ptr reinterpret_cast<const char *>
 #endif
 
 #include "core/AbstractSocket.h"
@@ -20,6 +24,10 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 #include "core/Thread.h"
 #include "ListenSocket.h"
 
+#if !defined LS_NO_ERROR
+  #define AsyncFw_THREAD thread_
+#endif
+
 #ifdef EXTEND_SOCKET_TRACE
   #define ENABLE_EXTEND_TRACE
 #endif
@@ -29,36 +37,67 @@ using namespace AsyncFw;
 
 void ListenSocket::incomingEvent() {
   sockaddr_storage _a;
-  socklen_t _l = sizeof _a;
   for (;;) {
+    socklen_t _l = sizeof _a;
+#ifndef _WIN32
+    int _cd = accept4(fd_, (struct sockaddr *)&_a, &_l, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
     int _cd = accept(fd_, (struct sockaddr *)&_a, &_l);
+#endif
     trace() << _cd;
     if (_cd < 0) {
+#ifndef _WIN32
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno != EAGAIN) lsError() << "accept error" << errno;
+#endif
       trace() << LogStream::Color::Red << "(_cd < 0)";
       return;
     }
-    std::string _pa;
-    if (_a.ss_family == AF_INET) {
-      char _ip[INET_ADDRSTRLEN];
-      inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(&_a)->sin_addr, _ip, sizeof _ip);
-      _pa = _ip;
-    } else {
-      char _ip[INET6_ADDRSTRLEN];
-      inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6 *>(&_a)->sin6_addr, _ip, sizeof _ip);
-      _pa = _ip;
-    }
     bool _accept = false;
-    incoming(_cd, _pa, &_accept);
+    incoming(_cd, &_a, &_accept);
     if (!_accept) {
       lsDebug() << LogStream::Color::Red << "failed incoming connection" << _cd;
       close_fd(_cd);
       continue;
     }
-    trace() << LogStream::Color::Red << _cd << LogStream::Color::Green << _pa;
+    trace() << LogStream::Color::Red << _cd << LogStream::Color::Green << addressString(&_a);
   }
   trace() << "end";
 }
 
+void ListenSocket::bindEvent(int _fd) {
+#ifndef _WIN32
+  int _val = 1;
+  if (reusePort_ && setsockopt(_fd, SOL_SOCKET, SO_REUSEPORT, &_val, sizeof _val) < 0) lsError("set SO_REUSEPORT");
+  if (deferAccept_ > 0 && setsockopt(_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &deferAccept_, sizeof deferAccept_) < 0) lsError("set TCP_DEFER_ACCEPT");
+#endif
+#ifdef TCP_FASTOPEN
+  if (fastOpen_ > 0 && setsockopt(_fd, IPPROTO_TCP, TCP_FASTOPEN, setsockopt_ptr(&fastOpen_), sizeof fastOpen_) < 0) lsError("set TCP_FASTOPEN");
+#endif
+}
+
+void ListenSocket::setReusePort(bool b) { reusePort_ = b; }
+
+void ListenSocket::setDeferAccept(int seconds) { deferAccept_ = seconds; }
+
+void ListenSocket::setFastOpen(int queue) { fastOpen_ = queue; }
+
+bool ListenSocket::setCpuSteering(int group) {
+  checkCurrentThread();
+#ifndef _WIN32
+  if (fd_ < 0 || group <= 0) return false;
+  sock_filter _code[] = {{BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)}, {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(group)}, {BPF_RET | BPF_A, 0, 0, 0}};
+  sock_fprog _p = {sizeof _code / sizeof _code[0], _code};
+  if (setsockopt(fd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &_p, sizeof _p) == 0) return true;
+  lsError() << "set SO_ATTACH_REUSEPORT_CBPF" << errno;
+#endif
+  return false;
+}
+
+ListenSocket::ListenSocket() {}
+
+ListenSocket::ListenSocket(int family, int type, int protocol) : AbstractSocket(family, type, protocol) {}
+
 ListenSocket::~ListenSocket() {
   lsTrace();
   if (state_ == Destroy || fd_ == -1) return;
@@ -19,18 +19,40 @@ namespace AsyncFw {
 class ListenSocket : private AbstractSocket {
 public:
   using AbstractSocket::address;
+  using AbstractSocket::addressString;
   using AbstractSocket::close;
   using AbstractSocket::destroy;
   using AbstractSocket::listen;
   using AbstractSocket::port;
+  using AbstractSocket::setOptions;
+  using AbstractSocket::thread;
+  ListenSocket();
+  /** @brief Constructs a listen socket of the given type, e.g. (AF_UNIX, SOCK_SEQPACKET, 0). @details The address family follows the address passed to listen(). @param family Address family. @param type Socket type. @param protocol Protocol. */
+  ListenSocket(int, int, int);
   ~ListenSocket();
+  /** @brief Returns true if the socket is listening. */
+  bool listening() const { return state_ == Listening; }
+  /** @brief Enables SO_REUSEPORT, allowing several listeners (typically one per thread) to share the same address and port. @note Must be called before listen(). */
+  void setReusePort(bool);
+  /** @brief Enables TCP_DEFER_ACCEPT: a connection is accepted only after the client has sent data. @param seconds Maximum time to wait for the data, zero disables. @note Linux only. Must be called before listen(). */
+  void setDeferAccept(int);
+  /** @brief Enables server-side TCP Fast Open, allowing data in the SYN of repeat clients. @param queue Maximum length of the pending Fast Open requests queue, zero disables. @note Must be called before listen(). */
+  void setFastOpen(int);
+  /** @brief Steers connections of the SO_REUSEPORT group by the receiving CPU: the connection goes to the listener that joined the group with index CPU % group. @param group Number of listeners in the group. @return True if the steering program is attached. @note The program applies to the whole group. Must be called from the socket thread after all listeners of the group are listening. */
+  bool setCpuSteering(int);
   /** @brief The FunctionConnector for incoming connections. */
   /** @brief Synchronous signal connector emitted immediately upon a new incoming connection.
-  @details Slots subscribing to this connector must accept: @n - int: The newly created raw socket file descriptor for the incoming client. @n - const std::string &: The remote client's IPv4/IPv6 address string. @n - bool *: An out-parameter flag pointer to signal back if the connection should be accepted or rejected. */
-  AsyncFw::FunctionConnector<int, const std::string &, bool *>::Policy<AsyncFw::AbstractFunctionConnector::SyncOnly>::Protected<ListenSocket> incoming;
+  @details Slots subscribing to this connector must accept: @n - int: The newly created non-blocking raw socket file descriptor for the incoming client. @n - const sockaddr_storage *: The remote client's native address, AbstractSocket::addressString() converts it to a string. @n - bool *: An out-parameter flag pointer to signal back if the connection should be accepted or rejected. */
+  AsyncFw::FunctionConnector<int, const sockaddr_storage *, bool *>::Policy<AsyncFw::AbstractFunctionConnector::SyncOnly>::Protected<ListenSocket> incoming;
 
 protected:
   void incomingEvent() override;
+  void bindEvent(int) override;
+
+private:
+  int deferAccept_ = 0;
+  int fastOpen_ = 0;
+  bool reusePort_ = false;
 };
 
 }  // namespace AsyncFw
@@ -168,7 +168,7 @@ bool Rrd::readFromFile() {
   _f.close();
 
 #ifdef Rrd_COMPRESS_FILE
-  _buf = DataArray::uncompress(_buf);
+  _buf = DataArray::uncompress(_buf, compressThreads_);
 #endif
 
   if (!_buf.empty()) {
@@ -201,7 +201,7 @@ bool Rrd::saveToFile(const std::string &_fileToSave) {
   _ds << dataBase;
 
 #ifdef Rrd_COMPRESS_FILE
-  DataArray _buf = DataArray::compress(_ds.array());
+  DataArray _buf = (compressThreads_.empty()) ? DataArray::compress(_ds.array(), codec_, level_) : DataArray::compress(_ds.array(), codec_, level_, compressThreads_);
   if (_buf.empty()) return false;
 #else
   #define _buf _ds.array()
@@ -28,6 +28,14 @@ public:
     aInterval = interval / interval_;
     aOffset = offset;
   }
+  /** @brief Sets the compression of the saved file, see DataArray::Codec. Zlib by default, which any version can read.
+  @param codec The codec. @param level The codec level, -1 selects its default. @param threads Threads compressing and uncompressing the file in blocks together with the Rrd thread, for example from ThreadPool::getThreads(). Without threads the file is compressed as a whole.
+  @warning The threads must outlive the Rrd, it saves the file when destroyed. */
+  void setCompression(uint8_t codec, int level = -1, const std::vector<AbstractThread *> &threads = {}) {
+    codec_ = codec;
+    level_ = level;
+    compressThreads_ = threads;
+  }
   /** @brief Constructs a persistent circular archive database with physical disk backing. @param size Total number of data allocation slots (capacity) in the ring buffer. @param interval Data collection rate and timeline step resolution in milliseconds. @param fillInterval Maximum allowed time window in milliseconds to auto-fill missed historical data gaps. @param name Path to a file in the local file system used to save data. */
   Rrd(int, int, int, const std::string &);
   /** @brief Constructs an in-memory anonymous circular database without file serialization. @param size Total number of data allocation slots (capacity) in the ring buffer. @param interval Data collection rate and timeline step resolution in milliseconds. @param fillInterval Maximum allowed time window in milliseconds to auto-fill missed historical data gaps. */
@@ -83,6 +91,9 @@ private:
   int interval_;
   uint32_t fill;
   std::string file;
+  std::vector<AbstractThread *> compressThreads_;
+  uint8_t codec_ = DataArray::Zlib;
+  int level_ = -1;
   bool createFile();
   bool readFromFile();
   bool saveToFile(const std::string &fn = {});
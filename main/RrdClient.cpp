@@ -74,7 +74,7 @@ void RrdClient::tcpRead(const DataArray *rda, uint32_t n) {
   }
   DataStream _ds(_da);
   uint64_t val;
-  DataArrayList list;
+  std::vector<DataArrayView> list;
   uint64_t dbLastTime;
   _ds >> val;
   _ds >> list;
@@ -93,7 +93,7 @@ void RrdClient::tcpRead(const DataArray *rda, uint32_t n) {
     return;
   }
   if (list.size() > 0) {
-    for (std::size_t i = 0; i != list.size(); ++i) rrd_[n]->append(list[i], val - list.size() + i + 1);
+    for (std::size_t i = 0; i != list.size(); ++i) rrd_[n]->append(Rrd::Item(reinterpret_cast<const uint8_t *>(list[i].data()), reinterpret_cast<const uint8_t *>(list[i].data()) + list[i].size()), val - list.size() + i + 1);
 
     lastTime[n] = val;
     if (val != dbLastTime) {
@@ -44,8 +44,8 @@ void RrdServer::transmit(const DataArraySocket *socket, uint64_t index, uint32_t
   _ds << _list;
   _ds << lastIndex;
 
-  DataArray _da = DataArray::compress(_ds.array());
+  DataArray _da = DataArray::compress(_ds.array(), codec_, level_);
 
   trace() << index << i << lastIndex << _list.size() << LogStream::Color::Red << pi;
-  tcpServer->transmit(socket, _da, pi);
+  tcpServer->transmit(socket, SharedDataArray(std::move(_da)), pi);
 }
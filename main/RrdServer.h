@@ -10,6 +10,7 @@ See {Link: LICENSE file https://mit-license.org} in the project root for full li
 /** @file RrdServer.h @brief The RrdServer class. */
 
 #include "../core/FunctionConnector.h"
+#include "../core/DataArray.h"
 
 namespace AsyncFw {
 class DataArraySocket;
@@ -26,6 +27,11 @@ public:
   virtual ~RrdServer();
   /** @brief Explicitly stops the server component and disconnects from the underlying TCP server events. */
   void quit();
+  /** @brief Sets the codec and level of transmitted slices, see DataArray::Codec. Zlib by default, which any client can read. */
+  void setCodec(uint8_t codec, int level = -1) {
+    codec_ = codec;
+    level_ = level;
+  }
 
 protected:
   /** @brief Extracts a specific historical data slice from an Rrd archive and transmits it to a client socket.
@@ -38,5 +44,7 @@ protected:
 private:
   std::vector<Rrd *> rrd_; /* The internal collection of exposed metrics or logging circular databases. */
   FunctionConnectionGuard g_;
+  uint8_t codec_ = DataArray::Zlib;
+  int level_ = -1;
 };
 }  // namespace AsyncFw
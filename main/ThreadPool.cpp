@@ -172,3 +172,15 @@ AbstractThreadPool::Thread *ThreadPool::getThread() {
   }, true);
   return _t;
 }
+
+std::vector<AbstractThread *> ThreadPool::getThreads(int n) {
+  std::vector<AbstractThread *> _threads;
+  thread_->invoke([this, n, &_threads]() {
+    while (static_cast<int>(workThreads_.size()) < std::min(n, workThreadsSize_)) workThreads_.emplace_back(createThread("Work-" + std::to_string(workThreads_.size())));
+    std::vector<std::pair<int, AbstractThread *>> _t;
+    for (AbstractThreadPool::Thread *_thread : workThreads_) _t.emplace_back(_thread->workLoad(), _thread);
+    std::stable_sort(_t.begin(), _t.end(), [](const std::pair<int, AbstractThread *> &t1, const std::pair<int, AbstractThread *> &t2) { return t1.first < t2.first; });
+    for (int i = 0; i != n && i != static_cast<int>(_t.size()); ++i) _threads.push_back(_t[i].second);
+  }, true);
+  return _threads;
+}
@@ -112,6 +112,8 @@ public:
 
   /** @brief Selects and returns the least loaded thread from the pool for task distribution. */
   AbstractThreadPool::Thread *getThread();
+  /** @brief Returns up to the given number of distinct work threads, the least loaded first, creating them within the pool limit. */
+  std::vector<AbstractThread *> getThreads(int);
 
 private:
   static Instance<ThreadPool> instance_;